@@ -22,56 +22,175 @@ const std::string Archive::BLOCK("b");
 const std::string Archive::TRANSACTION("t");
 const std::string Archive::CHECKPOINT("c");
 
+static const size_t MAX_QUEUE_SIZE      = 10000;
+static const size_t MAX_QUEUE_DATA_SIZE = 64 * 1024 * 1024;
+static const size_t MAX_UNCOMMITTED     = 1000;  // records, we also commit on BlockChain commit
+
 Archive::Archive(bool read_only, const std::string &path) : m_read_only(read_only) {
 #if !platform_USE_SQLITE
-	try {
-		m_db = std::make_unique<DB>(read_only ? platform::O_READ_EXISTING : platform::O_OPEN_ALWAYS, path);
-		if (!m_db->get("$unique_id", m_unique_id)) {
-			DB::Cursor cur = m_db->begin(std::string{});
-			if (!cur.end())
-				throw std::runtime_error("Archive database format unknown version, please delete " + m_db->get_path());
-			m_unique_id = common::pod_to_hex(crypto::rand<crypto::Hash>());
-			m_db->put("$unique_id", m_unique_id, true);
-			std::cout << "Created archive with unique id: " << m_unique_id << std::endl;
-		}
-		DB::Cursor cur2  = m_db->rbegin(RECORDS_PREFIX);
-		m_next_record_id = cur2.end() ? 0 : 1 + common::read_varint_sqlite4(cur2.get_suffix());
-	} catch (const std::exception &) {
-		if (read_only)
+	if (read_only) {
+		try {
+			open_db(path);
+		} catch (const std::exception &) {
 			m_db = nullptr;
-		else
-			throw;
+		}
+		return;
+	}
+	std::unique_lock<std::mutex> lock(m_mu);
+	m_thread = std::thread(&Archive::thread_run, this, path);
+	while (!m_thread_started)
+		m_have_result.wait(lock);
+	if (m_open_error) {
+		lock.unlock();
+		m_thread.join();
+		std::rethrow_exception(m_open_error);
 	}
 #endif
-	//	commit_timer.once(DB_COMMIT_PERIOD);
+}
+
+Archive::~Archive() {
+	if (!m_thread.joinable())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(m_mu);
+		m_quit = true;
+		m_have_work.notify_all();
+	}
+	m_thread.join();  // writes the rest of queue
+}
+
+void Archive::open_db(const std::string &path) {
+	m_db = std::make_unique<DB>(m_read_only ? platform::O_READ_EXISTING : platform::O_OPEN_ALWAYS, path);
+	if (!m_db->get("$unique_id", m_unique_id)) {
+		DB::Cursor cur = m_db->begin(std::string{});
+		if (!cur.end())
+			throw std::runtime_error("Archive database format unknown version, please delete " + m_db->get_path());
+		m_unique_id = common::pod_to_hex(crypto::rand<crypto::Hash>());
+		m_db->put("$unique_id", m_unique_id, true);
+		std::cout << "Created archive with unique id: " << m_unique_id << std::endl;
+	}
+	DB::Cursor cur2  = m_db->rbegin(RECORDS_PREFIX);
+	m_next_record_id = cur2.end() ? 0 : 1 + common::read_varint_sqlite4(cur2.get_suffix());
+}
+
+void Archive::thread_run(const std::string &path) {
+	try {
+		open_db(path);
+	} catch (const std::exception &) {
+		std::unique_lock<std::mutex> lock(m_mu);
+		m_open_error     = std::current_exception();
+		m_thread_started = true;
+		m_have_result.notify_all();
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> lock(m_mu);
+		m_thread_started = true;
+		m_have_result.notify_all();
+	}
+	size_t uncommitted = 0;
+	while (true) {
+		std::deque<Item> items;
+		std::deque<ReadTask *> read_tasks;
+		bool commit = false;
+		bool quit   = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mu);
+			while (!m_quit && m_queue.empty() && m_read_tasks.empty() && !m_commit_requested)
+				m_have_work.wait(lock);
+			items.swap(m_queue);
+			read_tasks.swap(m_read_tasks);
+			m_queue_data_size  = 0;
+			commit             = m_commit_requested;
+			quit               = m_quit;
+			m_commit_requested = false;
+		}
+		size_t written = 0;
+		try {
+			for (const auto &item : items) {
+				write_item(item);
+				written += 1;
+				uncommitted += 1;
+			}
+			// Reads are served from committed data
+			if (uncommitted != 0 && (commit || quit || !read_tasks.empty() || uncommitted >= MAX_UNCOMMITTED)) {
+				m_db->commit_db_txn();
+				uncommitted = 0;
+			}
+		} catch (const std::exception &ex) {
+			std::cout << "Archive write failed, archive disabled until restart, what=" << common::what(ex)
+			          << std::endl;
+			std::unique_lock<std::mutex> lock(m_mu);
+			m_write_failed = true;
+			// Items in DB transaction are lost together with it, whether write or commit failed
+			m_dropped_count += uncommitted + items.size() - written;
+			uncommitted = 0;
+		}
+		for (auto task : read_tasks) {
+			try {
+				read_records(std::move(task->req), *task->resp);
+			} catch (const std::exception &) {
+				task->error = std::current_exception();
+			}
+			std::unique_lock<std::mutex> lock(m_mu);
+			task->done = true;
+			m_have_result.notify_all();
+		}
+		if (quit)
+			return;
+	}
 }
 
 void Archive::add(const std::string &type,
     const BinaryArray &data,
     const Hash &hash,
     const std::string &source_address) {
-	if (!m_db || m_read_only || source_address.empty())
+	if (m_read_only || !m_thread.joinable() || source_address.empty())
 		return;
-	auto hash_key = HASHES_PREFIX + DB::to_binary_key(hash.data, sizeof(hash.data));
+	Item item;
+	item.record.timestamp      = now_unix_timestamp(&item.record.timestamp_usec);
+	item.record.type           = type;
+	item.record.hash           = hash;
+	item.record.source_address = source_address;
+	std::unique_lock<std::mutex> lock(m_mu);
+	if (m_write_failed || m_queue.size() >= MAX_QUEUE_SIZE || m_queue_data_size + data.size() > MAX_QUEUE_DATA_SIZE) {
+		m_dropped_count += 1;
+		return;
+	}
+	item.data = data;
+	m_queue_data_size += data.size();
+	m_queue.push_back(std::move(item));
+	m_have_work.notify_all();
+}
+
+void Archive::write_item(const Item &item) {
+	auto hash_key = HASHES_PREFIX + DB::to_binary_key(item.record.hash.data, sizeof(item.record.hash.data));
 	DB::Value value;
 	if (!m_db->get(hash_key, value)) {
 		//		std::cout << "Adding to archive: " << type << " hash=" << hash << " size=" << data.size()
 		//				  << " source_address=" << source_address << std::endl;
-		m_db->put(hash_key, data, true);
+		m_db->put(hash_key, item.data, true);
 	}
-	api::cnd::GetArchive::ArchiveRecord rec;
-	rec.timestamp      = now_unix_timestamp(&rec.timestamp_usec);
-	rec.type           = type;
-	rec.hash           = hash;
-	rec.source_address = source_address;
-	m_db->put(RECORDS_PREFIX + common::write_varint_sqlite4(m_next_record_id), seria::to_binary(rec), true);
+	m_db->put(RECORDS_PREFIX + common::write_varint_sqlite4(m_next_record_id), seria::to_binary(item.record), true);
 	m_next_record_id += 1;
 }
 
 void Archive::db_commit() {
-	if (!m_db || m_read_only)
+	if (!m_thread.joinable())
 		return;
-	m_db->commit_db_txn();
+	std::unique_lock<std::mutex> lock(m_mu);
+	m_commit_requested = true;
+	m_have_work.notify_all();
+}
+
+size_t Archive::get_queue_size() const {
+	std::unique_lock<std::mutex> lock(m_mu);
+	return m_queue.size();
+}
+
+size_t Archive::get_dropped_count() const {
+	std::unique_lock<std::mutex> lock(m_mu);
+	return m_dropped_count;
 }
 
 void Archive::read_archive(api::cnd::GetArchive::Request &&req, api::cnd::GetArchive::Response &resp) {
@@ -80,6 +199,23 @@ void Archive::read_archive(api::cnd::GetArchive::Request &&req, api::cnd::GetArc
 		    api::cnd::GetArchive::ARCHIVE_NOT_ENABLED, "Archive was never enabled on this node", m_unique_id);
 	if (req.archive_id != m_unique_id)
 		throw api::cnd::GetArchive::Error(api::cnd::GetArchive::WRONG_ARCHIVE_ID, "Archive id changed", m_unique_id);
+	if (!m_thread.joinable()) {
+		read_records(std::move(req), resp);
+		return;
+	}
+	ReadTask task;
+	task.req  = std::move(req);
+	task.resp = &resp;
+	std::unique_lock<std::mutex> lock(m_mu);
+	m_read_tasks.push_back(&task);
+	m_have_work.notify_all();
+	while (!task.done)
+		m_have_result.wait(lock);
+	if (task.error)
+		std::rethrow_exception(task.error);
+}
+
+void Archive::read_records(api::cnd::GetArchive::Request &&req, api::cnd::GetArchive::Response &resp) {
 	resp.from_record = req.from_record;
 	if (resp.from_record > m_next_record_id)
 		resp.from_record = m_next_record_id;
@@ -3,25 +3,64 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include "platform/DB.hpp"
 #include "rpc_api.hpp"
 
 namespace cn {
 
+// Records are queued by add and written in batches by own thread, which owns m_db (LMDB write
+// transaction is bound to thread). read_archive is also executed by that thread after commit.
+// If writer cannot keep up, records are dropped, so relay is never slowed by archive.
 class Archive {
 	const bool m_read_only;
 	std::unique_ptr<platform::DB> m_db;
 	uint64_t m_next_record_id = 0;
 	std::string m_unique_id;
 
-	//	platform::Timer commit_timer;
+	struct Item {
+		api::cnd::GetArchive::ArchiveRecord record;
+		common::BinaryArray data;
+	};
+	struct ReadTask {
+		api::cnd::GetArchive::Request req;
+		api::cnd::GetArchive::Response *resp = nullptr;
+		std::exception_ptr error;
+		bool done = false;
+	};
+	mutable std::mutex m_mu;
+	std::condition_variable m_have_work;
+	std::condition_variable m_have_result;
+	std::deque<Item> m_queue;
+	size_t m_queue_data_size = 0;
+	std::deque<ReadTask *> m_read_tasks;
+	size_t m_dropped_count  = 0;
+	bool m_commit_requested = false;
+	bool m_quit             = false;
+	bool m_thread_started   = false;
+	bool m_write_failed     = false;
+	std::exception_ptr m_open_error;
+	std::thread m_thread;
+
+	void open_db(const std::string &path);
+	void thread_run(const std::string &path);
+	void write_item(const Item &item);
+	void read_records(api::cnd::GetArchive::Request &&req, api::cnd::GetArchive::Response &resp);
+
 public:
 	explicit Archive(bool read_only, const std::string &path);
+	~Archive();
 	std::string get_unique_id() const { return m_unique_id; }
 	void add(
 	    const std::string &type, const common::BinaryArray &data, const Hash &hash, const std::string &source_address);
 	void read_archive(api::cnd::GetArchive::Request &&req, api::cnd::GetArchive::Response &resp);
-	void db_commit();
+	void db_commit();  // asks writer thread to commit, does not wait
+	size_t get_queue_size() const;
+	size_t get_dropped_count() const;
 
 	static const std::string BLOCK;
 	static const std::string TRANSACTION;
@@ -8,10 +8,14 @@
 #include "CryptoNoteTools.hpp"
 #include "Currency.hpp"
 #include "TransactionExtra.hpp"
+#include "common/Compression.hpp"
 #include "common/Math.hpp"
+#include "common/MemoryStreams.hpp"
+#include "common/Metrics.hpp"
 #include "common/StringTools.hpp"
 #include "common/Varint.hpp"
 #include "crypto/crypto.hpp"
+#include "platform/Files.hpp"
 #include "rpc_api.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
@@ -19,7 +23,7 @@
 using namespace cn;
 using namespace platform;
 
-const std::string BlockChain::version_current = "8";
+const std::string BlockChain::version_current = "9";
 // We increment when making incompatible changes to indexes.
 
 // We use suffixes so all keys related to the same block are close to each other in DB
@@ -33,6 +37,11 @@ static const std::string TIMESTAMP_BLOCK_PREFIX   = "T";
 static const std::string CHECKPOINT_PREFIX_STABLE = "CS";
 static const std::string CHECKPOINT_PREFIX_LATEST = "CL";
 
+// Compressed block is marker, codec, varint size, data. Marker cannot start serialized RawBlock (empty block blob),
+// so blocks stored uncompressed (by previous versions or when compression does not help) are read as is
+static const uint8_t BLOCK_COMPRESSED_MARKER = 0;
+static const uint8_t BLOCK_CODEC_LZ          = 1;  // new codecs (for example, with dictionary) get new ids
+
 static const std::string CHILDREN_PREFIX = "x-ch/";
 static const std::string CD_TIPS_PREFIX  = "x-tips/";
 // We store bid->children counter, with counter=1 default (absent from index)
@@ -51,65 +60,76 @@ Block::Block(const RawBlock &rb) {
 
 PreparedBlock::PreparedBlock(BinaryArray &&ba, const Currency &currency, crypto::CryptoNightContext *context)
     : block_data(std::move(ba)) {
+	const auto start = std::chrono::steady_clock::now();
 	seria::from_binary(raw_block, block_data);
-	prepare(currency, context);
+	prepare(currency, context, start);
 }
 
 PreparedBlock::PreparedBlock(RawBlock &&rba, const Currency &currency, crypto::CryptoNightContext *context)
     : raw_block(rba) {
-	block_data = seria::to_binary(raw_block);
-	prepare(currency, context);
+	const auto start = std::chrono::steady_clock::now();
+	block_data       = seria::to_binary(raw_block);
+	prepare(currency, context, start);
 }
 
-void PreparedBlock::prepare(const Currency &currency, crypto::CryptoNightContext *context) {
-	block = Block{raw_block};
-	invariant(block.transactions.size() == raw_block.transactions.size(), "");
-	base_transaction_hash = get_transaction_hash(block.header.base_transaction);
-	body_proxy            = get_body_proxy_from_template(base_transaction_hash, block.header.transaction_hashes);
-	bid                   = cn::get_block_hash(block.header, body_proxy);
-	if (block.header.is_merge_mined())
-		parent_block_size = seria::binary_size(block.header.root_block);
-	coinbase_tx_size  = seria::binary_size(block.header.base_transaction);
-	block_header_size = seria::binary_size(static_cast<BlockHeader>(block.header));
-	if (block.header.transaction_hashes.size() != raw_block.transactions.size())
-		throw ConsensusError{"Wrong transcation count in block template"};
-	// Transactions are in block
-	for (size_t i = 0; i != block.transactions.size(); ++i) {
-		Hash tid = get_transaction_hash(block.transactions.at(i));
-		if (tid != block.header.transaction_hashes.at(i))
-			throw ConsensusError{"Transaction from block template absent in block"};
-	}
-	if (block.header.is_merge_mined()) {
+void PreparedBlock::check_header(
+    const Currency &currency, const BlockTemplate &header, const BlockBodyProxy &body_proxy) {
+	if (header.is_merge_mined()) {
 		extra::MergeMiningTag mm_tag;
-		if (!extra::get_merge_mining_tag(block.header.root_block.coinbase_transaction.extra, &mm_tag))
+		if (!extra::get_merge_mining_tag(header.root_block.coinbase_transaction.extra, &mm_tag))
 			throw ConsensusError("No merge mining tag");
-		if (mm_tag.depth != block.header.root_block.blockchain_branch.size())
+		if (mm_tag.depth != header.root_block.blockchain_branch.size())
 			throw ConsensusError(common::to_string("Wrong merge mining depth,", mm_tag.depth, " should be ",
-			    block.header.root_block.blockchain_branch.size()));
-		if (block.header.root_block.blockchain_branch.size() > 8 * sizeof(Hash))
+			    header.root_block.blockchain_branch.size()));
+		if (header.root_block.blockchain_branch.size() > 8 * sizeof(Hash))
 			throw ConsensusError(common::to_string("Too big merge mining depth,",
-			    block.header.root_block.blockchain_branch.size(), "should be <=", 8 * sizeof(Hash)));
-		Hash aux_blocks_merkle_root = crypto::tree_hash_from_branch(block.header.root_block.blockchain_branch.data(),
-		    block.header.root_block.blockchain_branch.size(), get_block_header_prehash(block.header, body_proxy),
+			    header.root_block.blockchain_branch.size(), "should be <=", 8 * sizeof(Hash)));
+		Hash aux_blocks_merkle_root = crypto::tree_hash_from_branch(header.root_block.blockchain_branch.data(),
+		    header.root_block.blockchain_branch.size(), get_block_header_prehash(header, body_proxy),
 		    &currency.genesis_block_hash);
 		if (aux_blocks_merkle_root != mm_tag.merkle_root)
 			throw ConsensusError(common::to_string(
 			    "Wrong merge mining merkle root, tag", mm_tag.merkle_root, "actual", aux_blocks_merkle_root));
 	}
 #if bytecoin_ALLOW_CM
-	if (block.header.is_cm_mined()) {
-		if (!crypto::cm_branch_valid(block.header.cm_merkle_branch))
+	if (header.is_cm_mined()) {
+		if (!crypto::cm_branch_valid(header.cm_merkle_branch))
 			throw ConsensusError("CM branch invalid");
 	}
 #endif
-	if (block.header.base_transaction.inputs.size() != 1)
+	if (header.base_transaction.inputs.size() != 1)
 		throw ConsensusError(common::to_string(
-		    "Coinbase transaction input count wrong,", block.header.base_transaction.inputs.size(), "should be 1"));
-	if (block.header.base_transaction.inputs.at(0).type() != typeid(InputCoinbase))
+		    "Coinbase transaction input count wrong,", header.base_transaction.inputs.size(), "should be 1"));
+	if (header.base_transaction.inputs.at(0).type() != typeid(InputCoinbase))
 		throw ConsensusError("Coinbase transaction input type wrong");
+}
+
+void PreparedBlock::prepare(
+    const Currency &currency, crypto::CryptoNightContext *context, std::chrono::steady_clock::time_point start) {
+	block = Block{raw_block};
+	invariant(block.transactions.size() == raw_block.transactions.size(), "");
+	base_transaction_hash = get_transaction_hash(block.header.base_transaction);
+	body_proxy            = get_body_proxy_from_template(base_transaction_hash, block.header.transaction_hashes);
+	bid                   = cn::get_block_hash(block.header, body_proxy);
+	if (block.header.is_merge_mined())
+		parent_block_size = seria::binary_size(block.header.root_block);
+	coinbase_tx_size  = seria::binary_size(block.header.base_transaction);
+	block_header_size = seria::binary_size(static_cast<BlockHeader>(block.header));
+	if (block.header.transaction_hashes.size() != raw_block.transactions.size())
+		throw ConsensusError{"Wrong transcation count in block template"};
+	// Transactions are in block
+	const std::vector<Hash> tids = get_transaction_hashes(block.transactions);
+	for (size_t i = 0; i != block.transactions.size(); ++i) {
+		if (tids.at(i) != block.header.transaction_hashes.at(i))
+			throw ConsensusError{"Transaction from block template absent in block"};
+	}
+	check_header(currency, block.header, body_proxy);
+	const auto parsed = std::chrono::steady_clock::now();
+	parse_time        = parsed - start;
 	if (context) {
 		auto ba  = currency.get_block_pow_hashing_data(block.header, body_proxy);
 		pow_hash = context->cn_slow_hash(ba.data(), ba.size());
+		pow_time = std::chrono::steady_clock::now() - parsed;
 	}
 }
 
@@ -117,10 +137,21 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
     : m_genesis_bid(currency.genesis_block_hash)
     , m_db(read_only ? platform::O_READ_EXISTING : platform::O_OPEN_ALWAYS, config.get_data_folder() + "/blockchain")
     , m_archive(read_only || !config.is_archive, config.get_data_folder() + "/archive")
+    , m_trace(read_only ? std::string{} : config.block_trace_path)
     , m_log(log, "BlockChainState")
     , m_config(config)
     , m_currency(currency) {
+	const auto start = std::chrono::steady_clock::now();
 	invariant(CheckpointDifficulty{}.size() == currency.get_checkpoint_keys_count(), "");
+	if (!read_only) {
+		m_db.set_cache_sizes(config.sqlite_cache_size_mb, config.sqlite_mmap_size_mb);
+		if (config.sqlite_wal)
+			m_db.set_write_ahead_log();
+		m_db.set_background_sync(float(config.db_sync_lag));
+		if (config.db_sync_lag != 0)
+			m_log(logging::WARNING) << "Blockchain DB sync lag is " << config.db_sync_lag
+			                        << " seconds, OS crash or power loss can corrupt DB, so it will need resync";
+	}
 	std::string version;
 	if (!m_db.get("$version", version)) {
 		DB::Cursor cur = m_db.begin(std::string{});
@@ -129,6 +160,11 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
 		version = version_current;
 		m_db.put("$version", version, false);
 	}
+	if (version == "8") {  // 9 only added block compression, blocks stored by 8 are read as is
+		version = version_current;
+		if (!read_only)
+			m_db.put("$version", version, false);
+	}
 	if (version != version_current)
 		return;  // BlockChainState will upgrade DB, we must not continue or risk crashing
 	Hash stored_genesis_bid;
@@ -142,12 +178,20 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
 		m_tip_cumulative_difficulty = tip_header.cumulative_difficulty;
 		m_header_tip_window.push_back(tip_header);
 	}
+	BinaryArray pba;
+	if (m_db.get("$pruned_below_height", pba)) {
+		seria::from_binary(m_pruned_below_height, pba);
+		m_log(logging::INFO) << "BlockChain block bodies are pruned below height=" << m_pruned_below_height;
+	}
 	BinaryArray cha;
 	if (m_db.get("internal_import_chain", cha)) {
 		seria::from_binary(m_internal_import_chain, cha);
 		m_log(logging::INFO) << "BlockChain continue internal import of blocks, count="
 		                     << m_internal_import_chain.size();
 	}
+	const auto open_ms =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	m_log(logging::INFO) << "BlockChain opened DB ms=" << open_ms.count();
 	//	m_db.debug_print_index_size(BLOCK_PREFIX);
 	//	m_db.debug_print_index_size(TRANSACTION_PREFIX);
 	//	m_db.debug_print_index_size(TIP_CHAIN_PREFIX);
@@ -162,18 +206,61 @@ BlockChain::BlockChain(logging::ILogger &log, const Config &config, const Curren
 void BlockChain::db_commit() {
 	m_log(logging::INFO) << "BlockChain::db_commit started... tip_height=" << m_tip_height
 	                     << " m_header_cache.size=" << m_header_cache.size();
-	m_db.commit_db_txn();
+	{
+		BlockTrace::Timer trace_timer(m_trace, BlockTrace::COMMIT);
+		m_db.commit_db_txn();
+	}
+	m_trace.flush();
+	const std::string sync_error = m_db.get_sync_error();
+	if (!sync_error.empty())
+		m_log(logging::ERROR) << "Background sync of blockchain DB is failing, error=" << sync_error
+		                      << " durability lag=" << m_db.get_durability_lag() << " seconds, check disk";
 	m_header_cache.clear();  // Most simple cache policy ever
 	m_archive.db_commit();
 	m_log(logging::INFO) << "BlockChain::db_commit finished...";
 }
 
+static const Height PRUNE_BLOCKS_PER_CALL = 100;  // each costs few DB deletes, so on_idle stays responsive
+
+bool BlockChain::prune_block_bodies() {
+	// No reorganizations below last hard checkpoint, so we keep only what consensus needs - headers, main chain,
+	// outputs and key images (in BlockChainState). Deletes go into current DB transaction and are committed
+	// with blocks, so first prune of a long chain is spread over many idle calls and commits
+	const Height checkpoint_height = m_currency.last_hard_checkpoint().height;
+	if (m_config.prune_below_depth == 0 || checkpoint_height < m_config.prune_below_depth ||
+	    m_tip_height == Height(-1))
+		return false;
+	const Height target = std::min(checkpoint_height - m_config.prune_below_depth, m_tip_height);
+	if (m_pruned_below_height >= target)
+		return false;
+	const Height finish = std::min(target, m_pruned_below_height + PRUNE_BLOCKS_PER_CALL);
+	for (; m_pruned_below_height != finish; ++m_pruned_below_height) {
+		const Hash bid = read_chain(m_pruned_below_height);
+		RawBlock raw_block;
+		invariant(get_block(bid, &raw_block), "Block to prune not found " + common::pod_to_hex(bid));
+		Block block(raw_block);
+		Hash tid = get_transaction_hash(block.header.base_transaction);
+		m_db.del(TRANSACTION_PREFIX + DB::to_binary_key(tid.data, sizeof(tid.data)), true);
+		for (const auto &th : block.header.transaction_hashes)
+			m_db.del(TRANSACTION_PREFIX + DB::to_binary_key(th.data, sizeof(th.data)), true);
+		m_db.del(BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX, true);
+	}
+	m_db.put("$pruned_below_height", seria::to_binary(m_pruned_below_height), false);
+	if (m_pruned_below_height != target)
+		return true;
+	m_log(logging::INFO) << "BlockChain block bodies are pruned below height=" << m_pruned_below_height;
+	return false;
+}
+
 bool BlockChain::add_block(
     const PreparedBlock &pb, api::BlockHeader *info, bool just_mined, const std::string &source_address) {
+	static auto &add_block_seconds =
+	    common::metrics::registry().histogram("add_block_seconds", "BlockChain::add_block duration");
+	common::metrics::ScopeTimer timer(add_block_seconds);
 	*info            = api::BlockHeader();
 	bool have_header = get_header(pb.bid, info);
 	bool have_block  = has_block(pb.bid);
-	if (have_block && have_header) {
+	if (have_header && (have_block || info->height < m_pruned_below_height)) {
 		if (info->height > m_currency.last_hard_checkpoint().height)
 			m_archive.add(Archive::BLOCK, pb.block_data, pb.bid, source_address);
 		return false;
@@ -190,7 +277,11 @@ bool BlockChain::add_block(
 	info->hash                = pb.bid;
 	info->height              = prev_info.height + 1;
 	// Rest fields are filled by check_consensus
+	const auto consensus_start = std::chrono::steady_clock::now();
 	check_consensus(pb, info, prev_info, true);  // throws ConsensusError
+	if (m_trace.enabled())  // PoW is calculated in check_consensus unless prepared in parallel
+		m_trace.set_prepared(
+		    pb.bid, pb.parse_time, pb.pow_time + (std::chrono::steady_clock::now() - consensus_start));
 	if (!add_blod(*info)) {                      // Has parent that does not pass through last hard checkpoint
 		if (info->height > m_currency.last_hard_checkpoint().height)
 			m_archive.add(Archive::BLOCK, pb.block_data, pb.bid, source_address);
@@ -473,9 +564,10 @@ bool BlockChain::get_transaction(
 	APITransactionPos tpos;
 	seria::from_binary(tpos, ba);
 	Hash bid = read_chain(tpos.height);
-	DB::Value block_val;
-	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
-	invariant(m_db.get(key, block_val), "block must be there if transaction is there");
+	BinaryArray block_val;
+	// Whole block is decompressed for one transaction, ~0.5us for 2KB and ~85us for 300KB block
+	// (tests --benchmark-compression), small compared to DB read and parsing of transaction by caller
+	invariant(get_block(bid, &block_val, nullptr), "block must be there if transaction is there");
 	invariant(tpos.offset + tpos.size <= block_val.size(), "Transaction offset corrupted");
 	*block_hash     = bid;
 	*block_height   = tpos.height;
@@ -486,7 +578,9 @@ bool BlockChain::get_transaction(
 
 void BlockChain::redo_block(const Hash &bhash, const BinaryArray &block_data, const RawBlock &raw_block,
     const Block &block, const api::BlockHeader &info, const Hash &base_transaction_hash) {
+	m_trace.begin_block(bhash, info.height, block.transactions.size());
 	redo_block(bhash, block, info);
+	BlockTrace::Timer trace_timer(m_trace, BlockTrace::INDEX);
 	auto tikey = TIMESTAMP_BLOCK_PREFIX + common::write_varint_sqlite4(info.timestamp) +
 	             common::write_varint_sqlite4(info.height);
 	m_db.put(tikey, std::string{}, true);
@@ -535,8 +629,29 @@ void BlockChain::undo_block(const Hash &bhash, const RawBlock &, const Block &bl
 }
 
 void BlockChain::store_block(const Hash &bid, const BinaryArray &block_data) {
-	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
-	m_db.put(key, block_data, true);
+	auto key       = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
+	BinaryArray ba = {BLOCK_COMPRESSED_MARKER, BLOCK_CODEC_LZ};
+	common::append(ba, common::get_varint_data(block_data.size()));
+	common::lz_compress(block_data.data(), block_data.size(), &ba);
+	if (ba.size() + block_data.size() / 32 < block_data.size())  // otherwise not worth decompressing
+		m_db.put(key, ba, true);
+	else
+		m_db.put(key, block_data, true);
+}
+
+static void uncompress_block(BinaryArray *ba) {
+	if (ba->empty() || ba->at(0) != BLOCK_COMPRESSED_MARKER)
+		return;
+	if (ba->size() < 2 || ba->at(1) != BLOCK_CODEC_LZ)
+		throw std::runtime_error("Stored block compressed with unknown codec, database corrupted");
+	auto begin         = ba->data() + 2;
+	auto end           = ba->data() + ba->size();
+	size_t result_size = 0;
+	if (common::read_varint(begin, end, &result_size) <= 0)
+		throw std::runtime_error("Stored block size corrupted, database corrupted");
+	BinaryArray result;
+	common::lz_decompress(begin, end - begin, result_size, &result);
+	*ba = std::move(result);
 }
 
 bool BlockChain::get_block(const Hash &bid, BinaryArray *block_data, RawBlock *raw_block) const {
@@ -544,6 +659,7 @@ bool BlockChain::get_block(const Hash &bid, BinaryArray *block_data, RawBlock *r
 	auto key = BLOCK_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + BLOCK_SUFFIX;
 	if (!m_db.get(key, rb))
 		return false;
+	uncompress_block(&rb);
 	if (raw_block)
 		seria::from_binary(*raw_block, rb);
 	if (block_data)
@@ -636,6 +752,33 @@ void BlockChain::for_each_reversed_tip_segment(const api::BlockHeader &prev_info
 	}
 }
 
+Difficulty BlockChain::get_next_header_difficulty(const api::BlockHeader &prev_info, uint8_t major_version,
+    const std::vector<Timestamp> &pending_timestamps, const std::vector<CumulativeDifficulty> &pending_difficulties,
+    CumulativeDifficulty *cumulative_difficulty) const {
+	invariant(pending_timestamps.size() == pending_difficulties.size(), "");
+	const Height blocks_count = m_currency.difficulty_windows();
+	const size_t pending      = std::min<size_t>(pending_timestamps.size(), blocks_count);
+	std::vector<Timestamp> timestamps;
+	std::vector<CumulativeDifficulty> difficulties;
+	timestamps.reserve(blocks_count);
+	difficulties.reserve(blocks_count);
+	// Window is empty right after genesis, next_effective_difficulty handles it
+	for_each_reversed_tip_segment(
+	    prev_info, static_cast<Height>(blocks_count - pending), false, [&](const api::BlockHeader &header) {
+		    timestamps.push_back(header.timestamp);
+		    difficulties.push_back(header.cumulative_difficulty);
+	    });
+	std::reverse(timestamps.begin(), timestamps.end());
+	std::reverse(difficulties.begin(), difficulties.end());
+	timestamps.insert(timestamps.end(), pending_timestamps.end() - pending, pending_timestamps.end());
+	difficulties.insert(difficulties.end(), pending_difficulties.end() - pending, pending_difficulties.end());
+	const CumulativeDifficulty prev_cumulative_difficulty =
+	    pending_difficulties.empty() ? prev_info.cumulative_difficulty : pending_difficulties.back();
+	const Difficulty difficulty = m_currency.next_effective_difficulty(major_version, timestamps, difficulties);
+	*cumulative_difficulty      = prev_cumulative_difficulty + difficulty;
+	return difficulty;
+}
+
 // std::vector<api::BlockHeader> BlockChain::get_tip_segment(
 //    const api::BlockHeader &prev_info, Height window, bool add_genesis) const {
 //	std::vector<api::BlockHeader> result;
@@ -673,6 +816,19 @@ void BlockChain::pop_chain(const Hash &new_tip_bid) {
 	m_tip_cumulative_difficulty = get_tip().cumulative_difficulty;
 }
 
+bool BlockChain::set_tip_window(std::deque<api::BlockHeader> &&window) {
+	if (window.empty() || window.size() > m_currency.largest_window() * 2 || window.back().hash != m_tip_bid ||
+	    window.back().height != m_tip_height)
+		return false;
+	for (size_t i = 1; i < window.size(); ++i)
+		if (window.at(i).previous_block_hash != window.at(i - 1).hash ||
+		    window.at(i).height != window.at(i - 1).height + 1)
+			return false;
+	m_header_tip_window         = std::move(window);
+	m_tip_cumulative_difficulty = m_header_tip_window.back().cumulative_difficulty;
+	return true;
+}
+
 // After upgrading to future versions, remove version from index key
 bool BlockChain::get_chain(Height height, Hash *bid) const {
 	BinaryArray ba;
@@ -771,17 +927,11 @@ bool BlockChain::prune_branch(CumulativeDifficulty cd, Hash bid) {
 	for (auto cit = checkpoints.begin(); cit != checkpoints.end(); ++cit)
 		if (cit->is_enabled() && cit->hash == bid)
 			return false;
-	auto bit = m_blods.find(bid);
-	if (bit != m_blods.end()) {
-		if (!bit->second.children.empty())
+	auto bit = m_blod_indexes.find(bid);
+	if (bit != m_blod_indexes.end()) {
+		if (m_blods.at(bit->second).first_child != NO_BLOD)
 			return false;
-		if (bit->second.parent) {
-			auto rit =
-			    std::remove(bit->second.parent->children.begin(), bit->second.parent->children.end(), &bit->second);
-			invariant(rit != bit->second.parent->children.end(), "");
-			bit->second.parent->children.erase(rit, bit->second.parent->children.end());
-		}
-		m_blods.erase(bit);
+		erase_blod(bit->second);
 	}
 	api::BlockHeader me = read_header(bid);
 	modify_children_counter(cd, bid, 1);
@@ -1080,11 +1230,8 @@ bool BlockChain::add_checkpoint(const SignedCheckpoint &checkpoint, const std::s
 	m_db.put(key_latest, binary_checkpoint, false);
 	m_archive.add(Archive::CHECKPOINT, binary_checkpoint,
 	    crypto::cn_fast_hash(binary_checkpoint.data(), binary_checkpoint.size()), source_address);
-	if (checkpoint.is_enabled()) {
-		auto bit = m_blods.find(checkpoint.hash);
-		if (bit == m_blods.end())
-			return true;  // orphan checkpoint
-	}
+	if (checkpoint.is_enabled() && m_blod_indexes.count(checkpoint.hash) == 0)
+		return true;  // orphan checkpoint
 	m_db.put(key_stable, binary_checkpoint, false);
 	update_key_count_max_heights();
 	auto tip_check_cd = get_checkpoint_difficulty(get_tip_bid());
@@ -1118,45 +1265,106 @@ int BlockChain::compare(const CheckpointDifficulty &a, CumulativeDifficulty ca,
 	return 0;
 }
 
+constexpr uint32_t BlockChain::NO_BLOD;
+
+uint32_t BlockChain::new_blod(const Hash &hash, Height height, uint32_t parent) {
+	uint32_t index = 0;
+	if (m_free_blods.empty()) {
+		index = common::integer_cast<uint32_t>(m_blods.size());
+		m_blods.emplace_back();
+	} else {
+		index = m_free_blods.back();
+		m_free_blods.pop_back();
+	}
+	Blod &blod  = m_blods.at(index);
+	blod.hash   = hash;
+	blod.height = height;
+	blod.parent = parent;
+	if (parent != NO_BLOD) {
+		blod.next_sibling               = m_blods.at(parent).first_child;
+		m_blods.at(parent).first_child = index;
+	}
+	m_blod_indexes.emplace(hash, index);
+	return index;
+}
+
+void BlockChain::erase_blod(uint32_t index) {
+	Blod &blod = m_blods.at(index);
+	invariant(blod.first_child == NO_BLOD, "");
+	if (blod.parent != NO_BLOD) {
+		uint32_t *link = &m_blods.at(blod.parent).first_child;
+		while (*link != index) {
+			invariant(*link != NO_BLOD, "Blod not found among children of its parent");
+			link = &m_blods.at(*link).next_sibling;
+		}
+		*link = blod.next_sibling;
+	}
+	m_blod_indexes.erase(blod.hash);
+	m_blod_vote_windows.erase(index);
+	blod = Blod{};
+	m_free_blods.push_back(index);
+}
+
+std::vector<uint8_t> BlockChain::take_blod_vote_window(uint32_t index) {
+	auto wit = m_blod_vote_windows.find(index);
+	if (wit != m_blod_vote_windows.end()) {
+		std::vector<uint8_t> result = std::move(wit->second);
+		m_blod_vote_windows.erase(wit);
+		return result;
+	}
+	// Fork from a block whose window was already taken, or from a tip left after pruning
+	const Height window = m_currency.upgrade_voting_window;
+	std::vector<uint8_t> result(window);
+	const Height top    = m_blods.at(index).height;
+	const Height bottom = top + 1 >= window ? top + 1 - window : 0;
+	for (Height h = top + 1; h-- > bottom;) {
+		if (index != NO_BLOD) {
+			result.at(h % window) = m_blods.at(index).vote_for_upgrade;
+			index                 = m_blods.at(index).parent;
+		} else if (h >= m_checkpoint_window_start)  // below last hard checkpoint
+			result.at(h % window) = m_checkpoint_window_votes.at(h - m_checkpoint_window_start);
+	}
+	return result;
+}
+
 bool BlockChain::add_blod_impl(const api::BlockHeader &header) {
-	auto bit = m_blods.find(header.hash);
-	if (bit != m_blods.end())
+	if (m_blod_indexes.count(header.hash) != 0)
 		return true;  // Strange, but nop
-	bit = m_blods.find(header.previous_block_hash);
-	if (bit == m_blods.end())
+	auto pit = m_blod_indexes.find(header.previous_block_hash);
+	if (pit == m_blod_indexes.end())
 		return false;
-	Blod &blod  = m_blods[header.hash];
-	blod.height = header.height;
-	blod.hash   = header.hash;
-	blod.parent = &bit->second;
-	bit->second.children.push_back(&blod);
-	blod.checkpoint_difficulty = blod.parent->checkpoint_difficulty;
+	const uint32_t index       = new_blod(header.hash, header.height, pit->second);
+	Blod &blod                 = m_blods.at(index);
+	const Blod &parent         = m_blods.at(blod.parent);
+	blod.checkpoint_difficulty = parent.checkpoint_difficulty;
 
 	if (m_currency.wish_to_upgrade()) {
 		blod.vote_for_upgrade       = uint8_t(m_currency.is_upgrade_vote(header.major_version, header.minor_version));
-		blod.upgrade_decided_height = blod.parent->upgrade_decided_height;
+		blod.upgrade_decided_height = parent.upgrade_decided_height;
 		if (!blod.upgrade_decided_height) {
-			blod.votes_for_upgrade_in_voting_window = blod.parent->votes_for_upgrade_in_voting_window;
-			blod.votes_for_upgrade_in_voting_window.push_back(blod.vote_for_upgrade);
-			if (blod.votes_for_upgrade_in_voting_window.size() > m_currency.upgrade_voting_window)
-				blod.votes_for_upgrade_in_voting_window.pop_front();
-			invariant(blod.votes_for_upgrade_in_voting_window.size() <= m_currency.upgrade_voting_window, "");
-			size_t count = std::count(blod.votes_for_upgrade_in_voting_window.begin(),
-			    blod.votes_for_upgrade_in_voting_window.end(), uint8_t(1));
-			if (count >= m_currency.upgrade_votes_required()) {
+			// Window is [height - upgrade_voting_window + 1..height], but never starts before first vote
+			std::vector<uint8_t> window = take_blod_vote_window(blod.parent);
+			uint8_t &slot               = window.at(blod.height % m_currency.upgrade_voting_window);
+			blod.votes_for_upgrade_in_voting_window = parent.votes_for_upgrade_in_voting_window + blod.vote_for_upgrade;
+			if (blod.height >= m_checkpoint_window_start + m_currency.upgrade_voting_window)
+				blod.votes_for_upgrade_in_voting_window -= slot;  // vote leaving window
+			slot = blod.vote_for_upgrade;
+			invariant(blod.votes_for_upgrade_in_voting_window <= m_currency.upgrade_voting_window, "");
+			if (blod.votes_for_upgrade_in_voting_window >= m_currency.upgrade_votes_required()) {
 				blod.upgrade_decided_height = blod.height + m_currency.upgrade_window;
 				m_log(logging::INFO) << logging::Green << "Consensus upgrade votes gathered on height=" << header.height
 				                     << " upgrade_decided_height=" << blod.upgrade_decided_height
 				                     << " bid=" << header.hash;
-				blod.votes_for_upgrade_in_voting_window.clear();
-			}
+				blod.votes_for_upgrade_in_voting_window = 0;
+			} else
+				m_blod_vote_windows.emplace(index, std::move(window));
 		}
 	}
 	return true;
 }
 
 bool BlockChain::add_blod(const api::BlockHeader &header) {
-	if (m_blods.empty())  // Allow any blocks if main does not pass through last sw checkpoint yet
+	if (m_blod_indexes.empty())  // Allow any blocks if main does not pass through last sw checkpoint yet
 		return true;
 	add_blod_impl(header);
 	// We inherit from parent and rebuild only if we pass through one of checlpoints
@@ -1174,7 +1382,7 @@ bool BlockChain::add_blod(const api::BlockHeader &header) {
 }
 
 void BlockChain::build_blods() {
-	if (!m_blods.empty())
+	if (!m_blod_indexes.empty())
 		return;  // build only once per daemon launch
 	api::BlockHeader last_hard_checkpoint_header;
 	if (!get_header(m_currency.last_hard_checkpoint().hash, &last_hard_checkpoint_header))
@@ -1183,8 +1391,8 @@ void BlockChain::build_blods() {
 	              last_hard_checkpoint_header.major_version == 1 + m_currency.upgrade_heights.size(),
 	    "When adding checkpoint after consensus update, always update currency.upgrade_heights");
 
-	std::set<Hash> bad_header_hashes;   // sidechains that do not pass through last hard checkpoint
-	std::set<Hash> good_header_hashes;  // sidechains that pass through last hard checkpoint
+	std::unordered_set<Hash> bad_header_hashes;   // sidechains that do not pass through last hard checkpoint
+	std::unordered_set<Hash> good_header_hashes;  // sidechains that pass through last hard checkpoint
 	std::vector<api::BlockHeader> good_headers;
 	for_each_tip([&](CumulativeDifficulty cd, Hash tip_bid) -> bool {
 		std::vector<api::BlockHeader> side_chain;
@@ -1223,26 +1431,27 @@ void BlockChain::build_blods() {
 		}
 		return true;
 	});
+	m_blods.reserve(good_headers.size());
+	m_blod_indexes.reserve(good_headers.size());
 	for (auto &&ha : good_headers) {  // They are conveniently sorted parent to child and can be applied sequentially
 		if (!add_blod_impl(ha)) {
 			invariant(ha.hash == m_currency.last_hard_checkpoint().hash, "");
-			Blod &blod  = m_blods[ha.hash];
-			blod.height = ha.height;
-			blod.hash   = ha.hash;
+			Blod &blod = m_blods.at(new_blod(ha.hash, ha.height, NO_BLOD));
 			if (m_currency.wish_to_upgrade()) {
 				blod.vote_for_upgrade = uint8_t(m_currency.is_upgrade_vote(ha.major_version, ha.minor_version));
-				Height first_height =
+				m_checkpoint_window_start =
 				    m_currency.last_hard_checkpoint().height < m_currency.upgrade_voting_window - 1
 				        ? 0
 				        : m_currency.last_hard_checkpoint().height - (m_currency.upgrade_voting_window - 1);
-				for (Height h = first_height; h != m_currency.last_hard_checkpoint().height; ++h) {
+				m_checkpoint_window_votes.clear();
+				for (Height h = m_checkpoint_window_start; h != m_currency.last_hard_checkpoint().height; ++h) {
 					auto header = read_header(read_chain(h), h);
 					auto vote   = uint8_t(m_currency.is_upgrade_vote(header.major_version, header.minor_version));
-					blod.votes_for_upgrade_in_voting_window.push_back(vote);
+					m_checkpoint_window_votes.push_back(vote);
 				}
-				blod.votes_for_upgrade_in_voting_window.push_back(blod.vote_for_upgrade);
-				//				size_t count = std::count(blod.votes_for_upgrade_in_voting_window.begin(),
-				//				    blod.votes_for_upgrade_in_voting_window.end(), uint8_t(1));
+				m_checkpoint_window_votes.push_back(blod.vote_for_upgrade);
+				blod.votes_for_upgrade_in_voting_window = static_cast<Height>(
+				    std::count(m_checkpoint_window_votes.begin(), m_checkpoint_window_votes.end(), uint8_t(1)));
 			}
 		}
 	}
@@ -1250,17 +1459,17 @@ void BlockChain::build_blods() {
 }
 
 void BlockChain::fill_statistics(api::cnd::GetStatistics::Response &res) const {
-	res.checkpoints = get_latest_checkpoints();
+	res.checkpoints           = get_latest_checkpoints();
+	res.archive_queue_size    = m_archive.get_queue_size();
+	res.archive_dropped_count = m_archive.get_dropped_count();
 
 	if (!m_currency.wish_to_upgrade())
 		return;
-	auto bit = m_blods.find(get_tip_bid());
-	if (bit == m_blods.end())
+	auto bit = m_blod_indexes.find(get_tip_bid());
+	if (bit == m_blod_indexes.end())
 		return;
-	res.upgrade_decided_height     = bit->second.upgrade_decided_height;
-	auto count                     = std::count(bit->second.votes_for_upgrade_in_voting_window.begin(),
-        bit->second.votes_for_upgrade_in_voting_window.end(), uint8_t(1));
-	res.upgrade_votes_in_top_block = static_cast<Height>(count);
+	res.upgrade_decided_height     = m_blods.at(bit->second).upgrade_decided_height;
+	res.upgrade_votes_in_top_block = m_blods.at(bit->second).votes_for_upgrade_in_voting_window;
 }
 
 bool BlockChain::fill_next_block_versions(
@@ -1272,12 +1481,13 @@ bool BlockChain::fill_next_block_versions(
 #endif
 	if (!m_currency.wish_to_upgrade())
 		return true;
-	if (m_blods.empty())
+	if (m_blod_indexes.empty())
 		return true;
-	auto bit = m_blods.find(prev_info.hash);
-	if (bit == m_blods.end())
+	auto bit = m_blod_indexes.find(prev_info.hash);
+	if (bit == m_blod_indexes.end())
 		return false;
-	if (!bit->second.upgrade_decided_height || prev_info.height + 1 < bit->second.upgrade_decided_height)
+	const Blod &blod = m_blods.at(bit->second);
+	if (!blod.upgrade_decided_height || prev_info.height + 1 < blod.upgrade_decided_height)
 		return true;
 	*major_cm = *major_mm = m_currency.upgrade_desired_major;
 #if bytecoin_ALLOW_CM
@@ -1289,38 +1499,231 @@ bool BlockChain::fill_next_block_versions(
 
 void BlockChain::update_key_count_max_heights() {
 	// We use simplest O(n) algo, will optimize later and use this one as a reference
-	for (auto &&bit : m_blods) {
-		bit.second.checkpoint_key_ids.reset();
-		bit.second.checkpoint_difficulty = CheckpointDifficulty{};
+	for (auto &blod : m_blods) {
+		blod.checkpoint_key_ids.reset();
+		blod.checkpoint_difficulty = CheckpointDifficulty{};
 	}
 	auto checkpoints = get_stable_checkpoints();
 	for (const auto &cit : checkpoints)
 		if (cit.is_enabled()) {
-			auto bit = m_blods.find(cit.hash);
-			if (bit == m_blods.end())
+			auto bit = m_blod_indexes.find(cit.hash);
+			if (bit == m_blod_indexes.end())
 				continue;
-			for (Blod *b = &bit->second; b; b = b->parent)
-				b->checkpoint_key_ids.set(cit.key_id);
+			for (uint32_t i = bit->second; i != NO_BLOD; i = m_blods.at(i).parent)
+				m_blods.at(i).checkpoint_key_ids.set(cit.key_id);
 		}
-	std::vector<Blod *> to_visit;
-	auto bit = m_blods.find(m_currency.last_hard_checkpoint().hash);
-	if (bit != m_blods.end())
-		to_visit.push_back(&bit->second);
+	std::vector<uint32_t> to_visit;
+	auto bit = m_blod_indexes.find(m_currency.last_hard_checkpoint().hash);
+	if (bit != m_blod_indexes.end())
+		to_visit.push_back(bit->second);
 	while (!to_visit.empty()) {
-		Blod *blod = to_visit.back();
+		Blod &blod = m_blods.at(to_visit.back());
 		to_visit.pop_back();
-		size_t key_count = blod->checkpoint_key_ids.count();
-		if (blod->parent)
-			blod->checkpoint_difficulty = blod->parent->checkpoint_difficulty;
+		size_t key_count = blod.checkpoint_key_ids.count();
+		if (blod.parent != NO_BLOD)
+			blod.checkpoint_difficulty = m_blods.at(blod.parent).checkpoint_difficulty;
 		if (key_count > 0)
-			blod->checkpoint_difficulty.at(key_count - 1) = blod->height;
-		to_visit.insert(to_visit.end(), blod->children.begin(), blod->children.end());
+			blod.checkpoint_difficulty.at(key_count - 1) = blod.height;
+		for (uint32_t c = blod.first_child; c != NO_BLOD; c = m_blods.at(c).next_sibling)
+			to_visit.push_back(c);
 	}
 }
 
 BlockChain::CheckpointDifficulty BlockChain::get_checkpoint_difficulty(Hash hash) const {
-	auto bit = m_blods.find(hash);
-	if (bit == m_blods.end())
+	auto bit = m_blod_indexes.find(hash);
+	if (bit == m_blod_indexes.end())
 		return CheckpointDifficulty{};
-	return bit->second.checkpoint_difficulty;
+	return m_blods.at(bit->second).checkpoint_difficulty;
+}
+
+// Snapshot file is magic, chunks (varint size + key/value pairs), trailer, trailer size (8 bytes little-endian).
+// Snapshot hash is hash of trailer, which contains hashes of all chunks, so each chunk is verified before use
+static const std::string SNAPSHOT_MAGIC = "CNstate1";
+static const size_t SNAPSHOT_CHUNK_SIZE = 4 * 1024 * 1024;
+
+struct StateSnapshotTrailer {
+	std::string version;
+	Hash genesis_bid;
+	Height height = 0;
+	Hash tip_bid;
+	uint64_t item_count = 0;
+	std::vector<Hash> chunk_hashes;
+};
+
+namespace seria {
+void ser_members(StateSnapshotTrailer &v, ISeria &s) {
+	seria_kv("version", v.version, s);
+	seria_kv("genesis_bid", v.genesis_bid, s);
+	seria_kv("height", v.height, s);
+	seria_kv("tip_bid", v.tip_bid, s);
+	seria_kv("item_count", v.item_count, s);
+	seria_kv("chunk_hashes", v.chunk_hashes, s);
+}
+}  // namespace seria
+
+bool BlockChain::state_snapshot_includes(const std::string &key, const BinaryArray &value) const {
+	// Blocks above last hard checkpoint can still be undone, so their bodies and transactions are kept
+	const Height checkpoint_height = m_currency.last_hard_checkpoint().height;
+	if (key == "internal_import_chain" || key == "$pruned_below_height")
+		return false;
+	if (common::starts_with(key, TRANSACTION_PREFIX)) {
+		APITransactionPos tpos;
+		seria::from_binary(tpos, value);
+		return tpos.height > checkpoint_height;
+	}
+	if (common::starts_with(key, BLOCK_PREFIX) &&
+	    key.size() == BLOCK_PREFIX.size() + sizeof(Hash) + BLOCK_SUFFIX.size() && common::ends_with(key, BLOCK_SUFFIX)) {
+		Hash bid;
+		DB::from_binary_key(key, BLOCK_PREFIX.size(), bid.data, sizeof(bid.data));
+		api::BlockHeader header;
+		return get_header(bid, &header) && header.height > checkpoint_height;
+	}
+	return true;
+}
+
+Hash BlockChain::export_state_snapshot(const std::string &file_name) const {
+	const HardCheckpoint checkpoint = m_currency.last_hard_checkpoint();
+	Hash bid;
+	if (m_tip_height == Height(-1) || m_tip_height < checkpoint.height || !get_chain(checkpoint.height, &bid) ||
+	    bid != checkpoint.hash)
+		throw std::runtime_error("State snapshot can be exported only from blockchain synced to last hard checkpoint " +
+		                         common::to_string(checkpoint.height));
+	StateSnapshotTrailer trailer;
+	trailer.version     = version_current;
+	trailer.genesis_bid = m_genesis_bid;
+	trailer.height      = m_tip_height;
+	trailer.tip_bid     = m_tip_bid;
+
+	platform::FileStream file(file_name, platform::O_CREATE_ALWAYS);
+	file.write(SNAPSHOT_MAGIC);
+	BinaryArray chunk;
+	auto flush_chunk = [&]() {
+		trailer.chunk_hashes.push_back(crypto::cn_fast_hash(chunk.data(), chunk.size()));
+		file.write_varint(chunk.size());
+		file.write(chunk);
+		chunk.clear();
+	};
+	for (DB::Cursor cur = m_db.begin(std::string{}); !cur.end(); cur.next()) {
+		const std::string &key = cur.get_suffix();
+		const BinaryArray value = cur.get_value_array();
+		if (!state_snapshot_includes(key, value))
+			continue;
+		common::VectorOutputStream stream(chunk);
+		stream.write_varint(key.size());
+		stream.write(key);
+		stream.write_varint(value.size());
+		stream.write(value);
+		trailer.item_count += 1;
+		if (chunk.size() >= SNAPSHOT_CHUNK_SIZE)
+			flush_chunk();
+		if (trailer.item_count % 1000000 == 0)
+			std::cout << "Exported " << trailer.item_count / 1000000 << " million items" << std::endl;
+	}
+	if (!chunk.empty())
+		flush_chunk();
+	const BinaryArray trailer_ba = seria::to_binary(trailer);
+	file.write(trailer_ba);
+	uint8_t size_le[8]{};
+	for (size_t i = 0; i != sizeof(size_le); ++i)
+		size_le[i] = static_cast<uint8_t>(uint64_t(trailer_ba.size()) >> (8 * i));
+	file.write(size_le, sizeof(size_le));
+	file.fsync();
+	return crypto::cn_fast_hash(trailer_ba.data(), trailer_ba.size());
+}
+
+void BlockChain::import_state_snapshot(
+    const Currency &currency, const std::string &db_path, const std::string &file_name, const Hash &snapshot_hash) {
+	platform::FileStream file(file_name, platform::O_READ_EXISTING);
+	std::string magic;
+	file.read(magic, SNAPSHOT_MAGIC.size());
+	if (magic != SNAPSHOT_MAGIC)
+		throw std::runtime_error("File is not a state snapshot " + file_name);
+	const uint64_t file_size = file.seek(0, SEEK_END);
+	uint8_t size_le[8]{};
+	file.seek(file_size - sizeof(size_le), SEEK_SET);
+	file.read(size_le, sizeof(size_le));
+	uint64_t trailer_size = 0;
+	for (size_t i = 0; i != sizeof(size_le); ++i)
+		trailer_size |= uint64_t(size_le[i]) << (8 * i);
+	if (trailer_size > file_size - sizeof(size_le) - SNAPSHOT_MAGIC.size())
+		throw std::runtime_error("State snapshot trailer corrupted");
+	const uint64_t trailer_pos = file_size - sizeof(size_le) - trailer_size;
+	BinaryArray trailer_ba;
+	file.seek(trailer_pos, SEEK_SET);
+	file.read(trailer_ba, common::integer_cast<size_t>(trailer_size));
+	if (crypto::cn_fast_hash(trailer_ba.data(), trailer_ba.size()) != snapshot_hash)
+		throw std::runtime_error("State snapshot hash does not match, file corrupted or from untrusted source");
+	StateSnapshotTrailer trailer;
+	seria::from_binary(trailer, trailer_ba);
+	if (trailer.genesis_bid != currency.genesis_block_hash)
+		throw std::runtime_error("State snapshot is for different genesis block");
+	if (trailer.version != version_current)
+		throw std::runtime_error("State snapshot has database version " + trailer.version + ", expected " +
+		                         version_current);
+	const HardCheckpoint checkpoint = currency.last_hard_checkpoint();
+	if (trailer.height < checkpoint.height)
+		throw std::runtime_error("State snapshot is below last hard checkpoint");
+	std::string error;
+	{
+		DB db(platform::O_OPEN_ALWAYS, db_path);
+		if (!db.begin(std::string{}).end())
+			throw std::runtime_error("State snapshot can be imported only into empty database, please delete " +
+			                         db.get_path());
+		try {
+			file.seek(SNAPSHOT_MAGIC.size(), SEEK_SET);
+			BinaryArray chunk;
+			std::string key;
+			BinaryArray value;
+			uint64_t item_count = 0;
+			size_t uncommitted  = 0;
+			for (size_t ci = 0; ci != trailer.chunk_hashes.size(); ++ci) {
+				file.read(chunk, file.read_varint<size_t>());
+				if (crypto::cn_fast_hash(chunk.data(), chunk.size()) != trailer.chunk_hashes.at(ci))
+					throw std::runtime_error("State snapshot chunk " + common::to_string(ci) + " corrupted");
+				common::MemoryInputStream stream(chunk.data(), chunk.size());
+				while (!stream.empty()) {
+					stream.read(key, stream.read_varint<size_t>());
+					stream.read(value, stream.read_varint<size_t>());
+					db.put(key, value, true);
+					item_count += 1;
+				}
+				uncommitted += chunk.size();
+				if (uncommitted >= 64 * SNAPSHOT_CHUNK_SIZE) {
+					db.commit_db_txn();
+					uncommitted = 0;
+				}
+				std::cout << "Imported chunk " << ci + 1 << "/" << trailer.chunk_hashes.size() << std::endl;
+			}
+			if (file.tellp() != trailer_pos || item_count != trailer.item_count)
+				throw std::runtime_error("State snapshot has wrong size");
+			// Main chain must be linked by headers and pass through last hard checkpoint
+			std::cout << "Checking main chain headers..." << std::endl;
+			Hash bid = trailer.tip_bid;
+			for (Height ha = trailer.height + 1; ha-- != 0;) {
+				BinaryArray ba;
+				if (!db.get(TIP_CHAIN_PREFIX + common::write_varint_sqlite4(ha), ba))
+					throw std::runtime_error("State snapshot main chain is missing height " + common::to_string(ha));
+				Hash chain_bid;
+				seria::from_binary(chain_bid, ba);
+				if (!db.get(HEADER_PREFIX + DB::to_binary_key(bid.data, sizeof(bid.data)) + HEADER_SUFFIX, ba))
+					throw std::runtime_error("State snapshot is missing header " + common::pod_to_hex(bid));
+				api::BlockHeader header;
+				seria::from_binary(header, ba);
+				if (chain_bid != bid || header.hash != bid || header.height != ha ||
+				    (ha == checkpoint.height && bid != checkpoint.hash))
+					throw std::runtime_error("State snapshot main chain broken at height " + common::to_string(ha));
+				bid = header.previous_block_hash;
+			}
+			db.put("$pruned_below_height", seria::to_binary(Height(checkpoint.height + 1)), true);
+			db.commit_db_txn();
+		} catch (const std::exception &ex) {
+			error = common::what(ex);  // We delete partially imported DB after closing it
+			if (error.empty())
+				error = "unknown error";
+		}
+	}
+	if (!error.empty()) {
+		DB::delete_db(db_path);
+		throw std::runtime_error("State snapshot import failed, database deleted - " + error);
+	}
 }
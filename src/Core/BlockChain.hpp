@@ -4,10 +4,13 @@
 #pragma once
 
 #include <bitset>
+#include <chrono>
 #include <deque>
 #include <unordered_map>
 #include "Archive.hpp"
+#include "BlockTrace.hpp"
 #include "CryptoNote.hpp"
+#include "common/FlatHashMap.hpp"
 #include "logging/LoggerMessage.hpp"
 #include "platform/DB.hpp"
 #include "rpc_api.hpp"
@@ -58,12 +61,18 @@ struct PreparedBlock {
 	size_t block_header_size = 0;
 	size_t parent_block_size = 0;
 	Hash pow_hash;  // only if passed context != nullptr
+	std::chrono::steady_clock::duration parse_time{};
+	std::chrono::steady_clock::duration pow_time{};  // only if passed context != nullptr
 
 	explicit PreparedBlock(BinaryArray &&ba, const Currency &currency, crypto::CryptoNightContext *context);
 	explicit PreparedBlock(RawBlock &&rba, const Currency &currency, crypto::CryptoNightContext *context);
 	// we get raw blocks from p2p
+	// Checks not depending on transactions and blockchain, so can be done on header only. Throws ConsensusError
+	static void check_header(const Currency &currency, const BlockTemplate &header, const BlockBodyProxy &body_proxy);
+
 private:
-	void prepare(const Currency &currency, crypto::CryptoNightContext *context);
+	void prepare(
+	    const Currency &currency, crypto::CryptoNightContext *context, std::chrono::steady_clock::time_point start);
 };
 
 class BlockChain {
@@ -83,6 +92,11 @@ public:
 
 	void for_each_reversed_tip_segment(const api::BlockHeader &prev_info, Height window, bool add_genesis,
 	    std::function<void(const api::BlockHeader &header)> &&fun) const;
+	// Header-first sync. Headers not yet added continue chain after prev_info, their timestamps and cumulative
+	// difficulties are passed oldest first. Window continues into blockchain the same way as in consensus checks
+	Difficulty get_next_header_difficulty(const api::BlockHeader &prev_info, uint8_t major_version,
+	    const std::vector<Timestamp> &pending_timestamps, const std::vector<CumulativeDifficulty> &pending_difficulties,
+	    CumulativeDifficulty *cumulative_difficulty) const;
 
 	bool get_chain(Height height, Hash *bid) const;
 	bool in_chain(Height height, Hash bid) const;
@@ -113,7 +127,7 @@ public:
 	void test_print_tips() const;
 	bool test_prune_oldest();
 
-	void db_commit();
+	virtual void db_commit();
 
 	bool internal_import();  // import some existing blocks from inside DB
 	Height internal_import_known_height() const { return static_cast<Height>(m_internal_import_chain.size()); }
@@ -126,6 +140,17 @@ public:
 		m_archive.read_archive(std::move(req), resp);
 	}
 	virtual void fill_statistics(api::cnd::GetStatistics::Response &res) const;
+	float get_db_durability_lag() const { return m_db.get_durability_lag(); }
+	std::string get_db_sync_error() const { return m_db.get_sync_error(); }
+	// Bodies and transaction index of main chain blocks below are deleted (--prune-below-depth)
+	Height get_pruned_below_height() const { return m_pruned_below_height; }
+	bool prune_block_bodies();  // called from on_idle, deletes few blocks, returns true if more remain
+
+	// Consensus state at tip, without block bodies and transactions below last hard checkpoint. Returns snapshot hash
+	Hash export_state_snapshot(const std::string &file_name) const;
+	// Into empty DB, verifies every chunk and main chain headers, result is pruned below last hard checkpoint
+	static void import_state_snapshot(
+	    const Currency &currency, const std::string &db_path, const std::string &file_name, const Hash &snapshot_hash);
 
     typedef std::array<Height, 1> CheckpointDifficulty;  // size must be == m_currency.get_checkpoint_keys_count()
 protected:
@@ -145,6 +170,8 @@ protected:
 	    const Hash &base_transaction_hash) const;
 	void undo_block(const Hash &bhash, const RawBlock &raw_block, const Block &block, Height height);
 	virtual void tip_changed() {}  // Quick hack to allow BlockChainState to update next block params
+	const std::deque<api::BlockHeader> &get_tip_window() const { return m_header_tip_window; }
+	bool set_tip_window(std::deque<api::BlockHeader> &&window);  // false if window does not end with linked tip
 	virtual void on_reorganization(
 	    const std::map<Hash, std::pair<Transaction, BinaryArray>> &undone_transactions, bool undone_blocks) = 0;
 
@@ -154,6 +181,7 @@ protected:
 
 	DB m_db;
 	Archive m_archive;
+	BlockTrace m_trace;
 	logging::LoggerRef m_log;
 	const Config &m_config;
 	const Currency &m_currency;
@@ -164,6 +192,8 @@ private:
 	Hash m_tip_bid;
 	CumulativeDifficulty m_tip_cumulative_difficulty{};
 	Height m_tip_height = -1;  // We use overflow to 0 to apply genesis block in constructor
+	Height m_pruned_below_height = 0;
+	bool state_snapshot_includes(const std::string &key, const BinaryArray &value) const;
 	void push_chain(const api::BlockHeader &header);
 	void pop_chain(const Hash &new_tip_bid);
 	Hash read_chain(Height height) const;
@@ -190,19 +220,33 @@ private:
 
 	static int compare(const CheckpointDifficulty &a, CumulativeDifficulty ca, bool a_just_mined,
 	    const CheckpointDifficulty &b, CumulativeDifficulty cb);
+	// Block tree from last hard checkpoint, nodes are kept in contiguous array and refer to each other by index
+	static constexpr uint32_t NO_BLOD = std::numeric_limits<uint32_t>::max();
 	struct Blod {
 		Hash hash;
-		Height height = 0;
-		Blod *parent  = nullptr;
-		std::vector<Blod *> children;
+		Height height         = 0;
+		uint32_t parent       = NO_BLOD;
+		uint32_t first_child  = NO_BLOD;
+		uint32_t next_sibling = NO_BLOD;
 		std::bitset<64> checkpoint_key_ids;
 		CheckpointDifficulty checkpoint_difficulty;  // (key_count-1)->max_height
 
-		uint8_t vote_for_upgrade = 0;
-		std::deque<uint8_t> votes_for_upgrade_in_voting_window;
-		Height upgrade_decided_height = 0;
+		uint8_t vote_for_upgrade                  = 0;
+		Height votes_for_upgrade_in_voting_window = 0;  // count of votes in window ending at this block
+		Height upgrade_decided_height             = 0;
 	};
-	std::map<Hash, Blod> m_blods;
+	std::vector<Blod> m_blods;
+	std::vector<uint32_t> m_free_blods;  // erased nodes are reused
+	common::FlatHashMap<Hash, uint32_t> m_blod_indexes;
+	// Part of voting window below last hard checkpoint is the same for all branches
+	std::vector<uint8_t> m_checkpoint_window_votes;
+	Height m_checkpoint_window_start = 0;
+	// Last upgrade_voting_window votes of a branch, slot is height % window. Only tips own a window, extending
+	// child takes it from parent, so add_blod is O(1). Forks and prunes rebuild it from ancestors in O(window)
+	std::unordered_map<uint32_t, std::vector<uint8_t>> m_blod_vote_windows;
+	uint32_t new_blod(const Hash &hash, Height height, uint32_t parent);
+	void erase_blod(uint32_t index);
+	std::vector<uint8_t> take_blod_vote_window(uint32_t index);
 	void update_key_count_max_heights();
 	bool add_blod_impl(const api::BlockHeader &header);
 	bool add_blod(const api::BlockHeader &header);
@@ -37,6 +37,11 @@ LegacyBlockChainReader::LegacyBlockChainReader(const Currency &currency,
 		m_indexes_file->read(reinterpret_cast<char *>(&read_hei), sizeof(uint64_t));
 		m_count = common::integer_cast<Height>(std::min(read_hei, max_hei));
 	} catch (const std::runtime_error &) {
+		return;
+	}
+	try {
+		m_items_mapped = std::make_unique<platform::MappedFile>(item_file_name);
+	} catch (const std::runtime_error &) {  // will read with m_items_file
 	}
 }
 
@@ -46,8 +51,8 @@ LegacyBlockChainReader::~LegacyBlockChainReader() {
 		m_quit = true;
 		m_have_work.notify_all();
 	}
-	if (m_th.joinable())
-		m_th.join();
+	for (auto &th : m_threads)
+		th.join();
 }
 
 void LegacyBlockChainReader::load_offsets() {
@@ -57,6 +62,8 @@ void LegacyBlockChainReader::load_offsets() {
 	try {
 		m_items_file->seek(0, SEEK_END);
 		uint64_t m_itemsFileSize = m_items_file->tellp();
+		if (m_items_mapped)
+			m_itemsFileSize = std::min<uint64_t>(m_itemsFileSize, m_items_mapped->size());
 		std::vector<uint32_t> item_sizes(m_count);
 		m_indexes_file->read(reinterpret_cast<char *>(item_sizes.data()), m_count * sizeof(uint32_t));
 		for (size_t i = 0; i < item_sizes.size(); ++i) {
@@ -70,12 +77,21 @@ void LegacyBlockChainReader::load_offsets() {
 	m_offsets.emplace_back(pos);
 }
 
+size_t LegacyBlockChainReader::get_block_size(Height i) const {
+	return i + 1 < m_offsets.size() ? static_cast<size_t>(m_offsets[i + 1] - m_offsets[i]) : 0;
+}
+
 BinaryArray LegacyBlockChainReader::get_block_data_by_index(Height i) {
 	load_offsets();
 	if (i + 1 >= m_offsets.size())
 		return BinaryArray{};
 	try {
 		size_t si = common::integer_cast<size_t>(m_offsets.at(i + 1) - m_offsets.at(i));
+		if (m_items_mapped) {  // load_offsets checked that items fit in mapping
+			const uint8_t *data = m_items_mapped->data() + m_offsets.at(i);
+			return BinaryArray(data, data + si);
+		}
+		std::unique_lock<std::mutex> lock(m_items_file_mu);
 		m_items_file->seek(m_offsets.at(i), SEEK_SET);
 		BinaryArray data_cache(si);
 		m_items_file->read(reinterpret_cast<char *>(data_cache.data()), si);
@@ -85,36 +101,52 @@ BinaryArray LegacyBlockChainReader::get_block_data_by_index(Height i) {
 	}
 }
 
-const size_t MAX_PRELOAD_BLOCKS = 100;
-// const size_t MAX_PRELOAD_TOTAL_SIZE = 50 * 1024 * 1024;
+boost::variant<ConsensusError, PreparedBlock> LegacyBlockChainReader::prepare_block(Height height) {
+	BinaryArray rba = get_block_data_by_index(height);
+	try {
+		return PreparedBlock{std::move(rba), m_currency, nullptr};
+	} catch (const ConsensusError &ex) {
+		return ex;
+	} catch (const std::runtime_error &ex) {
+		return ConsensusError{"Runtime error - " + common::what(ex)};
+	} catch (const std::logic_error &ex) {  // TODO - terminate app
+		return ConsensusError{"Logic error - " + common::what(ex)};
+	}
+}
+
+const size_t MAX_PRELOAD_BLOCKS     = 1000;
+const size_t MAX_PRELOAD_TOTAL_SIZE = 50 * 1024 * 1024;  // raw size, prepared blocks take several times more
 
 void LegacyBlockChainReader::thread_run() {
 	while (true) {
-		Height to_load = 0;
+		Height to_load    = 0;
+		size_t size       = 0;
+		size_t generation = 0;
 		{
 			std::unique_lock<std::mutex> lock(m_mu);
 			if (m_quit)
 				return;
-			if (m_blocks_to_load.empty()) {
+			size = get_block_size(m_next_to_load);
+			// Empty window always accepts a block, otherwise a single huge block would stall import
+			if (m_next_to_load + 1 >= m_offsets.size() || m_next_to_load - m_window_start >= MAX_PRELOAD_BLOCKS ||
+			    (m_preload_size != 0 && m_preload_size + size > MAX_PRELOAD_TOTAL_SIZE)) {
 				m_have_work.wait(lock);
 				continue;
 			}
-			to_load = *m_blocks_to_load.begin();
-		}
-		boost::variant<ConsensusError, PreparedBlock> result = ConsensusError{""};
-		BinaryArray rba                                      = get_block_data_by_index(to_load);
-		try {
-			result = PreparedBlock{std::move(rba), m_currency, nullptr};
-		} catch (const ConsensusError &ex) {
-			result = ex;
-		} catch (const std::runtime_error &ex) {
-			result = ConsensusError{"Runtime error - " + common::what(ex)};
-		} catch (const std::logic_error &ex) {  // TODO - terminate app
-			result = ConsensusError{"Logic error - " + common::what(ex)};
+			to_load    = m_next_to_load++;
+			generation = m_window_generation;
+			m_preload_size += size;
 		}
+		auto result = prepare_block(to_load);
 		{
 			std::unique_lock<std::mutex> lock(m_mu);
-			m_blocks_to_load.erase(to_load);
+			if (generation != m_window_generation)
+				continue;  // m_preload_size was reset
+			if (to_load < m_window_start) {
+				m_preload_size -= size;
+				m_have_work.notify_all();
+				continue;
+			}
 			m_prepared_blocks.insert(std::make_pair(to_load, std::move(result)));
 			m_prepared_blocks_ready.notify_all();
 		}
@@ -123,29 +155,39 @@ void LegacyBlockChainReader::thread_run() {
 
 boost::variant<ConsensusError, PreparedBlock> LegacyBlockChainReader::get_prepared_block_by_index(Height height) {
 	load_offsets();
-	if (!multicore) {
-		BinaryArray rba = get_block_data_by_index(height);
-		return PreparedBlock{std::move(rba), m_currency, nullptr};
+	if (!multicore || height + 1 >= m_offsets.size())
+		return prepare_block(height);
+	std::unique_lock<std::mutex> lock(m_mu);
+	if (m_threads.empty()) {
+		auto th_count = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
+		for (size_t i = 0; i != th_count; ++i)
+			m_threads.emplace_back(&LegacyBlockChainReader::thread_run, this);
 	}
-	{
-		std::unique_lock<std::mutex> lock(m_mu);
-		if (!m_th.joinable())
-			m_th = std::thread(&LegacyBlockChainReader::thread_run, this);
-		for (Height i = height; i != height + MAX_PRELOAD_BLOCKS; ++i) {
-			if (m_prepared_blocks.count(i) == 0)
-				m_blocks_to_load.insert(i);
+	if (height < m_window_start) {  // going back, drop everything
+		m_window_generation += 1;
+		m_prepared_blocks.clear();
+		m_preload_size = 0;
+		m_next_to_load = height;
+	} else {  // skipping forward, drop blocks below height, those being prepared will be dropped by workers
+		while (!m_prepared_blocks.empty() && m_prepared_blocks.begin()->first < height) {
+			m_preload_size -= get_block_size(m_prepared_blocks.begin()->first);
+			m_prepared_blocks.erase(m_prepared_blocks.begin());
 		}
-		m_have_work.notify_all();
+		m_next_to_load = std::max(m_next_to_load, height);
 	}
+	m_window_start = height;
+	m_have_work.notify_all();
 	while (true) {
-		std::unique_lock<std::mutex> lock(m_mu);
 		auto pit = m_prepared_blocks.find(height);
 		if (pit == m_prepared_blocks.end()) {
 			m_prepared_blocks_ready.wait(lock);
 			continue;
 		}
 		boost::variant<ConsensusError, PreparedBlock> result = std::move(pit->second);
-		pit                                                  = m_prepared_blocks.erase(pit);
+		m_prepared_blocks.erase(pit);
+		m_preload_size -= get_block_size(height);
+		m_window_start = height + 1;
+		m_have_work.notify_all();
 		return result;
 	}
 }
@@ -155,8 +197,11 @@ bool LegacyBlockChainReader::import_blocks(BlockChainState *block_chain) {
 		auto idea_start = std::chrono::high_resolution_clock::now();
 		// size_t bs_count = std::min(block_chain.get_tip_height() + 1 + count, get_block_count());
 		while (block_chain->get_tip_height() + 1 < get_block_count()) {
-			BinaryArray rba = get_block_data_by_index(block_chain->get_tip_height() + 1);
-			PreparedBlock pb{std::move(rba), m_currency, nullptr};
+			boost::variant<ConsensusError, PreparedBlock> result =
+			    get_prepared_block_by_index(block_chain->get_tip_height() + 1);
+			if (const ConsensusError *err = boost::get<ConsensusError>(&result))
+				throw *err;
+			const PreparedBlock &pb = boost::get<PreparedBlock>(result);
 			api::BlockHeader info;
 			if (!block_chain->add_block(pb, &info, false, "blocks_file")) {
 				std::cout << "block_chain.add_block !BROADCAST_ALL block=" << block_chain->get_tip_height() + 1
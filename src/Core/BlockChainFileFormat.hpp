@@ -20,19 +20,27 @@ class BlockChainState;
 class LegacyBlockChainReader {
 	const Currency &m_currency;
 	std::unique_ptr<platform::FileStream> m_items_file;
+	std::unique_ptr<platform::MappedFile> m_items_mapped;  // if mapping failed, we read m_items_file under lock
+	std::mutex m_items_file_mu;
 	std::unique_ptr<platform::FileStream> m_indexes_file;
 	Height m_count = 0;
 	std::vector<uint64_t> m_offsets;  // we artificially add offset of the end of file
 	void load_offsets();
+	size_t get_block_size(Height) const;
+	boost::variant<ConsensusError, PreparedBlock> prepare_block(Height);
 
-	std::thread m_th;
+	std::vector<std::thread> m_threads;
 	std::mutex m_mu;
 	std::condition_variable m_have_work;
 	std::condition_variable m_prepared_blocks_ready;
 	bool m_quit = false;
 
+	// Workers prepare [m_window_start..m_next_to_load) ahead of consumer, limited by count and total raw size
+	Height m_window_start      = 0;
+	Height m_next_to_load      = 0;
+	size_t m_preload_size      = 0;  // includes blocks being prepared
+	size_t m_window_generation = 0;  // results of workers started before window reset are dropped
 	std::map<Height, boost::variant<ConsensusError, PreparedBlock>> m_prepared_blocks;
-	std::set<Height> m_blocks_to_load;
 	void thread_run();
 
 public:
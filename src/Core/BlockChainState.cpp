@@ -9,9 +9,11 @@
 #include "Currency.hpp"
 #include "TransactionExtra.hpp"
 #include "common/Math.hpp"
+#include "common/Metrics.hpp"
 #include "common/StringTools.hpp"
 #include "common/Varint.hpp"
 #include "crypto/crypto.hpp"
+#include "platform/PathTools.hpp"
 #include "platform/Time.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
@@ -31,7 +33,35 @@ using namespace platform;
 
 typedef std::pair<std::vector<size_t>, std::vector<size_t>> InputDesc;
 
+static const std::string STARTUP_CACHE_VERSION = "1";
+
+// Wallets that fell behind that many pool changes compare whole pool instead
+static const size_t MAX_POOL_CHANGES = 100000;
+
+struct StartupCache {
+	std::string version;  // STARTUP_CACHE_VERSION + DB version
+	Hash genesis_bid;
+	Height tip_height = 0;
+	Hash tip_bid;
+	std::vector<api::BlockHeader> tip_window;
+	Timestamp next_median_timestamp        = 0;
+	size_t next_median_size                = 0;
+	size_t next_median_block_capacity_vote = 0;
+	std::map<Amount, size_t> next_stack_indexes;
+};
+
 namespace seria {
+void ser_members(StartupCache &v, ISeria &s) {
+	seria_kv("version", v.version, s);
+	seria_kv("genesis_bid", v.genesis_bid, s);
+	seria_kv("tip_height", v.tip_height, s);
+	seria_kv("tip_bid", v.tip_bid, s);
+	seria_kv("tip_window", v.tip_window, s);
+	seria_kv("next_median_timestamp", v.next_median_timestamp, s);
+	seria_kv("next_median_size", v.next_median_size, s);
+	seria_kv("next_median_block_capacity_vote", v.next_median_block_capacity_vote, s);
+	seria_kv("next_stack_indexes", v.next_stack_indexes, s);
+}
 void ser_members(IBlockChainState::OutputIndexData &v, ISeria &s) {
 	seria_kv("amount", v.amount, s);
 	seria_kv("unlock_block_or_timestamp", v.unlock_block_or_timestamp, s);
@@ -43,15 +73,6 @@ void ser_members(IBlockChainState::OutputIndexData &v, ISeria &s) {
 }
 }  // namespace seria
 
-BlockChainState::PoolTransaction::PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee,
-    Timestamp timestamp, const Hash &newest_referenced_block)
-    : tx(tx)
-    , binary_tx(binary_tx)
-    , amount(get_tx_sum_outputs(tx))
-    , fee(fee)
-    , timestamp(timestamp)
-    , newest_referenced_block(newest_referenced_block) {}
-
 void BlockChainState::DeltaState::store_keyimage(const KeyImage &key_image, Height height) {
 	invariant(m_keyimages.insert(std::make_pair(key_image, height)).second, common::pod_to_hex(key_image));
 }
@@ -185,16 +206,26 @@ static Amount validate_tx_semantic(const Currency &currency, uint8_t block_major
 
 BlockChainState::BlockChainState(logging::ILogger &log, const Config &config, const Currency &currency, bool read_only)
     : BlockChain(log, config, currency, read_only)
-    , m_max_pool_size(config.max_pool_size)
+    , m_pool(config.max_pool_size)
+    , m_tx_pool_log_id(crypto::rand<uint64_t>() | 1)
     , m_log_redo_block_timestamp(std::chrono::steady_clock::now()) {
+	auto phase_start = std::chrono::steady_clock::now();
+	auto phase_ms    = [&]() {  // startup phases are logged to see what slows down restarts
+		const auto now = std::chrono::steady_clock::now();
+		const auto ms  = std::chrono::duration_cast<std::chrono::milliseconds>(now - phase_start).count();
+		phase_start    = now;
+		return ms;
+	};
 	std::string version;
 	m_db.get("$version", version);
+	if (version == "8")  // BlockChain upgrades to 9 in place
+		version = version_current;
 	if (version == "B" || version == "1" || version == "2" || version == "3" || version == "4" || version == "5" ||
 	    version == "6" || version == "7") {
 		start_internal_import();
 		version = version_current;
 		m_db.put("$version", version, false);
-		db_commit();
+		BlockChain::db_commit();  // our state is not ready for startup cache yet
 	}
 	// Upgrades from 5 should restart internal import if m_internal_import_chain is not empty
 	if (version != version_current)
@@ -210,22 +241,97 @@ BlockChainState::BlockChainState(logging::ILogger &log, const Config &config, co
 		api::BlockHeader info;
 		invariant(add_block(pb, &info, false, std::string{}), "Genesis block failed to add");
 	}
-	BlockChainState::tip_changed();
+	if (load_startup_cache()) {
+		m_log(logging::INFO) << "Startup cache loaded ms=" << phase_ms();
+	} else {
+		BlockChainState::tip_changed();
+		m_log(logging::INFO) << "Startup cache not valid, tip window and medians rebuilt ms=" << phase_ms();
+	}
 	m_log(logging::INFO) << "height=" << get_tip_height() << " bid=" << get_tip_bid()
 	                     << " cumulative_difficulty=" << get_tip_cumulative_difficulty();
 	build_blods();
+	m_log(logging::INFO) << "Block tree built ms=" << phase_ms();
 	DB::Cursor cur2 = m_db.rbegin(DIN_PREFIX);
 	m_next_nz_input_index =
 	    cur2.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur2.get_suffix())) + 1;
 	DB::Cursor cur3 = m_db.rbegin(OUTPUT_PREFIX);
 	m_next_global_key_output_index =
 	    cur3.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur3.get_suffix())) + 1;
+	m_log(logging::INFO) << "Output counters read ms=" << phase_ms();
 	//	m_db.debug_print_index_size(KEYIMAGE_PREFIX);
 	//	m_db.debug_print_index_size(AMOUNT_OUTPUT_PREFIX);
 	//	m_db.debug_print_index_size(OUTPUT_PREFIX);
 	//	m_db.debug_print_index_size(DIN_PREFIX);
 }
 
+void BlockChainState::db_commit() {
+	BlockChain::db_commit();
+	save_startup_cache();
+}
+
+std::string BlockChainState::get_startup_cache_path() const {
+	return m_config.get_data_folder() + "/blockchain_startup_cache";
+}
+
+bool BlockChainState::load_startup_cache() {
+	BinaryArray data;
+	if (!platform::load_file(get_startup_cache_path(), data))
+		return false;
+	StartupCache cache;
+	try {
+		seria::from_binary(cache, data);
+	} catch (const std::exception &ex) {
+		m_log(logging::WARNING) << "Startup cache corrupted, ignoring - " << common::what(ex);
+		return false;
+	}
+	if (cache.version != STARTUP_CACHE_VERSION + version_current || cache.genesis_bid != m_genesis_bid ||
+	    cache.tip_height != get_tip_height() || cache.tip_bid != get_tip_bid())
+		return false;
+	if (!set_tip_window(std::deque<api::BlockHeader>(cache.tip_window.begin(), cache.tip_window.end())))
+		return false;
+	m_next_median_timestamp           = cache.next_median_timestamp;
+	m_next_median_size                = cache.next_median_size;
+	m_next_median_block_capacity_vote = cache.next_median_block_capacity_vote;
+	m_next_stack_index.insert(cache.next_stack_indexes.begin(), cache.next_stack_indexes.end());
+	if (m_config.paranoid_checks)
+		invariant(is_tip_state_consistent(), "Startup cache differs from state rebuilt from DB");
+	return true;
+}
+
+bool BlockChainState::is_tip_state_consistent() const {
+	// Window first, because medians are calculated from it
+	for (const auto &header : get_tip_window()) {
+		BinaryArray stored;
+		if (!get_header_data(header.hash, &stored) || stored != seria::to_binary(header))
+			return false;
+	}
+	if (m_next_median_timestamp != calculate_next_median_timestamp(get_tip()) ||
+	    m_next_median_size != calculate_next_median_size(get_tip()) ||
+	    m_next_median_block_capacity_vote != calculate_next_median_block_capacity_vote(get_tip()))
+		return false;
+	for (const auto &sit : m_next_stack_index)
+		if (sit.second != read_next_stack_index(sit.first))
+			return false;
+	return true;
+}
+
+void BlockChainState::save_startup_cache() const {
+	StartupCache cache;
+	cache.version     = STARTUP_CACHE_VERSION + version_current;
+	cache.genesis_bid = m_genesis_bid;
+	cache.tip_height  = get_tip_height();
+	cache.tip_bid     = get_tip_bid();
+	cache.tip_window.assign(get_tip_window().begin(), get_tip_window().end());
+	cache.next_median_timestamp           = m_next_median_timestamp;
+	cache.next_median_size                = m_next_median_size;
+	cache.next_median_block_capacity_vote = m_next_median_block_capacity_vote;
+	cache.next_stack_indexes.insert(m_next_stack_index.begin(), m_next_stack_index.end());
+	const BinaryArray data = seria::to_binary(cache);
+	const std::string path = get_startup_cache_path();
+	if (!platform::atomic_save_file(path, data.data(), data.size(), path + ".tmp"))
+		m_log(logging::WARNING) << "Failed to save startup cache to " << path;
+}
+
 void BlockChainState::check_consensus(
     const PreparedBlock &pb, api::BlockHeader *info, const api::BlockHeader &prev_info, bool check_pow) const {
 	const auto &block = pb.block;
@@ -380,9 +486,9 @@ void BlockChainState::check_consensus(
 }
 void BlockChainState::fill_statistics(api::cnd::GetStatistics::Response &res) const {
 	BlockChain::fill_statistics(res);
-	res.transaction_pool_count               = m_memory_state_tx.size();
-	res.transaction_pool_size                = m_memory_state_total_size;
-	res.transaction_pool_max_size            = m_max_pool_size;
+	res.transaction_pool_count               = m_pool.get_transactions().size();
+	res.transaction_pool_size                = m_pool.get_total_size();
+	res.transaction_pool_max_size            = m_pool.get_max_size();
 	res.transaction_pool_lowest_fee_per_byte = minimum_pool_fee_per_byte(false);
 	res.node_database_size                   = m_db.test_get_approximate_size();
 }
@@ -489,31 +595,20 @@ void BlockChainState::create_mining_block_template(const Hash &parent_bid, const
 		max_txs_size = max_consensus_transactions_size - m_currency.miner_tx_blob_reserved_size - extra_nonce.size();
 	}
 
-	std::vector<Hash> pool_hashes;
-	for (auto &&msf : m_memory_state_fee_tx)
-		pool_hashes.push_back(msf.second);
 	size_t txs_size = 0;
 	Amount txs_fee  = 0;
 	//	DeltaState memory_state(*height, b->timestamp, next_median_timestamp, this);
 
-	for (; !pool_hashes.empty(); pool_hashes.pop_back()) {
-		auto tit = m_memory_state_tx.find(pool_hashes.back());
-		if (tit == m_memory_state_tx.end()) {
-			m_log(logging::ERROR) << "Transaction " << pool_hashes.back() << " is in pool index, but not in pool";
-			continue;
-		}
-		const size_t tx_size = tit->second.binary_tx.size();
-		const Amount tx_fee  = tit->second.fee;
-		if (txs_size + tx_size > max_txs_size)
-			continue;
-		if (!is_amethyst && txs_size + tx_size > effective_size_median)
-			continue;  // Effective median size will not grow anyway
-		txs_size += tx_size;
-		txs_fee += tx_fee;
-		b->transaction_hashes.emplace_back(tit->first);
-		m_mining_transactions.erase(tit->first);  // We want ot update height to most recent
-		m_mining_transactions.insert(std::make_pair(tit->first, std::make_pair(tit->second.binary_tx, *height)));
-		m_log(logging::TRACE) << "Transaction " << tit->first << " included to block template";
+	// Before amethyst, effective median size will not grow anyway
+	const size_t selection_size = is_amethyst ? max_txs_size : std::min(max_txs_size, effective_size_median);
+	for (const Hash &tid : m_pool.select_for_block(selection_size)) {
+		const PoolTransaction &ptx = *m_pool.find(tid);
+		txs_size += ptx.binary_tx.size();
+		txs_fee += ptx.fee;
+		b->transaction_hashes.emplace_back(tid);
+		m_mining_transactions.erase(tid);  // We want ot update height to most recent
+		m_mining_transactions.insert(std::make_pair(tid, std::make_pair(ptx.binary_tx, *height)));
+		m_log(logging::TRACE) << "Transaction " << tid << " included to block template";
 	}
 	if (crypto::rand<unsigned>() % 2 == 1)
 		std::reverse(b->transaction_hashes.begin(), b->transaction_hashes.end());
@@ -521,14 +616,7 @@ void BlockChainState::create_mining_block_template(const Hash &parent_bid, const
 	if (is_amethyst) {
 		// Vote for larger blocks if pool is full of expensive transactions
 		Amount desired_fee_per_byte = 100;
-		size_t block_capacity_vote  = 0;
-		for (auto fit = m_memory_state_fee_tx.rbegin(); fit != m_memory_state_fee_tx.rend(); ++fit) {
-			if (fit->first < desired_fee_per_byte)
-				break;
-			auto tit = m_memory_state_tx.find(fit->second);
-			invariant(tit != m_memory_state_tx.end(), "Memory pool corrupted");
-			block_capacity_vote += tit->second.binary_tx.size();
-		}
+		size_t block_capacity_vote  = m_pool.get_size_with_fee_per_byte_at_least(desired_fee_per_byte);
 		block_capacity_vote += m_currency.block_capacity_vote_min / 2;  // A bit of space for cheaper transactions
 		block_capacity_vote = std::max(block_capacity_vote, m_currency.block_capacity_vote_min);
 		block_capacity_vote = std::min(block_capacity_vote, m_currency.block_capacity_vote_max);
@@ -602,10 +690,10 @@ bool BlockChainState::add_mined_block(
 	raw_block->transactions.reserve(block_template.transaction_hashes.size());
 	raw_block->transactions.clear();
 	for (const auto &tx_hash : block_template.transaction_hashes) {
-		auto tit                     = m_memory_state_tx.find(tx_hash);
+		const PoolTransaction *ptx   = m_pool.find(tx_hash);
 		const BinaryArray *binary_tx = nullptr;
-		if (tit != m_memory_state_tx.end())
-			binary_tx = &(tit->second.binary_tx);
+		if (ptx)
+			binary_tx = &ptx->binary_tx;
 		else {
 			auto tit2 = m_mining_transactions.find(tx_hash);
 			if (tit2 == m_mining_transactions.end()) {
@@ -631,31 +719,18 @@ void BlockChainState::clear_mining_transactions() const {
 }
 
 Amount BlockChainState::minimum_pool_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid) const {
-	if (m_memory_state_fee_tx.empty()) {
-		if (minimal_tid)
-			*minimal_tid = Hash{};
-		return 0;
-	}
-	if (zero_if_not_full && m_memory_state_total_size < m_max_pool_size) {
-		if (minimal_tid)
-			*minimal_tid = Hash{};
-		return 0;
-	}
-	auto be = m_memory_state_fee_tx.begin();
+	const MemPool::Priority minimal = m_pool.get_minimal_priority(zero_if_not_full);
 	if (minimal_tid)
-		*minimal_tid = be->second;
-	return be->first;
+		*minimal_tid = minimal.second;
+	return minimal.first;
 }
 
 void BlockChainState::on_reorganization(
     const std::map<Hash, std::pair<Transaction, BinaryArray>> &undone_transactions, bool undone_blocks) {
 	// TODO - remove/add only those transactions that could have their referenced output keys changed
 	if (undone_blocks) {
-		PoolTransMap old_memory_state_tx;
-		std::swap(old_memory_state_tx, m_memory_state_tx);
-		m_memory_state_ki_tx.clear();
-		m_memory_state_fee_tx.clear();
-		m_memory_state_total_size = 0;
+		PoolTransMap old_memory_state_tx = m_pool.extract_all();
+		reset_pool_changes();  // wallets will compare whole pool once
 		for (auto &&msf : old_memory_state_tx) {
 			try {
 				add_transaction(msf.first, msf.second.tx, msf.second.binary_tx, true, std::string{});
@@ -674,31 +749,12 @@ void BlockChainState::on_reorganization(
 
 std::vector<TransactionDesc> BlockChainState::sync_pool(
     const std::pair<Amount, Hash> &from, const std::pair<Amount, Hash> &to, size_t max_count) const {
-	std::vector<TransactionDesc> result;
-	auto sit = m_memory_state_fee_tx.lower_bound(from);
-	if (sit != m_memory_state_fee_tx.end()) {
-		if (*sit != from)
-			++sit;
-	}
-	while (sit != m_memory_state_fee_tx.begin()) {
-		--sit;
-		if (result.size() > max_count || *sit <= to)
-			break;
-		TransactionDesc desc;
-		desc.hash = sit->second;
-		auto tit  = m_memory_state_tx.find(desc.hash);
-		invariant(tit != m_memory_state_tx.end(), "");
-		desc.fee                     = tit->second.fee;
-		desc.size                    = tit->second.binary_tx.size();
-		desc.newest_referenced_block = tit->second.newest_referenced_block;
-		result.push_back(desc);
-	}
-	return result;
+	return m_pool.get_descs(from, to, max_count);
 }
 
 bool BlockChainState::add_transaction(const Hash &tid, const Transaction &tx, const BinaryArray &binary_tx,
     bool check_sigs, const std::string &source_address) {
-	if (m_memory_state_tx.count(tid) != 0) {
+	if (m_pool.find(tid)) {
 		m_archive.add(Archive::TRANSACTION, binary_tx, tid, source_address);
 		return false;  // AddTransactionResult::ALREADY_IN_POOL;
 	}
@@ -708,21 +764,20 @@ bool BlockChainState::add_transaction(const Hash &tid, const Transaction &tx, co
 	Hash minimal_tid;
 	Amount minimal_fee = minimum_pool_fee_per_byte(false, &minimal_tid);
 	// Invariant is if 1 byte of cheapest transaction fits, then all transaction fits
-	if (m_memory_state_total_size >= m_max_pool_size && my_fee_per_byte < minimal_fee)
+	if (m_pool.is_full() && my_fee_per_byte < minimal_fee)
 		return false;  // AddTransactionResult::INCREASE_FEE;
 	// Deterministic behaviour here and below so tx pools have tendency to stay the same
-	if (m_memory_state_total_size >= m_max_pool_size && my_fee_per_byte == minimal_fee && tid < minimal_tid)
+	if (m_pool.is_full() && my_fee_per_byte == minimal_fee && tid < minimal_tid)
 		return false;  // AddTransactionResult::INCREASE_FEE;
 	for (const auto &input : tx.inputs) {
 		if (const auto *in = boost::get<InputKey>(&input)) {
-			auto tit = m_memory_state_ki_tx.find(in->key_image);
-			if (tit == m_memory_state_ki_tx.end())
+			const Hash *other_tid = m_pool.find_keyimage(in->key_image);
+			if (!other_tid)
 				continue;
-			const PoolTransaction &other_tx = m_memory_state_tx.at(tit->second);
-			const Amount other_fee_per_byte = other_tx.fee_per_byte();
+			const Amount other_fee_per_byte = m_pool.find(*other_tid)->fee_per_byte();
 			if (my_fee_per_byte < other_fee_per_byte)
 				return false;  // AddTransactionResult::INCREASE_FEE;
-			if (my_fee_per_byte == other_fee_per_byte && tid < tit->second)
+			if (my_fee_per_byte == other_fee_per_byte && tid < *other_tid)
 				return false;  // AddTransactionResult::INCREASE_FEE;
 			break;  // Can displace another transaction from the pool, Will have to make heavy-lifting for this tx
 		}
@@ -749,52 +804,65 @@ bool BlockChainState::add_transaction(const Hash &tid, const Transaction &tx, co
 	// space there
 	//	update_first_seen_timestamp(tid, unlock_timestamp);
 	for (auto &&ki : memory_state.get_keyimages()) {
-		auto tit = m_memory_state_ki_tx.find(ki.first);
-		if (tit == m_memory_state_ki_tx.end())
+		const Hash *other_tid = m_pool.find_keyimage(ki.first);
+		if (!other_tid)
 			continue;
-		const PoolTransaction &other_tx = m_memory_state_tx.at(tit->second);
-		const Amount other_fee_per_byte = other_tx.fee_per_byte();
+		const Amount other_fee_per_byte = m_pool.find(*other_tid)->fee_per_byte();
 		if (my_fee_per_byte < other_fee_per_byte)
 			return false;  // AddTransactionResult::INCREASE_FEE;  // Never because checked above
-		if (my_fee_per_byte == other_fee_per_byte && tid < tit->second)
+		if (my_fee_per_byte == other_fee_per_byte && tid < *other_tid)
 			return false;  // AddTransactionResult::INCREASE_FEE;  // Never because checked above
-		remove_from_pool(tit->second);
-	}
-	bool all_inserted = true;
-	for (auto &&ki : memory_state.get_keyimages()) {
-		if (!m_memory_state_ki_tx.insert(std::make_pair(ki.first, tid)).second)
-			all_inserted = false;
+		remove_from_pool(*other_tid);
 	}
 	const auto now = platform::now_unix_timestamp();
-	if (!m_memory_state_tx
-	         .insert(std::make_pair(tid, PoolTransaction{tx, binary_tx, my_fee, now, newest_referenced_bid}))
-	         .second)
-		all_inserted = false;
-	if (!m_memory_state_fee_tx.insert(std::make_pair(my_fee_per_byte, tid)).second)
-		all_inserted = false;
-	// insert all before throw
-	invariant(all_inserted, "memory_state_fee_tx empty");
-	m_memory_state_total_size += my_size;
-	while (m_memory_state_total_size > m_max_pool_size) {
-		invariant(!m_memory_state_fee_tx.empty(), "memory_state_fee_tx empty");
-		//		auto &be = m_memory_state_fee_tx.begin()->second;
-		//		invariant(!be.empty(), "memory_state_fee_tx empty set");
-		Hash rhash                        = m_memory_state_fee_tx.begin()->second;
-		const PoolTransaction &minimal_tx = m_memory_state_tx.at(rhash);
-		if (m_memory_state_total_size < m_max_pool_size + minimal_tx.binary_tx.size())
-			break;  // Removing would diminish pool below max size
+	m_pool.insert(tid, PoolTransaction{tx, binary_tx, my_fee, now, newest_referenced_bid});
+	Hash rhash;
+	while (m_pool.get_eviction_candidate(&rhash))
 		remove_from_pool(rhash);
-	}
-	auto min_size = m_memory_state_fee_tx.empty()
-	                    ? 0
-	                    : m_memory_state_tx.at(m_memory_state_fee_tx.begin()->second).binary_tx.size();
-	auto min_fee_per_byte = m_memory_state_fee_tx.empty() ? 0 : m_memory_state_fee_tx.begin()->first;
 	m_log(logging::INFO) << "Added transaction with hash=" << tid << " size=" << my_size << " fee=" << my_fee
-	                     << " fee/byte=" << my_fee_per_byte << " current_pool_size=("
-	                     << m_memory_state_total_size - min_size << "+" << min_size << ")=" << m_memory_state_total_size
-	                     << " count=" << m_memory_state_tx.size() << " min fee/byte=" << min_fee_per_byte;
+	                     << " fee/byte=" << my_fee_per_byte << " " << pool_size_description();
 	m_archive.add(Archive::TRANSACTION, binary_tx, tid, source_address);
+	log_pool_change(tid, true);
+	return true;
+}
+
+std::string BlockChainState::pool_size_description() const {
+	const MemPool::Priority minimal = m_pool.get_minimal_priority(false);
+	const size_t min_size = m_pool.get_transactions().empty() ? 0 : m_pool.find(minimal.second)->binary_tx.size();
+	return common::to_string("current_pool_size=(", m_pool.get_total_size() - min_size, "+", min_size,
+	    ")=", m_pool.get_total_size(), " count=", m_pool.get_transactions().size(), " min fee/byte=", minimal.first);
+}
+
+void BlockChainState::log_pool_change(const Hash &tid, bool added) {
 	m_tx_pool_version += 1;
+	m_tx_pool_changes.push_back(PoolChange{tid, added});
+	if (m_tx_pool_changes.size() > MAX_POOL_CHANGES)
+		m_tx_pool_changes.pop_front();
+}
+
+void BlockChainState::reset_pool_changes() {
+	m_tx_pool_version += 1;
+	m_tx_pool_changes.clear();
+}
+
+bool BlockChainState::get_tx_pool_changes(
+    size_t since_version, std::vector<Hash> *added, std::vector<Hash> *removed) const {
+	if (since_version > m_tx_pool_version || m_tx_pool_version - since_version > m_tx_pool_changes.size())
+		return false;
+	// Transaction can be added and removed several times, caller had it if first change is removal
+	std::map<Hash, std::pair<bool, bool>> first_last_added;
+	for (size_t i = m_tx_pool_changes.size() - (m_tx_pool_version - since_version); i != m_tx_pool_changes.size();
+	     ++i) {
+		const auto &change = m_tx_pool_changes[i];
+		auto fit           = first_last_added.insert(std::make_pair(change.tid, std::make_pair(change.added, false)));
+		fit.first->second.second = change.added;
+	}
+	for (const auto &fl : first_last_added) {
+		if (!fl.second.first)
+			removed->push_back(fl.first);
+		if (fl.second.second)
+			added->push_back(fl.first);
+	}
 	return true;
 }
 
@@ -827,35 +895,14 @@ bool BlockChainState::get_largest_referenced_height(const TransactionPrefix &tra
 }
 
 void BlockChainState::remove_from_pool(Hash tid) {
-	auto tit = m_memory_state_tx.find(tid);
-	if (tit == m_memory_state_tx.end())
+	const PoolTransaction *ptx = m_pool.find(tid);
+	if (!ptx)
 		return;
-	bool all_erased       = true;
-	const Transaction &tx = tit->second.tx;
-	for (const auto &input : tx.inputs) {
-		if (const auto *in = boost::get<InputKey>(&input)) {
-			if (m_memory_state_ki_tx.erase(in->key_image) != 1)
-				all_erased = false;
-		}
-	}
-	const size_t my_size         = tit->second.binary_tx.size();
-	const Amount my_fee_per_byte = tit->second.fee_per_byte();
-	if (m_memory_state_fee_tx.erase(std::make_pair(my_fee_per_byte, tid)) != 1)
-		all_erased = false;
-	//	if (m_memory_state_fee_tx[my_fee_per_byte].empty())
-	//		m_memory_state_fee_tx.erase(my_fee_per_byte);
-	m_memory_state_total_size -= my_size;
-	m_memory_state_tx.erase(tit);
-	invariant(all_erased, "remove_memory_pool failed to erase everything");
-	// We do not increment m_tx_pool_version, because removing tx from pool is
-	// always followed by reset or increment
-	auto min_size = m_memory_state_fee_tx.empty()
-	                    ? 0
-	                    : m_memory_state_tx.at(m_memory_state_fee_tx.begin()->second).binary_tx.size();
-	auto min_fee_per_byte = m_memory_state_fee_tx.empty() ? 0 : m_memory_state_fee_tx.begin()->first;
-	m_log(logging::INFO) << "Removed transaction with hash=" << tid << " size=" << my_size << " current_pool_size=("
-	                     << m_memory_state_total_size - min_size << "+" << min_size << ")=" << m_memory_state_total_size
-	                     << " count=" << m_memory_state_tx.size() << " min fee/byte=" << min_fee_per_byte;
+	const size_t my_size = ptx->binary_tx.size();
+	m_pool.erase(tid);
+	log_pool_change(tid, false);
+	m_log(logging::INFO) << "Removed transaction with hash=" << tid << " size=" << my_size << " "
+	                     << pool_size_description();
 }
 
 // Called only on transactions which passed validate_tx_semantic()
@@ -992,23 +1039,32 @@ void BlockChainState::redo_block(const Block &block,
 }
 
 void BlockChainState::redo_block(const Hash &bhash, const Block &block, const api::BlockHeader &info) {
+	static auto &redo_block_seconds =
+	    common::metrics::registry().histogram("redo_block_seconds", "BlockChainState::redo_block duration");
+	common::metrics::ScopeTimer timer(redo_block_seconds);
 	DeltaState delta(info.height, info.timestamp, info.timestamp_median, this);
 	BlockStackIndexes stack_indexes;
 	stack_indexes.reserve(block.transactions.size() + 1);
 	const bool check_sigs = m_config.paranoid_checks || !m_currency.is_in_hard_checkpoint_zone(info.height + 1);
 	if (check_sigs) {
+		BlockTrace::Timer trace_timer(m_trace, BlockTrace::RING_ARGS);
 		m_ring_checker.start_batch();
 		// block.header.base_transaction has no signatures
 		for (const auto &tx : block.transactions)
 			m_ring_checker.add_work(fill_ring_check_args(
 			    tx, block.header.major_version, info.height, info.timestamp, info.timestamp_median));
 	}
-	redo_block(block, info, &delta, &stack_indexes);
+	{
+		BlockTrace::Timer trace_timer(m_trace, BlockTrace::REDO);
+		redo_block(block, info, &delta, &stack_indexes);
+	}
 	if (check_sigs) {
+		BlockTrace::Timer trace_timer(m_trace, BlockTrace::RING_WAIT);
 		auto errors = m_ring_checker.move_batch_errors();
 		if (!errors.empty())
 			throw errors.front();  // We report first error only
 	}
+	BlockTrace::Timer trace_timer(m_trace, BlockTrace::APPLY);
 	delta.apply(this);  // Will remove from pool by key_image
 	for (auto tit = block.transactions.begin(); tit != block.transactions.end(); ++tit) {
 		const auto tid = block.header.transaction_hashes.at(tit - block.transactions.begin());
@@ -1070,11 +1126,21 @@ bool BlockChainState::read_block_output_stack_indexes(const Hash &bid, BlockStac
 }
 
 api::cnd::SyncBlocks::RawBlockCompact BlockChainState::fill_sync_block_compact(const Hash &bid) const {
-	api::cnd::SyncBlocks::RawBlockCompact res_block;
-	invariant(get_header(bid, &res_block.header), "Block header must be there");
-
+	api::BlockHeader header;
+	invariant(get_header(bid, &header), "Block header must be there");
 	RawBlock rb;
 	invariant(get_block(bid, &rb), "Block must be there, but it is not there");
+	BlockStackIndexes output_stack_indexes;
+	invariant(read_block_output_stack_indexes(bid, &output_stack_indexes),
+	    "Invariant dead - bid is in chain but blockchain has no block indexes");
+	return fill_sync_block_compact(std::move(header), rb, std::move(output_stack_indexes));
+}
+
+api::cnd::SyncBlocks::RawBlockCompact BlockChainState::fill_sync_block_compact(
+    api::BlockHeader &&header, const RawBlock &rb, BlockStackIndexes &&output_stack_indexes) {
+	api::cnd::SyncBlocks::RawBlockCompact res_block;
+	res_block.header = std::move(header);
+
 	Block block(rb);
 	res_block.base_transaction   = block.header.base_transaction;
 	res_block.transaction_hashes = block.header.transaction_hashes;
@@ -1085,8 +1151,7 @@ api::cnd::SyncBlocks::RawBlockCompact BlockChainState::fill_sync_block_compact(c
 		res_block.transaction_sizes.at(tx_index) = rb.transactions.at(tx_index).size();
 		res_block.raw_transactions.at(tx_index)  = std::move(block.transactions.at(tx_index));
 	}
-	invariant(read_block_output_stack_indexes(bid, &res_block.output_stack_indexes),
-	    "Invariant dead - bid is in chain but blockchain has no block indexes");
+	res_block.output_stack_indexes = std::move(output_stack_indexes);
 	return res_block;
 }
 
@@ -1165,10 +1230,9 @@ std::vector<api::Output> BlockChainState::get_random_outputs(uint8_t block_major
 void BlockChainState::store_keyimage(const KeyImage &key_image, Height height) {
 	auto key = KEYIMAGE_PREFIX + DB::to_binary_key(key_image.data, sizeof(key_image.data));
 	m_db.put(key, seria::to_binary(height), true);
-	auto tit = m_memory_state_ki_tx.find(key_image);
-	if (tit == m_memory_state_ki_tx.end())
-		return;
-	remove_from_pool(tit->second);
+	const Hash *tid = m_pool.find_keyimage(key_image);
+	if (tid)
+		remove_from_pool(*tid);
 }
 
 void BlockChainState::delete_keyimage(const KeyImage &key_image) {
@@ -1235,13 +1299,17 @@ size_t BlockChainState::next_stack_index_for_amount(Amount amount) const {
 	auto it = m_next_stack_index.find(amount);
 	if (it != m_next_stack_index.end())
 		return it->second;
-	std::string prefix = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount);
-	DB::Cursor cur2    = m_db.rbegin(prefix);
-	size_t alt_in = cur2.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur2.get_suffix())) + 1;
+	const size_t alt_in        = read_next_stack_index(amount);
 	m_next_stack_index[amount] = alt_in;
 	return alt_in;
 }
 
+size_t BlockChainState::read_next_stack_index(Amount amount) const {
+	std::string prefix = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount);
+	DB::Cursor cur2    = m_db.rbegin(prefix);
+	return cur2.end() ? 0 : common::integer_cast<size_t>(common::read_varint_sqlite4(cur2.get_suffix())) + 1;
+}
+
 bool BlockChainState::read_hidden_amount_map(Amount amount, size_t stack_index, size_t *hidden_index) const {
 	auto key = AMOUNT_OUTPUT_PREFIX + common::write_varint_sqlite4(amount) + common::write_varint_sqlite4(stack_index);
 	BinaryArray rb;
@@ -6,6 +6,7 @@
 #include <set>
 #include <unordered_map>
 #include "BlockChain.hpp"
+#include "MemPool.hpp"
 #include "Multicore.hpp"
 #include "crypto/hash.hpp"
 
@@ -43,12 +44,19 @@ public:
 	};
 	BlockChainState(logging::ILogger &, const Config &, const Currency &, bool read_only);
 
+	void db_commit() override;  // also saves startup cache for committed tip
+	// Tip window, medians and stack indexes equal to rebuilt from DB, checked after loading startup cache
+	bool is_tip_state_consistent() const;
+
 	std::vector<api::Output> get_random_outputs(uint8_t block_major_version, Amount, size_t output_count, Height,
 	    Timestamp block_timestamp, Timestamp block_median_timestamp) const;
 	typedef std::vector<std::vector<size_t>> BlockStackIndexes;
 	bool read_block_output_stack_indexes(const Hash &bid, BlockStackIndexes *) const;
 	bool read_block_output_stack_indexes_data(const Hash &bid, BinaryArray *) const;
 	api::cnd::SyncBlocks::RawBlockCompact fill_sync_block_compact(const Hash &bid) const;
+	// Part without DB access, so can be run in parallel
+	static api::cnd::SyncBlocks::RawBlockCompact fill_sync_block_compact(
+	    api::BlockHeader &&header, const RawBlock &rb, BlockStackIndexes &&output_stack_indexes);
 
 	Amount minimum_pool_fee_per_byte(bool zero_if_not_full, Hash *minimal_tid = nullptr) const;
 	bool add_transaction(const Hash &tid, const Transaction &, const BinaryArray &binary_tx, bool check_sigs,
@@ -56,20 +64,12 @@ public:
 	bool get_largest_referenced_height(const TransactionPrefix &tx, Height *block_height) const;
 
 	size_t get_tx_pool_version() const { return m_tx_pool_version; }
-	struct PoolTransaction {
-		Transaction tx;
-		BinaryArray binary_tx;
-		Amount amount;
-		Amount fee;
-		Timestamp timestamp;
-		Hash newest_referenced_block;
-
-		PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee, Timestamp timestamp,
-		    const Hash &newest_referenced_block);
-		Amount fee_per_byte() const { return fee / binary_tx.size(); }
-	};
-	typedef std::map<Hash, PoolTransaction> PoolTransMap;
-	const PoolTransMap &get_memory_state_transactions() const { return m_memory_state_tx; }
+	uint64_t get_tx_pool_log_id() const { return m_tx_pool_log_id; }  // versions of other id are not comparable
+	// false if changes since version are no longer (or not yet) in log, then caller must compare whole pool
+	bool get_tx_pool_changes(size_t since_version, std::vector<Hash> *added, std::vector<Hash> *removed) const;
+	typedef MemPool::PoolTransaction PoolTransaction;
+	typedef MemPool::PoolTransMap PoolTransMap;
+	const PoolTransMap &get_memory_state_transactions() const { return m_pool.get_transactions(); }
 	std::vector<TransactionDesc> sync_pool(
 	    const std::pair<Amount, Hash> &from, const std::pair<Amount, Hash> &to, size_t max_count) const;
 
@@ -143,18 +143,25 @@ private:
 
 	void undo_transaction(IBlockChainState *delta_state, Height, const Transaction &);
 
-	const size_t m_max_pool_size;
+	MemPool m_pool;
 	mutable crypto::CryptoNightContext m_hash_crypto_context;
 	mutable std::unordered_map<Amount, size_t> m_next_stack_index;
 	// Read from db on first use, write on modification
+	size_t read_next_stack_index(Amount) const;
 
 	void remove_from_pool(Hash tid);
 
 	size_t m_tx_pool_version = 1;  // Incremented every time pool changes, TODO cycle
-	PoolTransMap m_memory_state_tx;
-	std::map<KeyImage, Hash> m_memory_state_ki_tx;
-	std::set<std::pair<Amount, Hash>> m_memory_state_fee_tx;
-	size_t m_memory_state_total_size = 0;
+	// Change number m_tx_pool_version is at m_tx_pool_changes.back(), so wallets can ask for changes since version
+	struct PoolChange {
+		Hash tid;
+		bool added = false;
+	};
+	const uint64_t m_tx_pool_log_id;
+	std::deque<PoolChange> m_tx_pool_changes;
+	void log_pool_change(const Hash &tid, bool added);
+	std::string pool_size_description() const;  // for logging
+	void reset_pool_changes();
 
 	mutable std::map<Hash, std::pair<BinaryArray, Height>> m_mining_transactions;
 	// We remember them for several blocks
@@ -174,6 +181,11 @@ private:
 	size_t calculate_next_median_size(const api::BlockHeader &prev_info) const;
 	size_t calculate_next_median_block_capacity_vote(const api::BlockHeader &prev_info) const;
 
+	// Tip window, medians and stack indexes are saved to side file and used on startup if tip matches
+	std::string get_startup_cache_path() const;
+	bool load_startup_cache();
+	void save_startup_cache() const;
+
 	RingCheckerMulticore m_ring_checker;
 	RingSignatureCheckArgs fill_ring_check_args(const Transaction &transaction, uint8_t major_block_version,
 	    Height unlock_height, Timestamp block_timestamp, Timestamp block_median_timestamp) const;
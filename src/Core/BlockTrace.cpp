@@ -0,0 +1,155 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "BlockTrace.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "common/StringTools.hpp"
+#include "platform/Files.hpp"
+#include "platform/PathTools.hpp"
+
+using namespace cn;
+
+static const size_t FLUSH_SIZE = 64 * 1024;
+
+const char *BlockTrace::phase_name(Phase phase) {
+	static const char *const names[PHASE_COUNT] = {
+	    "parse", "pow", "ring_args", "ring_wait", "redo", "apply", "index", "commit"};
+	return names[phase];
+}
+
+BlockTrace::BlockTrace(const std::string &path) {
+	if (path.empty())
+		return;
+	m_file = std::make_unique<platform::FileStream>(path, platform::O_CREATE_ALWAYS);
+	m_buffer += "height,transactions";
+	for (size_t i = 0; i != PHASE_COUNT; ++i)
+		m_buffer += std::string(",") + phase_name(static_cast<Phase>(i)) + "_us";
+	m_buffer += "\n";
+}
+
+BlockTrace::~BlockTrace() {
+	try {
+		flush();
+	} catch (const std::exception &) {
+	}  // Trace is diagnostics only, we never fail on it
+}
+
+void BlockTrace::set_prepared(const Hash &bid, Duration parse, Duration pow) {
+	m_prepared_bid   = bid;
+	m_prepared_parse = parse;
+	m_prepared_pow   = pow;
+}
+
+void BlockTrace::begin_block(const Hash &bid, Height height, size_t transaction_count) {
+	if (!enabled())
+		return;
+	if (m_has_block)
+		write_block();
+	m_has_block         = true;
+	m_height            = height;
+	m_transaction_count = transaction_count;
+	m_phases.fill(Duration{});
+	if (bid == m_prepared_bid) {
+		m_phases[PARSE] = m_prepared_parse;
+		m_phases[POW]   = m_prepared_pow;
+		m_prepared_bid  = Hash{};
+	}
+}
+
+void BlockTrace::add(Phase phase, Duration duration) {
+	if (m_has_block)
+		m_phases.at(phase) += duration;
+}
+
+void BlockTrace::write_block() {
+	m_buffer += std::to_string(m_height) + "," + std::to_string(m_transaction_count);
+	for (const auto &d : m_phases)
+		m_buffer += "," + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+	m_buffer += "\n";
+	m_has_block = false;
+	if (m_buffer.size() >= FLUSH_SIZE)
+		flush();
+}
+
+void BlockTrace::flush() {
+	if (!enabled())
+		return;
+	if (m_has_block)
+		write_block();
+	m_file->write(m_buffer.data(), m_buffer.size());
+	m_buffer.clear();
+}
+
+void BlockTrace::summarize(const std::string &path, std::ostream &out) {
+	std::string body;
+	if (!platform::load_file(path, body))
+		throw std::runtime_error("Failed to load block trace " + path);
+	struct Line {
+		Height height       = 0;
+		size_t transactions = 0;
+		uint64_t total_us   = 0;
+	};
+	std::vector<Line> lines;
+	std::array<uint64_t, PHASE_COUNT> totals{};
+	std::array<uint64_t, PHASE_COUNT> maxes{};
+	std::array<Height, PHASE_COUNT> max_heights{};
+	size_t transactions = 0;
+	const char *pos     = body.c_str();
+	while (*pos) {
+		const char *eol = std::strchr(pos, '\n');
+		if (!eol)
+			eol = pos + std::strlen(pos);
+		if (*pos >= '0' && *pos <= '9') {  // skips header
+			char *end = nullptr;
+			Line line;
+			line.height       = static_cast<Height>(std::strtoull(pos, &end, 10));
+			line.transactions = static_cast<size_t>(std::strtoull(end + 1, &end, 10));
+			for (size_t i = 0; i != PHASE_COUNT; ++i) {
+				if (*end != ',')
+					throw std::runtime_error(
+					    "Block trace line has too few columns at height " + common::to_string(line.height));
+				const uint64_t us = std::strtoull(end + 1, &end, 10);
+				totals[i] += us;
+				if (us > maxes[i]) {
+					maxes[i]       = us;
+					max_heights[i] = line.height;
+				}
+				line.total_us += us;
+			}
+			transactions += line.transactions;
+			lines.push_back(line);
+		}
+		pos = *eol ? eol + 1 : eol;
+	}
+	if (lines.empty()) {
+		out << "Block trace " << path << " is empty" << std::endl;
+		return;
+	}
+	uint64_t total_us = 0;
+	for (const auto &t : totals)
+		total_us += t;
+	out << "blocks=" << lines.size() << " heights=" << lines.front().height << ".." << lines.back().height
+	    << " transactions=" << transactions << " total=" << std::fixed << std::setprecision(3) << total_us / 1e6
+	    << " s" << std::endl;
+	out << std::left << std::setw(12) << "phase" << std::right << std::setw(12) << "total, s" << std::setw(8) << "%"
+	    << std::setw(14) << "avg/block, us" << std::setw(12) << "max, us" << std::setw(12) << "max height" << std::endl;
+	for (size_t i = 0; i != PHASE_COUNT; ++i) {
+		out << std::left << std::setw(12) << phase_name(static_cast<Phase>(i)) << std::right << std::setw(12)
+		    << std::setprecision(3) << totals[i] / 1e6 << std::setw(8) << std::setprecision(1)
+		    << (total_us ? 100.0 * totals[i] / total_us : 0.0) << std::setw(14) << totals[i] / lines.size()
+		    << std::setw(12) << maxes[i] << std::setw(12) << max_heights[i] << std::endl;
+	}
+	const size_t slowest_count = std::min<size_t>(10, lines.size());
+	std::partial_sort(lines.begin(), lines.begin() + slowest_count, lines.end(),
+	    [](const Line &a, const Line &b) { return a.total_us > b.total_us; });
+	out << "slowest blocks:" << std::endl;
+	for (size_t i = 0; i != slowest_count; ++i)
+		out << "    height=" << lines[i].height << " transactions=" << lines[i].transactions
+		    << " total_us=" << lines[i].total_us << std::endl;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include "CryptoNote.hpp"
+
+namespace platform {
+class FileStream;
+}
+
+namespace cn {
+
+// Opt-in (--block-trace) timing of sync phases, CSV with one line per applied block
+// Analyze with tests --block-trace-summary=<file>
+class BlockTrace {
+public:
+	enum Phase { PARSE, POW, RING_ARGS, RING_WAIT, REDO, APPLY, INDEX, COMMIT, PHASE_COUNT };
+	typedef std::chrono::steady_clock::duration Duration;
+	static const char *phase_name(Phase phase);
+
+	explicit BlockTrace(const std::string &path);  // empty path disables trace
+	~BlockTrace();
+	bool enabled() const { return m_file != nullptr; }
+
+	// Parse and PoW happen before we know if block will be applied, so we remember them for a single bid
+	void set_prepared(const Hash &bid, Duration parse, Duration pow);
+	void begin_block(const Hash &bid, Height height, size_t transaction_count);  // writes previous block
+	void add(Phase phase, Duration duration);  // COMMIT after block is attributed to that block
+	void flush();
+
+	static void summarize(const std::string &path, std::ostream &out);  // throws std::runtime_error
+
+	class Timer {  // Adds duration of scope to phase of current block
+	public:
+		explicit Timer(BlockTrace &trace, Phase phase)
+		    : m_trace(trace)
+		    , m_phase(phase)
+		    , m_start(trace.enabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+		~Timer() {
+			if (m_trace.enabled())
+				m_trace.add(m_phase, std::chrono::steady_clock::now() - m_start);
+		}
+
+	private:
+		BlockTrace &m_trace;
+		const Phase m_phase;
+		const std::chrono::steady_clock::time_point m_start;
+	};
+
+private:
+	std::unique_ptr<platform::FileStream> m_file;
+	std::string m_buffer;
+	bool m_has_block           = false;
+	Height m_height            = 0;
+	size_t m_transaction_count = 0;
+	std::array<Duration, PHASE_COUNT> m_phases{};
+
+	Hash m_prepared_bid;
+	Duration m_prepared_parse{};
+	Duration m_prepared_pow{};
+
+	void write_block();
+};
+
+}  // namespace cn
@@ -166,6 +166,30 @@ Config::Config(common::CommandLine &cmd)
 		}
 	std::sort(seed_nodes.begin(), seed_nodes.end());
 	std::sort(priority_nodes.begin(), priority_nodes.end());
+	if (const char *pa = cmd.get("--log-async")) {
+		const std::string mode = pa;
+		if (mode == "drop")
+			log_async_mode = logging::ASYNC_DROP;
+		else if (mode == "block")
+			log_async_mode = logging::ASYNC_BLOCK;
+		else
+			throw ConfigError(
+			    "Command line option --log-async has wrong value '" + mode + "', should be 'drop' or 'block'");
+	}
+	if (const char *pa = cmd.get("--block-trace"))
+		block_trace_path = pa;
+	if (const char *pa = cmd.get("--db-sync-lag"))
+		db_sync_lag = common::integer_cast<Timestamp>(pa);
+	if (const char *pa = cmd.get("--sqlite-cache-size"))
+		sqlite_cache_size_mb = common::integer_cast<size_t>(pa);
+	if (const char *pa = cmd.get("--sqlite-mmap-size"))
+		sqlite_mmap_size_mb = common::integer_cast<size_t>(pa);
+	sqlite_wal = cmd.get_bool("--sqlite-wal");
+	if (const char *pa = cmd.get("--prune-below-depth")) {
+		prune_below_depth = common::integer_cast<Height>(pa);
+		if (prune_below_depth != 0 && is_archive)
+			throw ConfigError("Command line option --prune-below-depth cannot be used together with --archive");
+	}
 
 #ifndef __EMSCRIPTEN__
 	data_folder = platform::get_app_data_folder(CRYPTONOTE_NAME);
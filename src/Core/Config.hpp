@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include "CryptoNote.hpp"
+#include "logging/ILogger.hpp"
 #include "p2p/P2pProtocolTypes.hpp"
 
 namespace common {
@@ -69,6 +70,11 @@ public:
 	Timestamp db_commit_period_peers        = 60;
 	size_t db_commit_every_n_blocks         = 50000;
 	// This affects DB transaction size. TODO - sum size of blocks instead
+	Timestamp db_sync_lag                   = 0;  // 0 - commits are durable, otherwise background sync
+	size_t sqlite_cache_size_mb             = 64;
+	size_t sqlite_mmap_size_mb              = sizeof(void *) >= 8 ? 1024 : 0;  // address space is scarce on 32-bit
+	bool sqlite_wal                         = false;  // faster commits, power failure can lose last ones
+	Height prune_below_depth                = 0;  // 0 - keep all block bodies, otherwise depth below hard checkpoint
 
 	std::string walletd_authorization;
 	uint16_t walletd_bind_port;
@@ -123,6 +129,9 @@ public:
 	bool paranoid_checks = false;  // Check every byte of blockchain, even before last checkpoint
 	PublicKey trusted_public_key{};
 
+	logging::AsyncMode log_async_mode = logging::SYNC_WRITE;
+	std::string block_trace_path;  // empty - no trace, see BlockTrace
+
 	std::string data_folder;
 
 	std::string get_data_folder() const { return data_folder; }  // suppress creation of dir itself
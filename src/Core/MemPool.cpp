@@ -0,0 +1,149 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "MemPool.hpp"
+#include "CryptoNoteTools.hpp"
+#include "common/Invariant.hpp"
+
+using namespace cn;
+
+MemPool::PoolTransaction::PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee,
+    Timestamp timestamp, const Hash &newest_referenced_block)
+    : tx(tx)
+    , binary_tx(binary_tx)
+    , amount(get_tx_sum_outputs(tx))
+    , fee(fee)
+    , timestamp(timestamp)
+    , newest_referenced_block(newest_referenced_block) {}
+
+const MemPool::PoolTransaction *MemPool::find(const Hash &tid) const {
+	auto tit = m_transactions.find(tid);
+	return tit == m_transactions.end() ? nullptr : &tit->second;
+}
+
+const Hash *MemPool::find_keyimage(const KeyImage &key_image) const {
+	auto kit = m_keyimages.find(key_image);
+	return kit == m_keyimages.end() ? nullptr : &kit->second;
+}
+
+MemPool::Priority MemPool::get_minimal_priority(bool zero_if_not_full) const {
+	if (m_priorities.empty() || (zero_if_not_full && !is_full()))
+		return Priority{};
+	return *m_priorities.begin();
+}
+
+void MemPool::insert(const Hash &tid, PoolTransaction &&ptx) {
+	bool all_inserted = true;
+	for (const auto &input : ptx.tx.inputs) {
+		if (const auto *in = boost::get<InputKey>(&input)) {
+			if (!m_keyimages.insert(std::make_pair(in->key_image, tid)).second)
+				all_inserted = false;
+		}
+	}
+	const size_t my_size = ptx.binary_tx.size();
+	if (!m_priorities.insert(Priority{ptx.fee_per_byte(), tid}).second)
+		all_inserted = false;
+	if (!m_transactions.insert(std::make_pair(tid, std::move(ptx))).second)
+		all_inserted = false;
+	// insert all before throw
+	invariant(all_inserted, "MemPool corrupted on insert");
+	m_sizes.insert(my_size);
+	m_total_size += my_size;
+	m_selection_valid = false;
+}
+
+bool MemPool::erase(const Hash &tid) {
+	auto tit = m_transactions.find(tid);
+	if (tit == m_transactions.end())
+		return false;
+	bool all_erased = true;
+	for (const auto &input : tit->second.tx.inputs) {
+		if (const auto *in = boost::get<InputKey>(&input)) {
+			if (m_keyimages.erase(in->key_image) != 1)
+				all_erased = false;
+		}
+	}
+	const size_t my_size = tit->second.binary_tx.size();
+	if (m_priorities.erase(Priority{tit->second.fee_per_byte(), tid}) != 1)
+		all_erased = false;
+	auto sit = m_sizes.find(my_size);
+	if (sit != m_sizes.end())
+		m_sizes.erase(sit);
+	else
+		all_erased = false;
+	m_total_size -= my_size;
+	m_transactions.erase(tit);
+	m_selection_valid = false;
+	invariant(all_erased, "MemPool corrupted on erase");
+	return true;
+}
+
+MemPool::PoolTransMap MemPool::extract_all() {
+	PoolTransMap result;
+	std::swap(result, m_transactions);
+	m_keyimages.clear();
+	m_priorities.clear();
+	m_sizes.clear();
+	m_total_size      = 0;
+	m_selection_valid = false;
+	return result;
+}
+
+bool MemPool::get_eviction_candidate(Hash *tid) const {
+	if (m_total_size <= m_max_size)
+		return false;
+	invariant(!m_priorities.empty(), "MemPool priorities empty");
+	const Hash &rhash = m_priorities.begin()->second;
+	if (m_total_size < m_max_size + m_transactions.at(rhash).binary_tx.size())
+		return false;  // Removing would diminish pool below max size
+	*tid = rhash;
+	return true;
+}
+
+const std::vector<Hash> &MemPool::select_for_block(size_t max_size) const {
+	if (m_selection_valid && m_selection_max_size == max_size)
+		return m_selection;
+	m_selection.clear();
+	size_t txs_size = 0;
+	for (auto fit = m_priorities.rbegin(); fit != m_priorities.rend(); ++fit) {
+		if (max_size - txs_size < *m_sizes.begin())
+			break;  // Even smallest transaction will not fit
+		const size_t tx_size = m_transactions.at(fit->second).binary_tx.size();
+		if (txs_size + tx_size > max_size)
+			continue;
+		txs_size += tx_size;
+		m_selection.push_back(fit->second);
+	}
+	m_selection_valid    = true;
+	m_selection_max_size = max_size;
+	return m_selection;
+}
+
+size_t MemPool::get_size_with_fee_per_byte_at_least(Amount fee_per_byte) const {
+	size_t result = 0;
+	for (auto fit = m_priorities.rbegin(); fit != m_priorities.rend() && fit->first >= fee_per_byte; ++fit)
+		result += m_transactions.at(fit->second).binary_tx.size();
+	return result;
+}
+
+std::vector<TransactionDesc> MemPool::get_descs(const Priority &from, const Priority &to, size_t max_count) const {
+	std::vector<TransactionDesc> result;
+	auto sit = m_priorities.lower_bound(from);
+	if (sit != m_priorities.end()) {
+		if (*sit != from)
+			++sit;
+	}
+	while (sit != m_priorities.begin()) {
+		--sit;
+		if (result.size() > max_count || *sit <= to)
+			break;
+		const PoolTransaction &ptx = m_transactions.at(sit->second);
+		TransactionDesc desc;
+		desc.hash                    = sit->second;
+		desc.fee                     = ptx.fee;
+		desc.size                    = ptx.binary_tx.size();
+		desc.newest_referenced_block = ptx.newest_referenced_block;
+		result.push_back(desc);
+	}
+	return result;
+}
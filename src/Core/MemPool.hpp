@@ -0,0 +1,72 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+#include "CryptoNote.hpp"
+#include "common/FlatHashMap.hpp"
+#include "p2p/P2pProtocolTypes.hpp"
+
+namespace cn {
+
+// Indexes of transaction pool. Validation, logging and change log stay in BlockChainState.
+// Priority is (fee_per_byte, hash), so all nodes evict and select the same transactions.
+class MemPool {
+public:
+	struct PoolTransaction {
+		Transaction tx;
+		BinaryArray binary_tx;
+		Amount amount;
+		Amount fee;
+		Timestamp timestamp;
+		Hash newest_referenced_block;
+
+		PoolTransaction(const Transaction &tx, const BinaryArray &binary_tx, Amount fee, Timestamp timestamp,
+		    const Hash &newest_referenced_block);
+		Amount fee_per_byte() const { return fee / binary_tx.size(); }
+	};
+	typedef std::map<Hash, PoolTransaction> PoolTransMap;
+	typedef std::pair<Amount, Hash> Priority;
+
+	explicit MemPool(size_t max_size) : m_max_size(max_size) {}
+
+	const PoolTransMap &get_transactions() const { return m_transactions; }
+	size_t get_total_size() const { return m_total_size; }
+	size_t get_max_size() const { return m_max_size; }
+	bool is_full() const { return m_total_size >= m_max_size; }
+	const PoolTransaction *find(const Hash &tid) const;
+	const Hash *find_keyimage(const KeyImage &key_image) const;  // pool transaction spending key_image
+
+	// zero priority if pool is empty or (zero_if_not_full and pool is not full)
+	Priority get_minimal_priority(bool zero_if_not_full) const;
+	// Transactions must not conflict by key images with pool, caller removes conflicts first
+	void insert(const Hash &tid, PoolTransaction &&ptx);
+	bool erase(const Hash &tid);
+	PoolTransMap extract_all();  // indexes are cleared, transactions returned for readding
+
+	// Lowest priority transaction, if evicting it would not diminish pool below max size
+	bool get_eviction_candidate(Hash *tid) const;
+	// Greedy selection from highest priority, skipping transactions that do not fit any more.
+	// Cached until pool changes, because miners ask for templates much more often than pool changes
+	const std::vector<Hash> &select_for_block(size_t max_size) const;
+	size_t get_size_with_fee_per_byte_at_least(Amount fee_per_byte) const;
+	// Descending priority in (to..from] range, used by p2p pool sync
+	std::vector<TransactionDesc> get_descs(const Priority &from, const Priority &to, size_t max_count) const;
+
+private:
+	const size_t m_max_size;
+	PoolTransMap m_transactions;
+	common::FlatHashMap<KeyImage, Hash> m_keyimages;  // checked for every input of every relayed transaction
+	std::set<Priority> m_priorities;
+	std::multiset<size_t> m_sizes;  // Smallest transaction size lets selection stop early
+	size_t m_total_size = 0;
+
+	mutable bool m_selection_valid      = false;
+	mutable size_t m_selection_max_size = 0;
+	mutable std::vector<Hash> m_selection;
+};
+
+}  // namespace cn
@@ -7,8 +7,10 @@
 #include "CryptoNoteTools.hpp"
 #include "Currency.hpp"
 #include "TransactionExtra.hpp"
+#include "common/Metrics.hpp"
 #include "crypto/crypto.hpp"
 #include "platform/Network.hpp"
+#include "seria/BinaryInputStream.hpp"
 
 using namespace cn;
 
@@ -45,6 +47,24 @@ void BlockPreparatorMulticore::thread_run() {
 			local_work = std::move(work.front());
 			work.pop_front();
 		}
+		if (local_work.header_only) {
+			boost::variant<ConsensusError, PreparedHeader> result = ConsensusError{""};
+			try {
+				result = prepare_header(std::move(local_work.rb.block), local_work.check_pow, &ctx);
+			} catch (const ConsensusError &ex) {
+				result = ex;
+			} catch (const std::runtime_error &ex) {
+				result = ConsensusError{"Runtime error - " + common::what(ex)};
+			} catch (const std::logic_error &ex) {  // TODO - terminate app
+				result = ConsensusError{"Logic error - " + common::what(ex)};
+			}
+			std::unique_lock<std::mutex> lock(mu);
+			if (pending_headers.count(local_work.hash) == 0)
+				continue;  // cancelled while preparing
+			prepared_headers.insert(std::make_pair(local_work.hash, std::move(result)));
+			main_loop->wake([]() {});  // so we start processing on_idle
+			continue;
+		}
 		boost::variant<ConsensusError, PreparedBlock> result = ConsensusError{""};
 		try {
 			result = PreparedBlock{std::move(local_work.rb), currency, local_work.check_pow ? &ctx : nullptr};
@@ -63,9 +83,23 @@ void BlockPreparatorMulticore::thread_run() {
 	}
 }
 
+PreparedHeader BlockPreparatorMulticore::prepare_header(
+    BinaryArray &&header_data, bool check_pow, crypto::CryptoNightContext *ctx) const {
+	PreparedHeader result;
+	seria::from_binary(result.header, header_data);
+	const auto body_proxy = get_body_proxy_from_template(result.header);
+	result.bid            = get_block_hash(result.header, body_proxy);
+	PreparedBlock::check_header(currency, result.header, body_proxy);
+	if (check_pow) {
+		auto ba         = currency.get_block_pow_hashing_data(result.header, body_proxy);
+		result.pow_hash = ctx->cn_slow_hash(ba.data(), ba.size());
+	}
+	return result;
+}
+
 void BlockPreparatorMulticore::add_block(Hash bid, bool check_pow, RawBlock &&rb) {
 	std::unique_lock<std::mutex> lock(mu);
-	work.push_back(WorkItem{bid, check_pow, std::move(rb)});
+	work.push_back(WorkItem{bid, check_pow, false, std::move(rb)});
 	have_work.notify_all();
 }
 
@@ -85,6 +119,35 @@ bool BlockPreparatorMulticore::has_prepared_block(Hash bid) const {
 	return pid != prepared_blocks.end();
 }
 
+void BlockPreparatorMulticore::add_header(Hash bid, bool check_pow, BinaryArray &&header_data) {
+	std::unique_lock<std::mutex> lock(mu);
+	RawBlock rb;
+	rb.block = std::move(header_data);
+	pending_headers.insert(bid);
+	work.push_back(WorkItem{bid, check_pow, true, std::move(rb)});
+	have_work.notify_all();
+}
+
+bool BlockPreparatorMulticore::get_prepared_header(Hash bid, boost::variant<ConsensusError, PreparedHeader> *ph) {
+	std::unique_lock<std::mutex> lock(mu);
+	auto pid = prepared_headers.find(bid);
+	if (pid == prepared_headers.end())
+		return false;
+	*ph = std::move(pid->second);
+	pid = prepared_headers.erase(pid);
+	pending_headers.erase(bid);
+	return true;
+}
+
+void BlockPreparatorMulticore::cancel_header(Hash bid) {
+	std::unique_lock<std::mutex> lock(mu);
+	pending_headers.erase(bid);
+	prepared_headers.erase(bid);
+	work.erase(std::remove_if(work.begin(), work.end(),
+	               [&](const WorkItem &item) { return item.header_only && item.hash == bid; }),
+	    work.end());
+}
+
 RingCheckerMulticore::RingCheckerMulticore() {
 	auto th_count = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
 	// we use more energy but have the same speed when using hyperthreading
@@ -159,6 +222,7 @@ void RingCheckerMulticore::thread_run() {
 }
 void RingCheckerMulticore::start_batch() {
 	total_counter = 0;
+	batch_start   = std::chrono::steady_clock::now();
 	std::unique_lock<std::mutex> lock(mu);
 	work.clear();
 	batch_counter += 1;
@@ -173,12 +237,22 @@ void RingCheckerMulticore::add_work(RingSignatureCheckArgs &&args) {
 }
 
 std::vector<ConsensusErrorBadOutputOrSignature> RingCheckerMulticore::move_batch_errors() {
+	static auto &batch_seconds = common::metrics::registry().histogram(
+	    "ring_check_batch_seconds", "Ring signature check batch duration from start to last result");
+	static auto &wait_seconds = common::metrics::registry().histogram(
+	    "ring_check_wait_seconds", "Time main thread waits for ring signature check batch results");
+	static auto &checks_total =
+	    common::metrics::registry().counter("ring_checks_total", "Transactions with ring signatures checked");
+	const auto wait_start = std::chrono::steady_clock::now();
 	while (true) {
 		std::unique_lock<std::mutex> lock(mu);
 		if (ready_counter != total_counter) {
 			result_ready.wait(lock);
 			continue;
 		}
+		wait_seconds.observe_since(wait_start);
+		batch_seconds.observe_since(batch_start);
+		checks_total.inc(total_counter);
 		return std::move(errors);
 	}
 }
@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
+#include <set>
 #include <thread>
 #include "BlockChain.hpp"  // for PreparedBlock
 #include "CryptoNote.hpp"
@@ -22,6 +24,12 @@ namespace cn {
 class IBlockChainState;  // We will read keyimages and outputs from it
 class Currency;
 
+struct PreparedHeader {  // for header-first sync
+	BlockTemplate header;
+	Hash bid;
+	Hash pow_hash;  // only if check_pow
+};
+
 class BlockPreparatorMulticore {
 	const Currency &currency;
 
@@ -34,11 +42,16 @@ class BlockPreparatorMulticore {
 
 	struct WorkItem {
 		Hash hash;
-		bool check_pow = false;
+		bool check_pow   = false;
+		bool header_only = false;  // rb.transactions are empty, result goes to prepared_headers
 		RawBlock rb;
 	};
 	std::deque<WorkItem> work;
 	std::map<Hash, boost::variant<ConsensusError, PreparedBlock>> prepared_blocks;
+	std::map<Hash, boost::variant<ConsensusError, PreparedHeader>> prepared_headers;
+	std::set<Hash> pending_headers;  // results for other headers are dropped, they are no longer needed
+
+	PreparedHeader prepare_header(BinaryArray &&header_data, bool check_pow, crypto::CryptoNightContext *ctx) const;
 
 	void thread_run();
 
@@ -49,6 +62,10 @@ public:
 	void add_block(Hash bid, bool check_pow, RawBlock &&rb);
 	bool get_prepared_block(Hash bid, boost::variant<ConsensusError, PreparedBlock> *pb);
 	bool has_prepared_block(Hash bid) const;
+
+	void add_header(Hash bid, bool check_pow, BinaryArray &&header_data);
+	bool get_prepared_header(Hash bid, boost::variant<ConsensusError, PreparedHeader> *ph);
+	void cancel_header(Hash bid);
 };
 
 struct RingSignatureCheckArgs {
@@ -66,6 +83,7 @@ struct RingSignatureCheckArgs {
 class RingCheckerMulticore {
 	std::vector<std::thread> threads;
 	size_t total_counter = 0;
+	std::chrono::steady_clock::time_point batch_start;
 
 	mutable std::mutex mu;  // everything below is protected by mutex
 	mutable std::condition_variable have_work;
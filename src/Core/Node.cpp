@@ -3,13 +3,18 @@
 
 #include "Node.hpp"
 #include <boost/algorithm/string/replace.hpp>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include "Config.hpp"
 #include "CryptoNoteTools.hpp"
 #include "TransactionBuilder.hpp"
 #include "TransactionExtra.hpp"
 #include "common/Base58.hpp"
 #include "common/JsonValue.hpp"
+#include "common/Metrics.hpp"
 #include "common/StringTools.hpp"
 #include "http/Server.hpp"
 #include "p2p/PeerDB.hpp"
@@ -91,8 +96,11 @@ void Node::db_commit() {
 void Node::remove_chain_block(std::map<Hash, DownloadInfo>::iterator it) {
 	invariant(it->second.chain_counter > 0, "");
 	it->second.chain_counter -= 1;
-	if (it->second.chain_counter == 0 && !it->second.preparing)
-		chain_blocks.erase(it);
+	if (it->second.chain_counter != 0 || it->second.preparing)
+		return;
+	if (it->second.header_preparing)  // otherwise result stays in m_pow_checker forever
+		m_pow_checker.cancel_header(it->first);
+	chain_blocks.erase(it);
 }
 
 void Node::advance_all_downloads() {
@@ -118,6 +126,8 @@ bool Node::on_idle() {
 	}
 	if (m_block_chain.get_tip_height() < m_block_chain.internal_import_known_height())
 		m_block_chain.internal_import();
+	else if (m_block_chain.prune_block_bodies())
+		on_idle_result = true;
 	if (m_block_chain.get_tip_bid() != was_top_bid) {
 		advance_long_poll();
 	}
@@ -150,6 +160,7 @@ void Node::advance_long_poll() {
 	if (m_prevent_sleep &&
 	    m_block_chain.get_tip().timestamp > now - m_block_chain.get_currency().block_future_time_limit * 2)
 		m_prevent_sleep = nullptr;
+	advance_subscriptions();
 	if (m_long_poll_http_clients.empty())
 		return;
 	const api::cnd::GetStatus::Response resp = create_status_response();
@@ -191,6 +202,44 @@ void Node::advance_long_poll() {
 	}
 }
 
+api::cnd::Subscribe::Notification Node::create_subscription_notification(bool whole_pool) const {
+	api::cnd::Subscribe::Notification notification;
+	notification.top_block_hash           = m_block_chain.get_tip_bid();
+	notification.top_block_height         = m_block_chain.get_tip_height();
+	notification.transaction_pool_version = m_block_chain.get_tx_pool_version();
+	notification.pool_log_id              = m_block_chain.get_tx_pool_log_id();
+	if (whole_pool || !m_block_chain.get_tx_pool_changes(m_subscription_pool_version,
+	                      &notification.added_transactions, &notification.removed_transactions)) {
+		notification.removed_all = true;
+		notification.added_transactions.clear();
+		notification.removed_transactions.clear();
+		for (const auto &tit : m_block_chain.get_memory_state_transactions())
+			notification.added_transactions.push_back(tit.first);
+	}
+	return notification;
+}
+
+void Node::advance_subscriptions() {
+	if (m_block_chain.get_tip_bid() == m_subscription_top_bid &&
+	    m_block_chain.get_tx_pool_version() == m_subscription_pool_version)
+		return;
+	if (!m_subscribers.empty())
+		m_subscribers.broadcast(json_rpc::create_notification_body(
+		    api::cnd::Subscribe::notification_method(), create_subscription_notification(false)));
+	m_subscription_top_bid      = m_block_chain.get_tip_bid();
+	m_subscription_pool_version = m_block_chain.get_tx_pool_version();
+}
+
+void Node::start_subscription(http::Client *who, http::ResponseHeader &&header) {
+	advance_subscriptions();  // So existing subscribers will not get changes before whole pool of new subscriber
+	header.status = 200;
+	header.add_headers_nocache();
+	header.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
+	m_subscribers.start(who, std::move(header),
+	    json_rpc::create_notification_body(
+	        api::cnd::Subscribe::notification_method(), create_subscription_notification(true)));
+}
+
 static const std::string beautiful_index_start =
     R"(<html><head><meta http-equiv='refresh' content='30'/></head><body><table valign="middle"><tr><td width="30px">
 <svg xmlns="http://www.w3.org/2000/svg" width="30px" viewBox="0 0 215.99 215.99">
@@ -244,6 +293,27 @@ bool Node::on_api_http_request(http::Client *who, http::RequestBody &&request, h
 		response.set_body(std::move(body));
 		return true;
 	}
+	if (request.r.uri == "/metrics") {
+		if (!m_config.good_bytecoind_auth_private(request.r.basic_authorization))
+			throw http::ErrorAuthorization("authorization-private");
+		auto &reg = common::metrics::registry();
+		auto stat = create_status_response();
+		reg.gauge("tip_height", "Height of top block").set(stat.top_block_height);
+		reg.gauge("known_height", "Max of heights reported by peers").set(stat.top_known_block_height);
+		reg.gauge("peers", "Connected peers", common::metrics::label("direction", "incoming"))
+		    .set(stat.incoming_peer_count);
+		reg.gauge("peers", "Connected peers", common::metrics::label("direction", "outgoing"))
+		    .set(stat.outgoing_peer_count);
+		reg.gauge("pool_transactions", "Transactions in memory pool")
+		    .set(m_block_chain.get_memory_state_transactions().size());
+		reg.gauge("db_durability_lag_seconds", "Age of oldest blockchain commit not yet on disk")
+		    .set(m_block_chain.get_db_durability_lag());
+		response.r.add_headers_nocache();
+		response.r.headers.push_back({"Content-Type", "text/plain; version=0.0.4"});
+		response.r.status = 200;
+		response.set_body(reg.to_prometheus_text());
+		return true;
+	}
 	if (request.r.uri == api::cnd::url()) {
 		response.r.add_headers_nocache();
 		if (!on_json_rpc(who, std::move(request), response))
@@ -251,6 +321,16 @@ bool Node::on_api_http_request(http::Client *who, http::RequestBody &&request, h
 		response.r.status = 200;
 		return true;
 	}
+	if (request.r.uri == api::cnd::Subscribe::url()) {
+		if (request.r.http_version_major != 1 || request.r.http_version_minor < 1) {
+			response.r.headers.push_back({"Content-Type", "text/plain; charset=UTF-8"});
+			response.r.status = 400;
+			response.set_body("Subscription requires HTTP/1.1 chunked transfer encoding");
+			return true;
+		}
+		start_subscription(who, std::move(response.r));
+		return false;
+	}
 	if (request.r.uri == api::cnd::binary_url()) {
 		response.r.add_headers_nocache();
 		if (!on_binary_rpc(who, std::move(request), response))
@@ -270,6 +350,12 @@ bool Node::on_api_http_request(http::Client *who, http::RequestBody &&request, h
 				    "<html><body>404 Not Found - static blocks can be queried only up to last hard checkpoint</body></html>");
 				return true;
 			}
+			if (height - height % 10 < m_block_chain.get_pruned_below_height()) {
+				response.r.headers.push_back({"Content-Type", "text/html; charset=UTF-8"});
+				response.r.status = 404;
+				response.set_body("<html><body>404 Not Found - block bodies are pruned on this node</body></html>");
+				return true;
+			}
 			response.r.headers.push_back({"Content-Type", "application/octet-stream"});
 			response.r.headers.push_back({"Cache-Control", "max-age=2628000, public"});  // month
 			response.r.status = 200;
@@ -301,6 +387,7 @@ bool Node::on_api_http_request(http::Client *who, http::RequestBody &&request, h
 }
 
 void Node::on_api_http_disconnect(http::Client *who) {
+	m_subscribers.erase(who);
 	for (auto lit = m_long_poll_http_clients.begin(); lit != m_long_poll_http_clients.end();)
 		if (lit->original_who == who)
 			lit = m_long_poll_http_clients.erase(lit);
@@ -386,6 +473,18 @@ void Node::broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data) {
 			p->P2PProtocol::send(BinaryArray(data));  // Move is impossible here
 }
 
+void Node::broadcast_transactions(P2PProtocolBytecoin *exclude, const std::vector<TransactionDesc> &descs) {
+	for (auto &&p : m_broadcast_protocols)
+		if (p != exclude)
+			p->relay_transactions(descs);
+}
+
+void Node::broadcast_block(P2PProtocolBytecoin *exclude, const Hash &bid, const BinaryArray &raw_msg) {
+	for (auto &&p : m_broadcast_protocols)
+		if (p != exclude)
+			p->relay_block(bid, raw_msg);
+}
+
 bool Node::on_get_status(http::Client *who, http::RequestBody &&raw_request, json_rpc::Request &&raw_js_request,
     api::cnd::GetStatus::Request &&req, api::cnd::GetStatus::Response &res) {
 	res = create_status_response();
@@ -414,6 +513,7 @@ api::cnd::GetStatistics::Response Node::create_statistics_response(const api::cn
 			desc.peer_id               = p->get_peer_unique_number();
 			desc.top_block_desc.hash   = p->get_peer_sync_data().top_id;
 			desc.top_block_desc.height = p->get_peer_sync_data().current_height;
+			p->fill_connection_statistics(&desc);
 			res.connected_peers.push_back(desc);
 		}
 	}
@@ -502,6 +602,10 @@ std::vector<Hash> Node::fill_sync_blocks_subchain(api::cnd::SyncBlocks::Request
 	} else if (subchain.size() > req.max_count) {
 		subchain.pop_back();
 	}
+	if (std::max(full_offset, *start_height) < m_block_chain.get_pruned_below_height())
+		throw json_rpc::Error(json_rpc::INVALID_PARAMS,
+		    "This node is pruned, blocks below height " + common::to_string(m_block_chain.get_pruned_below_height()) +
+		        " are not available");
 	if (full_offset >= *start_height + subchain.size()) {
 		*start_height = full_offset;
 		subchain.clear();
@@ -596,22 +700,35 @@ bool Node::on_sync_mempool(http::Client *, http::RequestBody &&http_request, jso
 	    !m_config.good_bytecoind_auth_private(http_request.r.basic_authorization))
 		throw http::ErrorAuthorization("authorization-private");  // slow variants are private
 	const auto &pool = m_block_chain.get_memory_state_transactions();
+	auto add_transaction = [&](const Hash &tid, const BlockChainState::PoolTransaction &ptx) {
+		res.added_raw_transactions.push_back(ptx.tx);
+		res.added_transactions.push_back(api::Transaction{});
+		if (req.need_redundant_data)
+			fill_transaction_info(ptx.tx, &res.added_transactions.back(), nullptr);
+		res.added_transactions.back().hash      = tid;
+		res.added_transactions.back().timestamp = ptx.timestamp;
+		res.added_transactions.back().amount    = ptx.amount;
+		res.added_transactions.back().fee       = ptx.fee;
+		res.added_transactions.back().size      = ptx.binary_tx.size();
+	};
+	res.status      = create_status_response();
+	res.pool_log_id = m_block_chain.get_tx_pool_log_id();
+	if (req.known_pool_version != 0) {  // client did not send known_hashes
+		std::vector<Hash> added;
+		if (req.known_pool_log_id == res.pool_log_id &&
+		    m_block_chain.get_tx_pool_changes(req.known_pool_version, &added, &res.removed_hashes)) {
+			for (const auto &tid : added)
+				add_transaction(tid, pool.at(tid));
+			return true;
+		}
+		res.removed_all = true;
+	}
 	for (auto &&ex : req.known_hashes)
 		if (pool.count(ex) == 0)
 			res.removed_hashes.push_back(ex);
 	for (auto &&tx : pool)
-		if (!std::binary_search(req.known_hashes.begin(), req.known_hashes.end(), tx.first)) {
-			res.added_raw_transactions.push_back(tx.second.tx);
-			res.added_transactions.push_back(api::Transaction{});
-			if (req.need_redundant_data)
-				fill_transaction_info(tx.second.tx, &res.added_transactions.back(), nullptr);
-			res.added_transactions.back().hash      = tx.first;
-			res.added_transactions.back().timestamp = tx.second.timestamp;
-			res.added_transactions.back().amount    = tx.second.amount;
-			res.added_transactions.back().fee       = tx.second.fee;
-			res.added_transactions.back().size      = tx.second.binary_tx.size();
-		}
-	res.status = create_status_response();
+		if (!std::binary_search(req.known_hashes.begin(), req.known_hashes.end(), tx.first))
+			add_transaction(tx.first, tx.second);
 	return true;
 }
 
@@ -653,7 +770,12 @@ bool Node::on_get_raw_block(http::Client *, http::RequestBody &&, json_rpc::Requ
 		invariant(m_block_chain.get_header(hash, &response.block.header), "");
 	}
 	RawBlock rb;
-	invariant(m_block_chain.get_block(response.block.header.hash, &rb), "Block must be there, but it is not there");
+	if (!m_block_chain.get_block(response.block.header.hash, &rb)) {
+		invariant(m_block_chain.in_chain(response.block.header.height, response.block.header.hash) &&
+		              response.block.header.height < m_block_chain.get_pruned_below_height(),
+		    "Block must be there, but it is not there");
+		throw api::ErrorHash("Block body is pruned on this node", response.block.header.hash);
+	}
 	Block block(rb);
 
 	api::RawBlock &b = response.block;
@@ -749,9 +871,7 @@ bool Node::on_send_transaction(http::Client *, http::RequestBody &&, json_rpc::R
 			invariant(m_block_chain.get_largest_referenced_height(tx, &newest_referenced_height), "");
 			invariant(m_block_chain.get_chain(newest_referenced_height, &desc.newest_referenced_block), "");
 			msg_v4.transaction_descs.push_back(desc);
-
-			BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-			broadcast(nullptr, raw_msg_v4);
+			broadcast_transactions(nullptr, msg_v4.transaction_descs);
 			advance_long_poll();
 		}
 	} catch (const ConsensusErrorOutputDoesNotExist &ex) {
@@ -1006,7 +1126,7 @@ void Node::submit_block(const BinaryArray &blockblob, api::BlockHeader *info) {
 	msg_v4.top_id                    = m_block_chain.get_tip_bid();
 
 	BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-	broadcast(nullptr, raw_msg_v4);
+	broadcast_block(nullptr, msg_v4.top_id, raw_msg_v4);
 	advance_long_poll();
 }
 
@@ -1037,58 +1157,172 @@ bool Node::on_submitblock(http::Client *, http::RequestBody &&http_request, json
 	return true;
 }
 
+namespace {
+struct StaticSyncChunk {  // DB is read on main thread, the rest is done by workers
+	Height start_height = 0;
+	std::vector<api::BlockHeader> headers;
+	std::vector<RawBlock> raw_blocks;
+	std::vector<BlockChainState::BlockStackIndexes> output_stack_indexes;
+};
+
+void save_static_sync_chunk(const std::string &blocks_folder, StaticSyncChunk &&chunk, size_t *real_size) {
+	api::cnd::SyncBlocks::ResponseCompact res;
+	for (size_t d = 0; d != chunk.headers.size(); ++d)
+		res.blocks.push_back(BlockChainState::fill_sync_block_compact(std::move(chunk.headers.at(d)),
+		    chunk.raw_blocks.at(d), std::move(chunk.output_stack_indexes.at(d))));
+	const auto ba         = json_rpc::create_binary_response_body(res, common::JsonValue(nullptr));
+	const std::string lnk = common::to_string(chunk.start_height);
+	*real_size            = ba.size();
+	std::string created_subfolder;
+	std::string link_path;
+	for (size_t d = 0; d != res.blocks.size(); ++d) {
+		std::string subfolder;
+		const auto file_path =
+		    blocks_folder + api::cnd::SyncBlocks::get_filename(Height(chunk.start_height + d), &subfolder);
+		if (subfolder != created_subfolder) {
+			if (!platform::create_folders_if_necessary(blocks_folder + subfolder))
+				throw std::runtime_error("Failed to create folder " + blocks_folder + subfolder);
+			created_subfolder = subfolder;
+		}
+		platform::remove_file(file_path);  // Never write through hard link left by previous export
+		// Link files of a chunk are identical, we hard link them so they share single inode
+		if (d > 1 && platform::create_hard_link(link_path, file_path))
+			continue;
+		const bool ok =
+		    d == 0 ? platform::save_file(file_path, ba.data(), ba.size()) : platform::save_file(file_path, lnk);
+		if (!ok)
+			throw std::runtime_error("Failed to save file " + file_path);
+		if (d != 0)
+			link_path = file_path;
+	}
+}
+}  // namespace
+
 void Node::export_static_sync_blocks(const BlockChainState &block_chain, const std::string &folder) {
-	if (block_chain.get_tip_height() < block_chain.get_currency().last_hard_checkpoint().height)
+	const Height last_height = block_chain.get_currency().last_hard_checkpoint().height;
+	if (block_chain.get_tip_height() < last_height)
 		throw std::runtime_error("Daemon must be synced at least to last hard checkpoint");
+	if (block_chain.get_pruned_below_height() != 0)
+		throw std::runtime_error("Static sync_blocks cannot be exported from pruned blockchain");
 	if (!platform::folder_exists(folder))
 		throw std::runtime_error("Folder for static sync_blocks must exist " + folder);
-	api::cnd::SyncBlocks::Request req;
-	req.max_size            = 1024 * 1024;
-	req.max_count           = 1000;
-	req.need_redundant_data = false;
-	std::vector<Hash> all_chain(block_chain.get_currency().last_hard_checkpoint().height + 1);
+	const std::string blocks_folder = folder + api::cnd::SyncBlocks::url_prefix();
+	if (!platform::create_folders_if_necessary(blocks_folder))
+		throw std::runtime_error("Failed to create folder " + blocks_folder);
+	// Chunks below checkpoint never change, so we continue after chunks saved by previous export
+	const std::string exported_height_path = blocks_folder + "exported_height";
+	Height start_height                    = 0;
+	std::string exported_height_str;
+	if (platform::load_file(exported_height_path, exported_height_str)) {
+		start_height = common::integer_cast<Height>(exported_height_str) + 1;
+		std::cout << "Continuing previous export from height " << start_height << std::endl;
+	}
+	if (start_height > last_height) {
+		std::cout << "Static sync_blocks already exported up to last hard checkpoint " << last_height << std::endl;
+		return;
+	}
+	std::vector<Hash> all_chain(last_height + 1 - start_height);
 	std::cout << "Reading chain, can take a minute or two..." << std::endl;
-	for (Height i = 0; i != block_chain.get_currency().last_hard_checkpoint().height + 1; ++i)
-		invariant(block_chain.get_chain(i, &all_chain.at(i)), "");
-	Height ha = 0;
-	api::cnd::SyncBlocks::ResponseCompact res;
+	for (Height i = start_height; i != last_height + 1; ++i)
+		invariant(block_chain.get_chain(i, &all_chain.at(i - start_height)), "");
+
+	const size_t max_chunk_size = 1024 * 1024;
+	const size_t th_count       = std::max<size_t>(2, 3 * std::thread::hardware_concurrency() / 4);
+	std::mutex mu;
+	std::condition_variable have_work;
+	std::condition_variable have_space;
+	std::deque<StaticSyncChunk> chunks;
+	bool finished = false;
+	std::string error;
 	size_t max_total_count     = 0;
 	size_t min_total_count     = std::numeric_limits<size_t>::max();
 	size_t sum_total_size_real = 0;
-	size_t sum_total_size_link = 0;
-	while (ha <= block_chain.get_currency().last_hard_checkpoint().height) {
-		res.blocks.clear();
-		size_t total_size = 0;
-		while (ha + res.blocks.size() <= block_chain.get_currency().last_hard_checkpoint().height) {
-			res.blocks.push_back(block_chain.fill_sync_block_compact(all_chain.at(ha + res.blocks.size())));
-			total_size += seria::binary_size(res.blocks.back());
-			if (total_size >= req.max_size)
-				break;
+	size_t sum_total_count     = 0;
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i != th_count; ++i)
+		threads.emplace_back([&]() {
+			while (true) {
+				StaticSyncChunk chunk;
+				{
+					std::unique_lock<std::mutex> lock(mu);
+					if (chunks.empty()) {
+						if (finished || !error.empty())
+							return;
+						have_work.wait(lock);
+						continue;
+					}
+					chunk = std::move(chunks.front());
+					chunks.pop_front();
+					have_space.notify_all();
+				}
+				const Height start = chunk.start_height;
+				const size_t count = chunk.headers.size();
+				size_t real_size   = 0;
+				try {
+					save_static_sync_chunk(blocks_folder, std::move(chunk), &real_size);
+				} catch (const std::exception &ex) {
+					std::unique_lock<std::mutex> lock(mu);
+					error = common::what(ex);
+					chunks.clear();
+					have_space.notify_all();
+					return;
+				}
+				std::unique_lock<std::mutex> lock(mu);
+				std::cout << "Saved chunk start=" << start << ", count=" << count << ", size=" << real_size
+				          << std::endl;
+				sum_total_size_real += real_size;
+				sum_total_count += count;
+				max_total_count = std::max(max_total_count, count);
+				min_total_count = std::min(min_total_count, count);
+			}
+		});
+	auto stop_workers = [&]() {
+		{
+			std::unique_lock<std::mutex> lock(mu);
+			finished = true;
+			have_work.notify_all();
 		}
-		invariant(!res.blocks.empty(), "");
-		auto ba = json_rpc::create_binary_response_body(res, common::JsonValue(nullptr));
-		std::cout << "Saving chunk start=" << ha << ", count=" << res.blocks.size() << ", size=" << ba.size()
-		          << std::endl;
-		sum_total_size_real += ba.size();
-		for (size_t d = 0; d != res.blocks.size(); ++d) {
-			if (d == 1) {
-				ba = common::to_string(ha);
-				sum_total_size_link += ba.size() * (res.blocks.size() - 1);
+		for (auto &th : threads)
+			th.join();
+	};
+	Height ha = start_height;
+	try {
+		while (ha <= last_height) {
+			StaticSyncChunk chunk;
+			chunk.start_height = ha;
+			size_t total_size  = 0;
+			while (ha <= last_height && total_size < max_chunk_size) {
+				const Hash &bid = all_chain.at(ha - start_height);
+				chunk.headers.emplace_back();
+				chunk.raw_blocks.emplace_back();
+				chunk.output_stack_indexes.emplace_back();
+				invariant(block_chain.get_header(bid, &chunk.headers.back()), "Block header must be there");
+				invariant(block_chain.get_block(bid, &chunk.raw_blocks.back()), "Block must be there");
+				invariant(block_chain.read_block_output_stack_indexes(bid, &chunk.output_stack_indexes.back()),
+				    "Invariant dead - bid is in chain but blockchain has no block indexes");
+				total_size += chunk.headers.back().block_size;
+				ha += 1;
 			}
-			std::string subfolder;
-			auto file_name = api::cnd::SyncBlocks::get_filename(Height(ha + d), &subfolder);
-			invariant(
-			    platform::create_folders_if_necessary(folder + api::cnd::SyncBlocks::url_prefix() + "/" + subfolder),
-			    "");
-			invariant(platform::save_file(
-			              folder + api::cnd::SyncBlocks::url_prefix() + "/" + file_name, ba.data(), ba.size()),
-			    "");
+			std::unique_lock<std::mutex> lock(mu);
+			while (error.empty() && chunks.size() >= 2 * th_count)  // limits memory
+				have_space.wait(lock);
+			if (!error.empty())
+				break;
+			chunks.push_back(std::move(chunk));
+			have_work.notify_one();
 		}
-		ha += res.blocks.size();
-		max_total_count = std::max(max_total_count, res.blocks.size());
-		min_total_count = std::min(min_total_count, res.blocks.size());
+	} catch (...) {
+		stop_workers();
+		throw;
 	}
-	std::cout << "min_total_count=" << min_total_count << " max_total_count=" << max_total_count << std::endl;
-	std::cout << "sum_total_size_real=" << sum_total_size_real << " sum_total_size_link=" << sum_total_size_link
-	          << std::endl;
+	stop_workers();
+	if (!error.empty())
+		throw std::runtime_error("Failed to export static sync_blocks - " + error);
+	exported_height_str = common::to_string(last_height);
+	if (!platform::atomic_save_file(exported_height_path, exported_height_str.data(), exported_height_str.size(),
+	        exported_height_path + ".tmp"))
+		throw std::runtime_error("Failed to save " + exported_height_path);
+	std::cout << "min_total_count=" << min_total_count << " max_total_count=" << max_total_count
+	          << " sum_total_count=" << sum_total_count << std::endl;
+	std::cout << "sum_total_size_real=" << sum_total_size_real << std::endl;
 }
@@ -6,19 +6,20 @@
 #include <functional>
 #include <iostream>
 #include "BlockChainState.hpp"
+#include "common/RollingBloomFilter.hpp"
 #include "http/BinaryRpc.hpp"
 #include "http/JsonRpc.hpp"
+#include "http/Server.hpp"
 #include "p2p/P2P.hpp"
 #include "p2p/P2PProtocolBasic.hpp"
 #include "rpc_api.hpp"
 
-namespace http {
-class Server;
-class Client;
-}  // namespace http
 namespace platform {
 class PreventSleep;
 }
+namespace common { namespace metrics {
+class Histogram;
+}}  // namespace common::metrics
 namespace cn {
 
 class Node {
@@ -80,6 +81,7 @@ public:
 	    api::cnd::GetBlockHeaderByHeightLegacy::Request &&, api::cnd::GetBlockHeaderByHeightLegacy::Response &);
 
 	bool on_json_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &);
+	void on_json_rpc_batch(http::Client *, const http::RequestBody &, http::ResponseBody &);
 	bool on_binary_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &);
 
 	BlockChainState &m_block_chain;
@@ -99,6 +101,14 @@ protected:
 	std::list<LongPollClient> m_long_poll_http_clients;
 	void advance_long_poll();
 
+	// Streaming subscribers get notification chunk on every change of tip or pool, serialized once for all
+	http::StreamGroup m_subscribers;
+	Hash m_subscription_top_bid;
+	size_t m_subscription_pool_version = 0;
+	api::cnd::Subscribe::Notification create_subscription_notification(bool whole_pool) const;
+	void advance_subscriptions();
+	void start_subscription(http::Client *who, http::ResponseHeader &&header);
+
 	logging::LoggerRef m_log;
 	const std::unique_ptr<PeerDB> m_peer_db;  // compilation speed optimization
 	P2P m_p2p;
@@ -119,8 +129,16 @@ protected:
 	struct DownloadInfo {
 		size_t chain_counter                 = 0;
 		P2PProtocolBytecoin *who_downloading = nullptr;
-		Height expected_height               = 0;  // Set during download
+		P2PProtocolBytecoin *who_hedging     = nullptr;  // faster peer also asked, because who_downloading stalled
+		Height expected_height               = 0;        // Set during download
 		bool preparing                       = false;
+		// Header-first sync. Hash commits to parent, so validated header is valid in chain of every peer
+		P2PProtocolBytecoin *who_downloading_header = nullptr;
+		bool header_preparing                       = false;
+		bool header_valid                           = false;
+		Hash pow_hash;  // of valid header, so block body is not hashed again
+		Timestamp timestamp = 0;
+		CumulativeDifficulty cumulative_difficulty{};
 	};
 	std::map<Hash, DownloadInfo> chain_blocks;
 	void remove_chain_block(std::map<Hash, DownloadInfo>::iterator it);
@@ -133,7 +151,31 @@ protected:
 		bool m_chain_request_sent = false;
 		platform::Timer m_chain_timer;
 		platform::Timer m_download_timer;
-		size_t m_downloading_block_count = 0;
+		std::map<Hash, std::chrono::steady_clock::time_point> m_requested_blocks;  // bid -> request time
+		std::chrono::steady_clock::time_point m_last_block_received;
+		double m_download_bytes_per_second = 0;  // moving averages, valid after first block received
+		double m_download_latency_seconds  = 0;
+		double m_download_block_size       = 0;
+		size_t m_downloaded_block_count    = 0;
+		size_t m_hedged_request_count      = 0;
+		size_t get_download_quota() const;
+		void update_download_stats(std::chrono::steady_clock::time_point request_time, size_t block_size);
+		bool request_block(std::map<Hash, DownloadInfo>::iterator cit, size_t index_in_chain, bool hedge);
+		void send_get_objects(const std::vector<Hash> &ids, bool blocks, bool headers_only = false);
+		// Bodies are requested only for validated prefix of m_chain, if peer can send headers
+		std::set<Hash> m_requested_headers;
+		size_t m_headers_validated = 0;
+		bool headers_first() const { return get_peer_get_objects_batch() > 1; }
+		void advance_headers();
+		bool validate_headers();  // false if disconnected
+		bool validate_header(std::map<Hash, DownloadInfo>::iterator cit,
+		    const boost::variant<ConsensusError, PreparedHeader> &result);  // false if disconnected
+		void pop_chain_front();
+
+		// Transactions and blocks peer sent to us or we sent to peer, so we do not send them to peer again
+		common::RollingBloomFilter m_known_objects;
+		size_t m_relay_suppressed_count = 0;
+		void add_known_object(const Hash &id) { m_known_objects.insert(id.data, sizeof(id.data)); }
 		void on_chain_timer();
 		void on_download_timer();
 		Hash m_previous_chain_hash;
@@ -181,6 +223,9 @@ protected:
 		void advance_blocks();
 		bool on_idle(std::chrono::steady_clock::time_point idle_start);
 		void advance_transactions();
+		void fill_connection_statistics(ConnectionDesc *desc) const;
+		void relay_transactions(const std::vector<TransactionDesc> &descs);  // only those peer does not know
+		void relay_block(const Hash &bid, const BinaryArray &raw_msg);
 	};
 	std::unique_ptr<P2PProtocol> client_factory(P2PClient *client) {
 		return std::make_unique<P2PProtocolBytecoin>(this, client);
@@ -196,6 +241,8 @@ protected:
 	// TODO - periodically clear m_pow_checker of blocks that were not asked
 
 	void broadcast(P2PProtocolBytecoin *exclude, const BinaryArray &data);
+	void broadcast_transactions(P2PProtocolBytecoin *exclude, const std::vector<TransactionDesc> &descs);
+	void broadcast_block(P2PProtocolBytecoin *exclude, const Hash &bid, const BinaryArray &raw_msg);
 
 	void fill_cors(const http::RequestBody &req, http::ResponseBody &res);
 	bool on_api_http_request(http::Client *, http::RequestBody &&, http::ResponseBody &);
@@ -203,6 +250,7 @@ protected:
 
 	static std::unordered_map<std::string, JSONRPCHandlerFunction> m_jsonrpc_handlers;
 	static const std::unordered_map<std::string, BINARYRPCHandlerFunction> m_binaryrpc_handlers;
+	static common::metrics::Histogram &rpc_request_seconds(const std::string &method);  // one per handler
 
 	void fill_transaction_info(const TransactionPrefix &tx, api::Transaction *api_tx,
 	    std::vector<std::vector<api::Output>> *mixed_outputs) const;
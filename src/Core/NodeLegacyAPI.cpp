@@ -8,6 +8,7 @@
 #include "TransactionExtra.hpp"
 #include "WalletNode.hpp"
 #include "common/JsonValue.hpp"
+#include "common/Metrics.hpp"
 #include "common/exception.hpp"
 #include "http/Server.hpp"
 #include "seria/BinaryInputStream.hpp"
@@ -17,8 +18,30 @@
 
 using namespace cn;
 
+common::metrics::Histogram &Node::rpc_request_seconds(const std::string &method) {
+	// Handlers are fixed, so histograms are looked up once instead of locking registry on each request
+	static const auto histograms = []() {
+		std::unordered_map<std::string, common::metrics::Histogram *> result;
+		auto add = [&](const std::string &name) {
+			result[name] = &common::metrics::registry().histogram("rpc_request_seconds", "RPC handler duration",
+			    common::metrics::label("server", CRYPTONOTE_NAME "d") + "," + common::metrics::label("method", name));
+		};
+		for (const auto &hit : m_jsonrpc_handlers)
+			add(hit.first);
+		for (const auto &hit : m_binaryrpc_handlers)
+			add(hit.first);
+		return result;
+	}();
+	return *histograms.at(method);
+}
+
 bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::ResponseBody &response) {
 	response.r.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
+	if (json_rpc::is_batch(request.body)) {
+		on_json_rpc_batch(who, request, response);
+		response.r.status = 200;
+		return true;
+	}
 
 	common::JsonValue jid(nullptr);
 	bool nas = false;
@@ -37,6 +60,7 @@ bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::Res
 				        " (attempt to call walletd method on " CRYPTONOTE_NAME "d)");
 			throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + json_req.get_method());
 		}
+		common::metrics::ScopeTimer timer(rpc_request_seconds(it->first));
 		std::string response_body;
 		if (!it->second(this, who, std::move(request), std::move(json_req), response_body))
 			return false;
@@ -51,6 +75,29 @@ bool Node::on_json_rpc(http::Client *who, http::RequestBody &&request, http::Res
 	return true;
 }
 
+void Node::on_json_rpc_batch(http::Client *who, const http::RequestBody &request, http::ResponseBody &response) {
+	// Long poll methods answer later with separate http response, so cannot be part of batch
+	static const std::set<std::string> long_poll_methods{api::cnd::GetStatus::method(),
+	    api::cnd::GetStatus::method2(), api::cnd::GetBlockTemplate::method(),
+	    api::cnd::GetBlockTemplate::method_legacy()};
+	try {
+		response.set_body(json_rpc::process_batch(request.body, [&](json_rpc::Request &&json_req, std::string &body) {
+			auto it = m_jsonrpc_handlers.find(json_req.get_method());
+			if (it == m_jsonrpc_handlers.end())
+				throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + json_req.get_method());
+			if (long_poll_methods.count(it->first) != 0)
+				throw json_rpc::Error(json_rpc::INVALID_REQUEST, "Method " + it->first + " cannot be called in batch");
+			common::metrics::ScopeTimer timer(rpc_request_seconds(it->first));
+			http::RequestBody element_request;
+			element_request.r = request.r;  // handlers check authorization, body is not needed
+			if (!it->second(this, who, std::move(element_request), std::move(json_req), body))
+				throw json_rpc::Error(json_rpc::INTERNAL_ERROR, "Method " + it->first + " did not answer in batch");
+		}));
+	} catch (const json_rpc::Error &err) {
+		response.set_body(json_rpc::create_error_response_body(err, common::JsonValue(nullptr), false));
+	}
+}
+
 bool Node::on_binary_rpc(http::Client *who, http::RequestBody &&request, http::ResponseBody &response) {
 	response.r.headers.push_back({"Content-Type", "application/octet-stream"});
 
@@ -69,6 +116,7 @@ bool Node::on_binary_rpc(http::Client *who, http::RequestBody &&request, http::R
 			m_log(logging::INFO) << "binaryrpc request method not found - " << binary_req.get_method();
 			throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + binary_req.get_method());
 		}
+		common::metrics::ScopeTimer timer(rpc_request_seconds(it->first));
 		std::string response_body;
 		if (!it->second(this, who, body_stream, std::move(binary_req), response_body))
 			return false;
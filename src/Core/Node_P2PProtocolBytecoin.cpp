@@ -4,11 +4,13 @@
 #include <iostream>
 #include "Config.hpp"
 #include "CryptoNoteTools.hpp"
+#include "Difficulty.hpp"
 #include "Node.hpp"
 #include "TransactionExtra.hpp"
 #include "common/JsonValue.hpp"
 #include "p2p/PeerDB.hpp"
 #include "platform/PathTools.hpp"
+#include "platform/Time.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
 #include "seria/KVBinaryInputStream.hpp"
@@ -17,6 +19,21 @@
 
 using namespace cn;
 
+// Peer gets blocks for that many seconds of its measured throughput in flight (plus its latency)
+static const double DOWNLOAD_QUOTA_SECONDS = 2;
+// Quota before first block from peer is measured, so unknown slow peer cannot hold much of window
+static const size_t DOWNLOAD_INITIAL_QUOTA = 4;
+// Moving average weight of new sample
+static const double DOWNLOAD_STATS_ALPHA = 0.2;
+// Head-of-line block is also asked from faster peer if it is late by that many latencies of its downloader
+static const double HEDGE_LATENCY_FACTOR = 3;
+static const double HEDGE_MIN_SECONDS    = 1;
+static const size_t HEDGE_HEAD_BLOCKS    = 16;
+// Headers are small, so we keep several batches in flight to validate chain far ahead of bodies
+static const size_t HEADERS_IN_FLIGHT = 4 * p2p::GetObjects::Request::MAX_BATCH_COUNT;
+// Known objects per peer, more than transactions relayed during several blocks on busy network
+static const size_t KNOWN_OBJECTS_GENERATION = 8192;
+
 static bool greater_fee_per_byte(const TransactionDesc &a, const TransactionDesc &b) {
 	invariant(a.size != 0 && b.size != 0, "");
 	const auto afb = a.fee / a.size;
@@ -29,6 +46,7 @@ Node::P2PProtocolBytecoin::P2PProtocolBytecoin(Node *node, P2PClient *client)
     , m_node(node)
     , m_chain_timer(std::bind(&P2PProtocolBytecoin::on_chain_timer, this))
     , m_download_timer(std::bind(&P2PProtocolBytecoin::on_download_timer, this))
+    , m_known_objects(KNOWN_OBJECTS_GENERATION, crypto::rand<uint64_t>())
     , m_syncpool_timer(std::bind(&P2PProtocolBytecoin::on_syncpool_timer, this))
     , m_download_transactions_timer(std::bind(&P2PProtocolBytecoin::on_download_transactions_timer, this)) {}
 
@@ -36,8 +54,9 @@ Node::P2PProtocolBytecoin::~P2PProtocolBytecoin() = default;
 
 CoreSyncData Node::P2PProtocolBytecoin::get_my_sync_data() const {
 	CoreSyncData sync_data;
-	sync_data.current_height = m_node->m_block_chain.get_tip_height();
-	sync_data.top_id         = m_node->m_block_chain.get_tip_bid();
+	sync_data.current_height      = m_node->m_block_chain.get_tip_height();
+	sync_data.top_id              = m_node->m_block_chain.get_tip_bid();
+	sync_data.pruned_below_height = m_node->m_block_chain.get_pruned_below_height();
 	return sync_data;
 }
 
@@ -63,7 +82,7 @@ void Node::P2PProtocolBytecoin::on_chain_timer() {
 }
 
 void Node::P2PProtocolBytecoin::on_download_timer() {
-	invariant(m_downloading_block_count != 0, "");
+	invariant(!m_requested_blocks.empty() || !m_requested_headers.empty(), "");
 	m_node->m_log(logging::TRACE) << "on_download_timer, disconnecting " << get_address();
 	disconnect(std::string{});
 }
@@ -115,47 +134,266 @@ void Node::P2PProtocolBytecoin::advance_chain() {
 	send(std::move(raw_msg));
 }
 
+size_t Node::P2PProtocolBytecoin::get_download_quota() const {
+	const size_t max_quota = m_node->m_config.max_downloading_blocks_from_each_peer;
+	if (m_downloaded_block_count == 0)
+		return std::min(max_quota, DOWNLOAD_INITIAL_QUOTA);
+	// Bandwidth-delay product, so fast peer is never idle and slow one keeps few blocks of window
+	const double quota =
+	    m_download_bytes_per_second * (m_download_latency_seconds + DOWNLOAD_QUOTA_SECONDS) / m_download_block_size;
+	return std::max<size_t>(1, std::min(max_quota, static_cast<size_t>(quota)));
+}
+
+void Node::P2PProtocolBytecoin::update_download_stats(
+    std::chrono::steady_clock::time_point request_time, size_t block_size) {
+	const auto now = std::chrono::steady_clock::now();
+	// Requests are pipelined, so block was transferring since previous block or request, whichever is later
+	const auto transfer_start = std::max(request_time, m_last_block_received);
+	const double transfer_seconds = std::max(0.001, std::chrono::duration<double>(now - transfer_start).count());
+	const double latency_seconds  = std::chrono::duration<double>(now - request_time).count();
+	const double bytes_per_second = block_size / transfer_seconds;
+	m_last_block_received         = now;
+	if (m_downloaded_block_count == 0) {
+		m_download_bytes_per_second = bytes_per_second;
+		m_download_latency_seconds  = latency_seconds;
+		m_download_block_size       = std::max<double>(1, block_size);
+	} else {
+		m_download_bytes_per_second += DOWNLOAD_STATS_ALPHA * (bytes_per_second - m_download_bytes_per_second);
+		m_download_latency_seconds += DOWNLOAD_STATS_ALPHA * (latency_seconds - m_download_latency_seconds);
+		m_download_block_size += DOWNLOAD_STATS_ALPHA * (std::max<double>(1, block_size) - m_download_block_size);
+	}
+	m_downloaded_block_count += 1;
+}
+
+bool Node::P2PProtocolBytecoin::request_block(
+    std::map<Hash, DownloadInfo>::iterator cit, size_t index_in_chain, bool hedge) {
+	if (m_chain_start_height + index_in_chain < get_peer_sync_data().pruned_below_height)
+		return false;  // peer is pruned, other peers will download
+	const auto now = std::chrono::steady_clock::now();
+	if (!m_requested_blocks.insert(std::make_pair(cit->first, now)).second)
+		return false;  // still waiting for our previous request, for example after we lost hedge race
+	if (hedge) {
+		cit->second.who_hedging = this;
+		m_hedged_request_count += 1;
+	} else {
+		cit->second.who_downloading = this;
+		cit->second.expected_height = static_cast<Height>(m_chain_start_height + index_in_chain);
+	}
+	if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_node->log_request_timestamp).count() > 1000) {
+		m_node->log_request_timestamp = now;
+		std::cout << "Requesting block " << m_chain_start_height + index_in_chain << " from " << get_address()
+		          << std::endl;
+	}
+	m_node->m_log(logging::TRACE) << "advance_download requesting block " << m_chain_start_height + index_in_chain
+	                              << " hash=" << cit->first << " from " << get_address() << (hedge ? " (hedge)" : "");
+	if (m_requested_blocks.size() == 1)
+		m_download_timer.once(m_node->m_config.download_block_timeout);
+	return true;
+}
+
+void Node::P2PProtocolBytecoin::send_get_objects(const std::vector<Hash> &ids, bool blocks, bool headers_only) {
+	const size_t batch = std::min<size_t>(get_peer_get_objects_batch(), p2p::GetObjects::Request::MAX_BATCH_COUNT);
+	for (size_t i = 0; i < ids.size(); i += batch) {
+		p2p::GetObjects::Request msg;
+		msg.headers_only = headers_only;
+		auto &msg_ids    = blocks ? msg.blocks : msg.txs;
+		msg_ids.assign(ids.begin() + i, ids.begin() + std::min(ids.size(), i + batch));
+		send(LevinProtocol::send(msg));
+	}
+}
+
+void Node::P2PProtocolBytecoin::pop_chain_front() {
+	m_previous_chain_hash = m_chain.front()->first;
+	m_chain_start_height += 1;
+	if (m_headers_validated != 0)
+		m_headers_validated -= 1;
+	m_chain.pop_front();
+}
+
+void Node::P2PProtocolBytecoin::advance_headers() {
+	if (!headers_first())
+		return;
+	const bool was_idle = m_requested_blocks.empty() && m_requested_headers.empty();
+	std::vector<Hash> request_header_ids;
+	const size_t window = std::min(m_chain.size(), m_headers_validated + m_node->m_config.download_window);
+	for (size_t i = m_headers_validated; i < window && m_requested_headers.size() < HEADERS_IN_FLIGHT; ++i) {
+		if (m_chain_start_height + i < get_peer_sync_data().pruned_below_height)
+			continue;  // peer is pruned, we will validate when other peers add those blocks
+		auto cit = m_chain.at(i);
+		if (cit->second.header_valid || cit->second.header_preparing || cit->second.who_downloading_header)
+			continue;
+		if (m_node->m_block_chain.has_header(cit->first))
+			continue;
+		cit->second.who_downloading_header = this;
+		cit->second.expected_height        = static_cast<Height>(m_chain_start_height + i);
+		m_requested_headers.insert(cit->first);
+		request_header_ids.push_back(cit->first);
+	}
+	if (request_header_ids.empty())
+		return;
+	m_node->m_log(logging::TRACE) << "advance_headers requesting " << request_header_ids.size()
+	                              << " headers from " << get_address();
+	if (was_idle)
+		m_download_timer.once(m_node->m_config.download_block_timeout);
+	send_get_objects(request_header_ids, true, true);
+}
+
+bool Node::P2PProtocolBytecoin::validate_headers() {
+	boost::variant<ConsensusError, PreparedHeader> result = ConsensusError{""};
+	while (m_headers_validated < m_chain.size()) {
+		auto cit = m_chain.at(m_headers_validated);
+		if (!cit->second.header_valid) {
+			api::BlockHeader info;
+			if (m_node->m_block_chain.get_header(cit->first, &info)) {  // added from other peer
+				if (cit->second.header_preparing)
+					m_node->m_pow_checker.cancel_header(cit->first);
+				cit->second.header_preparing      = false;
+				cit->second.header_valid          = true;
+				cit->second.timestamp             = info.timestamp;
+				cit->second.cumulative_difficulty = info.cumulative_difficulty;
+			} else {
+				if (!cit->second.header_preparing || !m_node->m_pow_checker.get_prepared_header(cit->first, &result))
+					break;
+				cit->second.header_preparing = false;
+				if (!validate_header(cit, result))
+					return false;
+			}
+		}
+		m_headers_validated += 1;
+	}
+	return true;
+}
+
+bool Node::P2PProtocolBytecoin::validate_header(
+    std::map<Hash, DownloadInfo>::iterator cit, const boost::variant<ConsensusError, PreparedHeader> &result) {
+	if (const ConsensusError *err = boost::get<ConsensusError>(&result)) {
+		m_node->m_log(logging::INFO) << "validate_header consensus error what=" << err->what();
+		disconnect(std::string{"validate_header what="} + err->what());
+		return false;
+	}
+	const PreparedHeader &ph = boost::get<PreparedHeader>(result);
+	invariant(ph.bid == cit->first, "");
+	const auto &currency = m_node->m_block_chain.get_currency();
+	const Height height  = static_cast<Height>(m_chain_start_height + m_headers_validated);
+	const Hash previous_bid =
+	    m_headers_validated == 0 ? m_previous_chain_hash : m_chain.at(m_headers_validated - 1)->first;
+	if (ph.header.previous_block_hash != previous_bid) {
+		disconnect("validate_header chain not linked at height " + common::to_string(height));
+		return false;
+	}
+	if (ph.header.timestamp > platform::now_unix_timestamp() + currency.block_future_time_limit) {
+		disconnect("validate_header timestamp too far in future");
+		return false;
+	}
+	// Difficulty window goes through validated headers of m_chain, then continues in blockchain
+	api::BlockHeader prev_info;
+	invariant(m_node->m_block_chain.get_header(m_previous_chain_hash, &prev_info), "");
+	const size_t pending = std::min<size_t>(m_headers_validated, currency.difficulty_windows());
+	std::vector<Timestamp> timestamps;
+	std::vector<CumulativeDifficulty> difficulties;
+	timestamps.reserve(pending);
+	difficulties.reserve(pending);
+	for (size_t i = m_headers_validated - pending; i != m_headers_validated; ++i) {
+		timestamps.push_back(m_chain.at(i)->second.timestamp);
+		difficulties.push_back(m_chain.at(i)->second.cumulative_difficulty);
+	}
+	CumulativeDifficulty cumulative_difficulty{};
+	const Difficulty difficulty = m_node->m_block_chain.get_next_header_difficulty(
+	    prev_info, ph.header.major_version, timestamps, difficulties, &cumulative_difficulty);
+	if (currency.is_in_hard_checkpoint_zone(height)) {
+		bool is_checkpoint = false;
+		if (!currency.check_hard_checkpoint(height, ph.bid, is_checkpoint)) {
+			disconnect("validate_header does not pass through hard checkpoint at height " + common::to_string(height));
+			return false;
+		}
+	} else if (ph.pow_hash == Hash{} || !check_hash(ph.pow_hash, difficulty)) {
+		// pow_hash is not calculated if peer lied about height at request
+		disconnect("validate_header proof of work too weak at height " + common::to_string(height));
+		return false;
+	}
+	cit->second.header_valid          = true;
+	cit->second.pow_hash              = ph.pow_hash;
+	cit->second.timestamp             = ph.header.timestamp;
+	cit->second.cumulative_difficulty = cumulative_difficulty;
+	m_node->m_log(logging::TRACE) << "validate_header height=" << height << " hash=" << cit->first << " from "
+	                              << get_address();
+	return true;
+}
+
 void Node::P2PProtocolBytecoin::advance_blocks() {
 	// Remove already added to the block chain
 	while (!m_chain.empty() && m_node->m_block_chain.has_header(m_chain.front()->first) &&
-	       m_chain.front()->second.who_downloading != this) {
-		m_previous_chain_hash = m_chain.front()->first;
-		m_chain_start_height += 1;
+	       m_chain.front()->second.who_downloading != this && m_chain.front()->second.who_hedging != this) {
 		m_node->remove_chain_block(m_chain.front());
-		m_chain.pop_front();
+		pop_chain_front();
 	}
-	if (m_downloading_block_count >= m_node->m_config.max_downloading_blocks_from_each_peer)
-		return;
-	size_t we_downloading = 0;
+	advance_headers();
+	const size_t quota = get_download_quota();
 	std::vector<Hash> request_block_ids;
-	for (size_t i = 0; i < std::min(m_chain.size(), m_node->m_config.download_window) &&
-	                   we_downloading < m_node->m_config.max_downloading_blocks_from_each_peer;
+	// Slow peer holding head of window stops everyone, so we also ask for its late blocks if we are faster
+	const auto now = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < std::min(m_chain.size(), HEDGE_HEAD_BLOCKS) && m_requested_blocks.size() < quota; ++i) {
+		auto cit                        = m_chain.at(i);
+		P2PProtocolBytecoin *downloader = cit->second.who_downloading;
+		if (!downloader || downloader == this || cit->second.who_hedging || cit->second.preparing)
+			continue;
+		if (m_download_bytes_per_second <= downloader->m_download_bytes_per_second)
+			continue;
+		auto rit = downloader->m_requested_blocks.find(cit->first);
+		invariant(rit != downloader->m_requested_blocks.end(), "");
+		const double late_seconds = std::chrono::duration<double>(now - rit->second).count();
+		if (late_seconds < std::max(HEDGE_MIN_SECONDS, HEDGE_LATENCY_FACTOR * downloader->m_download_latency_seconds))
+			continue;
+		if (request_block(cit, i, true))
+			request_block_ids.push_back(cit->first);
+	}
+	// Bodies only for chain with valid headers, so peer with invalid chain cannot make us download it
+	const size_t body_window = headers_first() ? m_headers_validated : m_chain.size();
+	for (size_t i = 0; i < std::min(body_window, m_node->m_config.download_window) &&
+	                   m_requested_blocks.size() < quota;
 	     ++i) {
+		if (m_chain_start_height + i < get_peer_sync_data().pruned_below_height)
+			continue;  // peer is pruned, other peers will download, but peer has blocks above
 		auto cit = m_chain.at(i);
-		if (cit->second.who_downloading || cit->second.preparing) {
-			we_downloading += (cit->second.who_downloading == this) ? 1 : 0;
+		if (cit->second.who_downloading || cit->second.who_hedging || cit->second.preparing)
+			continue;
+		if (request_block(cit, i, false))
+			request_block_ids.push_back(cit->first);
+	}
+	send_get_objects(request_block_ids, true);
+}
+
+void Node::P2PProtocolBytecoin::fill_connection_statistics(ConnectionDesc *desc) const {
+	desc->download_bytes_per_second = static_cast<uint64_t>(m_download_bytes_per_second);
+	desc->download_latency_ms       = static_cast<uint32_t>(m_download_latency_seconds * 1000);
+	desc->download_quota            = get_download_quota();
+	desc->downloading_block_count   = m_requested_blocks.size();
+	desc->downloaded_block_count    = m_downloaded_block_count;
+	desc->hedged_request_count      = m_hedged_request_count;
+	desc->relay_suppressed_count    = m_relay_suppressed_count;
+}
+
+void Node::P2PProtocolBytecoin::relay_transactions(const std::vector<TransactionDesc> &descs) {
+	p2p::RelayTransactions::Notify msg;
+	for (const auto &desc : descs) {
+		if (m_known_objects.contains(desc.hash.data, sizeof(desc.hash.data))) {
+			m_relay_suppressed_count += 1;
 			continue;
 		}
-		we_downloading += 1;
-		cit->second.who_downloading = this;
-		cit->second.expected_height = static_cast<Height>(m_chain_start_height + i);
-		m_downloading_block_count += 1;
-		request_block_ids.push_back(cit->first);
-		const auto now = std::chrono::steady_clock::now();
-		if (std::chrono::duration_cast<std::chrono::milliseconds>(now - m_node->log_request_timestamp).count() > 1000) {
-			m_node->log_request_timestamp = now;
-			std::cout << "Requesting block " << m_chain_start_height + i << " from " << get_address() << std::endl;
-		}
-		m_node->m_log(logging::TRACE) << "advance_download requesting block " << m_chain_start_height + i
-		                              << " hash=" << cit->first << " from " << get_address();
+		add_known_object(desc.hash);
+		msg.transaction_descs.push_back(desc);
 	}
-	if (!request_block_ids.empty())
-		m_download_timer.once(m_node->m_config.download_block_timeout);
-	for (const auto &bid : request_block_ids) {
-		p2p::GetObjects::Request msg;
-		msg.blocks.push_back(bid);
+	if (!msg.transaction_descs.empty())
 		send(LevinProtocol::send(msg));
+}
+
+void Node::P2PProtocolBytecoin::relay_block(const Hash &bid, const BinaryArray &raw_msg) {
+	if (m_known_objects.contains(bid.data, sizeof(bid.data))) {
+		m_relay_suppressed_count += 1;
+		return;
 	}
+	add_known_object(bid);
+	send(BinaryArray(raw_msg));  // Move is impossible here
 }
 
 void Node::P2PProtocolBytecoin::advance_transactions() {
@@ -188,6 +426,7 @@ bool Node::P2PProtocolBytecoin::on_transaction_descs(const std::vector<Transacti
 			disconnect("SyncPool desc size == 0");
 			return false;
 		}
+		add_known_object(desc.hash);
 		Amount fee_per_byte = desc.fee / desc.size;
 		//		TODO - uncomment when no 3.4.0 version is running in the wild
 		//		if (fee_per_byte > previous_fee_per_byte ||
@@ -214,13 +453,13 @@ bool Node::P2PProtocolBytecoin::on_transaction_descs(const std::vector<Transacti
 	if (!request_transaction_descs.empty())
 		m_download_transactions_timer.once(m_node->m_config.download_transaction_timeout);
 	m_downloading_transaction_count += request_transaction_descs.size();
+	std::vector<Hash> request_tids;
 	for (const auto &desc : request_transaction_descs) {
 		invariant(m_transaction_descs.insert(std::make_pair(desc.hash, desc)).second, "");
 		invariant(m_node->downloading_transactions.insert(std::make_pair(desc.hash, this)).second, "");
-		p2p::GetObjects::Request msg;
-		msg.txs.push_back(desc.hash);
-		send(LevinProtocol::send(msg));
+		request_tids.push_back(desc.hash);
 	}
+	send_get_objects(request_tids, false);
 	return true;
 }
 
@@ -242,6 +481,8 @@ void Node::P2PProtocolBytecoin::transaction_download_finished(const Hash &tid, b
 }
 
 bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point idle_start) {
+	if (!validate_headers())
+		return false;
 	size_t added_counter                                 = 0;
 	boost::variant<ConsensusError, PreparedBlock> result = ConsensusError{""};
 	while (!m_chain.empty() && m_node->m_pow_checker.get_prepared_block(m_chain.front()->first, &result)) {
@@ -253,12 +494,12 @@ bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point id
 			disconnect(std::string{"on_idle prepared what="} + err->what());
 			return false;
 		}
-		const PreparedBlock &pb = boost::get<PreparedBlock>(result);
+		PreparedBlock &pb = boost::get<PreparedBlock>(result);
 		invariant(pb.bid == cit->first, "");
 		invariant(cit->second.who_downloading == nullptr, "");
-		m_previous_chain_hash = cit->first;
-		m_chain_start_height += 1;
-		m_chain.pop_front();
+		if (pb.pow_hash == Hash{})
+			pb.pow_hash = cit->second.pow_hash;  // checked with header, if header-first
+		pop_chain_front();
 		const Height expected_height = cit->second.expected_height;
 		cit->second.preparing        = false;
 		m_node->remove_chain_block(cit);
@@ -287,8 +528,7 @@ bool Node::P2PProtocolBytecoin::on_idle(std::chrono::steady_clock::time_point id
 				m_node->m_log(logging::INFO)
 				    << "Added last (from batch) downloaded block height=" << info.height << " bid=" << info.hash;
 				p2p::TimedSync::Notify req;
-				req.payload_data =
-				    CoreSyncData{m_node->m_block_chain.get_tip_height(), m_node->m_block_chain.get_tip_bid()};
+				req.payload_data    = get_my_sync_data();
 				BinaryArray raw_msg = LevinProtocol::send(req);
 				m_node->broadcast(
 				    nullptr, raw_msg);  // nullptr - we can not always know which connection was block source
@@ -356,6 +596,7 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_chain(p2p::GetChain::Respo
 	if (!m_node->m_block_chain.get_header(req.m_block_ids.front(), &info))
 		return disconnect("Chain does not start with hash we have");
 	m_chain_start_height = info.height;
+	m_headers_validated  = 0;
 	// TODO - prevent wrong order
 	for (const auto &bid : req.m_block_ids) {
 		if (m_node->m_block_chain.has_header(bid)) {
@@ -379,41 +620,71 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_chain(p2p::GetChain::Respo
 }
 
 void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjects::Request &&req) {
-	if (req.txs.size() + req.blocks.size() != 1)
-		return disconnect("Must be 1 block or 1 transaction in GetObjectsRequest");
+	const size_t count = req.txs.size() + req.blocks.size();
+	if (count == 0 || count > p2p::GetObjects::Request::MAX_BATCH_COUNT)
+		return disconnect("Must be from 1 to MAX_BATCH_COUNT blocks or transactions in GetObjectsRequest");
+	const size_t budget = req.max_response_size == 0
+	                          ? size_t(p2p::GetObjects::Request::MAX_RESPONSE_SIZE)
+	                          : std::min<size_t>(req.max_response_size, p2p::GetObjects::Request::MAX_RESPONSE_SIZE);
+	size_t response_size = 0;
+	bool budget_reached  = false;
+	auto fits_budget     = [&](size_t size) -> bool {  // first object is always sent
+		budget_reached = budget_reached || (response_size != 0 && response_size + size > budget);
+		if (!budget_reached)
+			response_size += size;
+		return !budget_reached;
+	};
 	p2p::GetObjects::Response msg;
 	for (const auto &bid : req.blocks) {
+		if (budget_reached) {
+			msg.over_budget_ids.push_back(bid);
+			continue;
+		}
 		RawBlock raw_block;
 		if (m_node->m_block_chain.get_block(bid, &raw_block)) {
-			msg.blocks.push_back(std::move(raw_block));
+			if (req.headers_only)
+				raw_block.transactions.clear();
+			size_t size = raw_block.block.size();
+			for (const auto &tx : raw_block.transactions)
+				size += tx.size();
+			if (fits_budget(size))
+				msg.blocks.push_back(std::move(raw_block));
+			else
+				msg.over_budget_ids.push_back(bid);
 			continue;
 		}
 		msg.missed_ids.push_back(bid);
 	}
 	for (const auto &tid : req.txs) {
-		const auto &pool = m_node->m_block_chain.get_memory_state_transactions();
-		auto tit         = pool.find(tid);
-		if (tit != pool.end()) {
-			msg.txs.push_back(tit->second.binary_tx);
+		if (budget_reached) {
+			msg.over_budget_ids.push_back(tid);
 			continue;
 		}
+		const auto &pool = m_node->m_block_chain.get_memory_state_transactions();
+		auto tit         = pool.find(tid);
 		BinaryArray binary_tx;
 		size_t index_in_block = 0;
 		Height block_height   = 0;
 		Hash block_hash;
-		if (m_node->m_block_chain.get_transaction(tid, &binary_tx, &block_height, &block_hash, &index_in_block)) {
-			msg.txs.push_back(std::move(binary_tx));
+		if (tit != pool.end())
+			binary_tx = tit->second.binary_tx;
+		else if (!m_node->m_block_chain.get_transaction(tid, &binary_tx, &block_height, &block_hash, &index_in_block)) {
+			msg.missed_ids.push_back(tid);
 			continue;
 		}
-		msg.missed_ids.push_back(tid);
+		if (fits_budget(binary_tx.size()))
+			msg.txs.push_back(std::move(binary_tx));
+		else
+			msg.over_budget_ids.push_back(tid);
 	}
 	send(LevinProtocol::send(msg));
 }
 
 void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjects::Response &&req) {
-	if (req.blocks.size() + req.txs.size() + req.missed_ids.size() != 1)
-		return disconnect("Too much objects in GetObjectsResponse");
-	for (auto &&rb : req.blocks) {  // 0 or 1
+	const std::string error = req.get_error();
+	if (!error.empty())
+		return disconnect(error);
+	for (auto &&rb : req.blocks) {
 		Hash bid;
 		try {
 			BlockTemplate bheader;
@@ -426,24 +697,53 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjects::R
 			disconnect("Bad Block Returned");
 			return;
 		}
-		auto cit = m_node->chain_blocks.find(bid);
-		if (cit == m_node->chain_blocks.end() || cit->second.who_downloading != this) {
+		auto hit = m_requested_headers.find(bid);
+		if (hit != m_requested_headers.end()) {
+			m_requested_headers.erase(hit);
+			if (!rb.transactions.empty())
+				return disconnect("Header Returned With Transactions");
+			auto cit = m_node->chain_blocks.find(bid);
+			if (cit == m_node->chain_blocks.end() || cit->second.who_downloading_header != this)
+				continue;
+			cit->second.who_downloading_header = nullptr;
+			cit->second.header_preparing       = true;
+			const bool check_pow =
+			    !m_node->m_block_chain.get_currency().is_in_hard_checkpoint_zone(cit->second.expected_height);
+			m_node->m_pow_checker.add_header(bid, check_pow, std::move(rb.block));
+			continue;
+		}
+		auto rit = m_requested_blocks.find(bid);
+		if (rit == m_requested_blocks.end()) {
 			m_node->m_log(logging::INFO) << "GetObjectsResponse received stray block from " << get_address();
 			disconnect("Stray Block Returned");
 			return;
 		}
+		size_t block_size = rb.block.size();
+		for (const auto &tx : rb.transactions)
+			block_size += tx.size();
+		update_download_stats(rit->second, block_size);
+		m_requested_blocks.erase(rit);
+		auto cit = m_node->chain_blocks.find(bid);
+		if (cit == m_node->chain_blocks.end() ||
+		    (cit->second.who_downloading != this && cit->second.who_hedging != this)) {
+			m_node->m_log(logging::TRACE) << "GetObjectsResponse received block already received from other peer "
+			                              << bid << " from " << get_address();
+			continue;  // we lost hedge race
+		}
 		cit->second.who_downloading = nullptr;
+		cit->second.who_hedging     = nullptr;
 		cit->second.preparing       = true;
-		invariant(m_downloading_block_count > 0, "");
-		m_downloading_block_count -= 1;
 		m_node->m_log(logging::TRACE) << "GetObjectsResponse received block " << cit->second.expected_height
 		                              << " hash=" << cit->first << " from " << get_address();
-		bool check_pow = m_node->m_config.paranoid_checks ||
-		                 !m_node->m_block_chain.get_currency().is_in_hard_checkpoint_zone(cit->second.expected_height);
+		const auto &currency = m_node->m_block_chain.get_currency();
+		// PoW of block with valid header was already checked by header-first sync
+		const bool check_pow = m_node->m_config.paranoid_checks ||
+		                       (cit->second.pow_hash == Hash{} &&
+		                           !currency.is_in_hard_checkpoint_zone(cit->second.expected_height));
 		m_node->m_pow_checker.add_block(bid, check_pow, std::move(rb));
 	}
 	p2p::RelayTransactions::Notify msg_v4;
-	for (const auto &btx : req.txs) {  // 0 or 1
+	for (const auto &btx : req.txs) {
 		Transaction tx;
 		try {
 			seria::from_binary(tx, btx);
@@ -514,7 +814,39 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjects::R
 			if (who != this)
 				who->transaction_download_finished(tid, false);
 	}
-	if (m_downloading_block_count != 0)
+	std::vector<Hash> request_tids;
+	for (const auto &id : req.over_budget_ids) {  // we will ask for them again
+		auto hit = m_requested_headers.find(id);
+		if (hit != m_requested_headers.end()) {
+			m_requested_headers.erase(hit);
+			auto cit = m_node->chain_blocks.find(id);
+			if (cit != m_node->chain_blocks.end() && cit->second.who_downloading_header == this)
+				cit->second.who_downloading_header = nullptr;
+			continue;
+		}
+		auto rit = m_requested_blocks.find(id);
+		if (rit != m_requested_blocks.end()) {
+			m_requested_blocks.erase(rit);
+			auto cit = m_node->chain_blocks.find(id);
+			if (cit == m_node->chain_blocks.end())
+				continue;
+			if (cit->second.who_downloading == this) {
+				cit->second.who_downloading = cit->second.who_hedging;
+				cit->second.who_hedging     = nullptr;
+			}
+			if (cit->second.who_hedging == this)
+				cit->second.who_hedging = nullptr;
+			continue;
+		}
+		auto cit = m_node->downloading_transactions.find(id);
+		if (cit == m_node->downloading_transactions.end() || cit->second != this) {
+			m_node->m_log(logging::INFO) << "GetObjectsResponse received stray over_budget_id from " << get_address();
+			return disconnect("Stray Over Budget Id Returned");
+		}
+		request_tids.push_back(id);
+	}
+	send_get_objects(request_tids, false);
+	if (!m_requested_blocks.empty() || !m_requested_headers.empty())
 		m_download_timer.once(m_node->m_config.download_block_timeout);
 	else
 		m_download_timer.cancel();
@@ -523,13 +855,10 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_objects(p2p::GetObjects::R
 	else
 		m_download_transactions_timer.cancel();
 	if (!msg_v4.transaction_descs.empty()) {
-		// Contains exactly 1 transaction
-		BinaryArray raw_msg_v4 = LevinProtocol::send(msg_v4);
-
-		m_node->broadcast(this, raw_msg_v4);
+		m_node->broadcast_transactions(this, msg_v4.transaction_descs);
 		m_node->advance_long_poll();
 	}
-	if (!req.blocks.empty())
+	if (!req.blocks.empty() || !req.over_budget_ids.empty())
 		advance_blocks();
 }
 
@@ -541,14 +870,20 @@ void Node::P2PProtocolBytecoin::on_disconnect(const std::string &ban_reason) {
 
 	for (const auto &cit : m_chain) {
 		if (cit->second.who_downloading == this) {
-			m_downloading_block_count -= 1;
-			cit->second.who_downloading = nullptr;
+			cit->second.who_downloading = cit->second.who_hedging;  // hedging peer continues alone
+			cit->second.who_hedging     = nullptr;
 		}
+		if (cit->second.who_hedging == this)
+			cit->second.who_hedging = nullptr;
+		if (cit->second.who_downloading_header == this)
+			cit->second.who_downloading_header = nullptr;
 		m_node->remove_chain_block(cit);
 	}
 	m_chain.clear();
+	m_requested_blocks.clear();
+	m_requested_headers.clear();
+	m_headers_validated = 0;
 	m_download_timer.cancel();
-	invariant(m_downloading_block_count == 0, "");
 
 	m_syncpool_request_sent = false;
 	m_syncpool_timer.cancel();
@@ -597,11 +932,15 @@ void Node::P2PProtocolBytecoin::on_msg_notify_request_tx_pool(p2p::SyncPool::Res
 	advance_transactions();
 }
 
-void Node::P2PProtocolBytecoin::on_msg_timed_sync(p2p::TimedSync::Notify &&req) { advance_chain(); }
+void Node::P2PProtocolBytecoin::on_msg_timed_sync(p2p::TimedSync::Notify &&req) {
+	add_known_object(req.payload_data.top_id);
+	advance_chain();
+}
 
 void Node::P2PProtocolBytecoin::on_msg_notify_new_block(p2p::RelayBlock::Notify &&req) {
 	if (!req.b.transactions.empty())
 		return disconnect("RelayBlock only header is allowed");
+	add_known_object(req.top_id);
 	if (m_node->m_block_chain.has_header(req.top_id))
 		return;
 	BlockTemplate header;
@@ -622,7 +961,8 @@ void Node::P2PProtocolBytecoin::on_msg_notify_new_block(p2p::RelayBlock::Notify
 			continue;
 		}
 		// We cannot reassemble block from transactions, will download it normally
-		set_peer_sync_data(CoreSyncData{req.current_blockchain_height, req.top_id});
+		set_peer_sync_data(
+		    CoreSyncData{req.current_blockchain_height, req.top_id, get_peer_sync_data().pruned_below_height});
 		advance_chain();
 		return;
 	}
@@ -635,18 +975,18 @@ void Node::P2PProtocolBytecoin::on_msg_notify_new_block(p2p::RelayBlock::Notify
 	if (m_node->m_block_chain.add_block(pb, &info, false, get_address().to_string())) {
 		if (req.current_blockchain_height != info.height)
 			return disconnect("RelayBlock lied about current_blockchain_height");
-		set_peer_sync_data(CoreSyncData{info.height, pb.bid});
+		set_peer_sync_data(CoreSyncData{info.height, pb.bid, get_peer_sync_data().pruned_below_height});
 		p2p::RelayBlock::Notify req_v4;
 		req_v4.b.block                   = req.b.block;
 		req_v4.top_id                    = info.hash;
 		req_v4.current_blockchain_height = info.height;
 
 		BinaryArray raw_msg_v4 = LevinProtocol::send(req_v4);
-		// TODO - broadcast to only those who do not have it
-		m_node->broadcast(this, raw_msg_v4);
+		m_node->broadcast_block(this, info.hash, raw_msg_v4);
 		m_node->advance_long_poll();
 	} else {
-		set_peer_sync_data(CoreSyncData{req.current_blockchain_height, pb.bid});
+		set_peer_sync_data(
+		    CoreSyncData{req.current_blockchain_height, pb.bid, get_peer_sync_data().pruned_below_height});
 	}
 }
 
@@ -665,7 +1005,7 @@ void Node::P2PProtocolBytecoin::on_msg_notify_checkpoint(p2p::Checkpoint::Notify
 	m_node->broadcast(nullptr, raw_msg);  // nullptr, not this - so a sender sees "reflection" of message
 	// TODO - investigate reason for TimedSync broadcast here
 	p2p::TimedSync::Notify ts_req;
-	ts_req.payload_data = CoreSyncData{m_node->m_block_chain.get_tip_height(), m_node->m_block_chain.get_tip_bid()};
+	ts_req.payload_data = get_my_sync_data();
 	raw_msg             = LevinProtocol::send(ts_req);
 	m_node->broadcast(nullptr, raw_msg);
 	m_node->advance_long_poll();
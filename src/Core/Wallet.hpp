@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include "CryptoNote.hpp"
 #include "Currency.hpp"
+#include "common/FlatHashMap.hpp"
 #include "crypto/chacha.hpp"
 #include "logging/LoggerMessage.hpp"
 
@@ -40,7 +41,7 @@ protected:
 	PublicKey m_view_public_key;
 	SecretKey m_view_secret_key;
 	std::vector<WalletRecord> m_wallet_records;
-	std::unordered_map<PublicKey, size_t> m_records_map;  // index into vector
+	common::FlatHashMap<PublicKey, size_t> m_records_map;  // index into vector
 
 	Hash m_seed;       // Main seed, never used directly
 	Hash m_view_seed;  // Hashed from seed
@@ -8,6 +8,7 @@
 #include "TransactionExtra.hpp"
 #include "common/BIPs.hpp"
 #include "common/Math.hpp"
+#include "common/Metrics.hpp"
 #include "http/Server.hpp"
 #include "platform/Time.hpp"
 #include "seria/BinaryInputStream.hpp"
@@ -82,6 +83,18 @@ bool WalletNode::on_api_http_request(http::Client *who, http::RequestBody &&requ
 		if (method_found)
 			return result;
 	}
+	if (request.r.uri == "/metrics") {  // metrics of this process, not tunneled
+		if (!m_config.walletd_authorization.empty() &&
+		    request.r.basic_authorization != m_config.walletd_authorization) {
+			response.r.headers.push_back({"WWW-Authenticate", "Basic realm=\"Wallet\", charset=\"UTF-8\""});
+			response.r.status = 401;
+			return true;
+		}
+		response.r.headers.push_back({"Content-Type", "text/plain; version=0.0.4"});
+		response.r.status = 200;
+		response.set_body(common::metrics::registry().to_prometheus_text());
+		return true;
+	}
 	m_log(logging::INFO) << "http_request node tunneling url=" << request.r.uri
 	                     << " start of body=" << request.body.substr(0, 200);
 	http::RequestBody original_request;
@@ -122,10 +135,34 @@ void WalletNode::on_api_http_disconnect(http::Client *who) {
 			++lit;
 }
 
+static common::metrics::Histogram &rpc_request_seconds(const std::string &method) {
+	// Handlers are fixed, so histograms are looked up once instead of locking registry on each request
+	static const auto histograms = []() {
+		std::unordered_map<std::string, common::metrics::Histogram *> result;
+		for (const auto &hit : WalletNode::m_jsonrpc_handlers)
+			result[hit.first] = &common::metrics::registry().histogram("rpc_request_seconds", "RPC handler duration",
+			    common::metrics::label("server", "walletd") + "," + common::metrics::label("method", hit.first));
+		return result;
+	}();
+	return *histograms.at(method);
+}
+
 bool WalletNode::on_json_rpc(
     http::Client *who, http::RequestBody &&request, http::ResponseBody &response, bool &method_found) {
 	method_found = false;
 	response.r.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
+	if (json_rpc::is_batch(request.body)) {  // Batch is never tunneled, all methods must be ours
+		method_found = true;
+		if (!m_config.walletd_authorization.empty() &&
+		    request.r.basic_authorization != m_config.walletd_authorization) {
+			response.r.headers.push_back({"WWW-Authenticate", "Basic realm=\"Wallet\", charset=\"UTF-8\""});
+			response.r.status = 401;
+			return true;
+		}
+		on_json_rpc_batch(who, request, response);
+		response.r.status = 200;
+		return true;
+	}
 
 	common::JsonValue jid(nullptr);
 	bool nas = false;
@@ -146,6 +183,7 @@ bool WalletNode::on_json_rpc(
 			response.r.status = 401;
 			return true;
 		}
+		common::metrics::ScopeTimer timer(rpc_request_seconds(it->first));
 		std::string response_body;
 		if (!it->second(this, who, std::move(request), std::move(json_req), response_body))
 			return false;
@@ -160,6 +198,37 @@ bool WalletNode::on_json_rpc(
 	return true;
 }
 
+void WalletNode::on_json_rpc_batch(
+    http::Client *who, const http::RequestBody &request, http::ResponseBody &response) {
+	// These methods wait for long poll or for bytecoind, then answer with separate http response
+	static const std::set<std::string> async_methods = []() {
+		std::set<std::string> result{api::walletd::GetStatus::method(), api::walletd::CreateTransaction::method(),
+		    api::walletd::SendTransaction::method(), api::walletd::CreateSendproof::method()};
+#ifdef __EMSCRIPTEN__
+		// WalletNodeExt answers after wallet file is saved to or loaded from IndexedDB
+		result.insert(api::walletd::ExtCreateWallet::method());
+		result.insert(api::walletd::ExtOpenWallet::method());
+#endif
+		return result;
+	}();
+	try {
+		response.set_body(json_rpc::process_batch(request.body, [&](json_rpc::Request &&json_req, std::string &body) {
+			auto it = m_jsonrpc_handlers.find(json_req.get_method());
+			if (it == m_jsonrpc_handlers.end())
+				throw json_rpc::Error(json_rpc::METHOD_NOT_FOUND, "Method not found " + json_req.get_method());
+			if (async_methods.count(it->first) != 0)
+				throw json_rpc::Error(json_rpc::INVALID_REQUEST, "Method " + it->first + " cannot be called in batch");
+			common::metrics::ScopeTimer timer(rpc_request_seconds(it->first));
+			http::RequestBody element_request;
+			element_request.r = request.r;
+			if (!it->second(this, who, std::move(element_request), std::move(json_req), body))
+				throw json_rpc::Error(json_rpc::INTERNAL_ERROR, "Method " + it->first + " did not answer in batch");
+		}));
+	} catch (const json_rpc::Error &err) {
+		response.set_body(json_rpc::create_error_response_body(err, common::JsonValue(nullptr), false));
+	}
+}
+
 // New protocol
 
 api::walletd::GetStatus::Response WalletNode::create_status_response() const {
@@ -110,6 +110,7 @@ protected:
 	virtual void on_api_http_disconnect(http::Client *);
 
 	bool on_json_rpc(http::Client *, http::RequestBody &&, http::ResponseBody &, bool &method_found);
+	void on_json_rpc_batch(http::Client *, const http::RequestBody &, http::ResponseBody &);
 	void check_address_in_wallet_or_throw(const std::string &addr) const;
 
 	WalletState &get_wallet_state() { return m_wallet_sync->get_wallet_state(); }
@@ -19,7 +19,21 @@ PreparedWalletTransaction::PreparedWalletTransaction(const Hash &tid, size_t siz
     : PreparedWalletTransaction(
           tid, size, std::move(static_cast<TransactionPrefix &&>(tx)), o_handler, view_secret_key) {}
 
+PreparedWalletTransaction::PreparedWalletTransaction(const Hash &tid, size_t size, TransactionPrefix &&ttx,
+    const Hash &prefix_hash, const Hash &inputs_hash, const Wallet::OutputHandler &o_handler,
+    const SecretKey &view_secret_key)
+    : tid(tid), size(size), tx(std::move(ttx)), prefix_hash(prefix_hash), inputs_hash(inputs_hash) {
+	prepare_outputs(o_handler, view_secret_key);
+}
+
 void PreparedWalletTransaction::prepare(const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key) {
+	prefix_hash = get_transaction_prefix_hash(tx);
+	inputs_hash = get_transaction_inputs_hash(tx);
+	prepare_outputs(o_handler, view_secret_key);
+}
+
+void PreparedWalletTransaction::prepare_outputs(
+    const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key) {
 	// We ignore results of most crypto calls here and absence of tx_public_key
 	// All errors will lead to spend_key not found in our wallet for legacy crypto
 	PublicKey tx_public_key;
@@ -27,9 +41,6 @@ void PreparedWalletTransaction::prepare(const Wallet::OutputHandler &o_handler,
 		derivation = generate_key_derivation(tx_public_key, view_secret_key);
 	auto encrypted_messages = extra::get_encrypted_messages(tx.extra);
 
-	prefix_hash = get_transaction_prefix_hash(tx);
-	inputs_hash = get_transaction_inputs_hash(tx);
-
 	KeyPair tx_keys;
 	address_public_keys.reserve(tx.outputs.size() + encrypted_messages.size());
 	output_shared_secrets.reserve(tx.outputs.size() + encrypted_messages.size());
@@ -53,16 +64,27 @@ void PreparedWalletTransaction::prepare(const Wallet::OutputHandler &o_handler,
 }
 
 void PreparedWalletBlock::prepare(const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key) {
-	transactions.reserve(raw_block.raw_transactions.size());
+	transactions.reserve(raw_block.raw_transactions.size() + 1);
 	const Hash base_transaction_hash   = get_transaction_hash(this->raw_block.base_transaction);
 	const size_t base_transaction_size = seria::binary_size(this->raw_block.base_transaction);
+	// Prefix and inputs hashes of all transactions are calculated in one batch with multi-lane keccak
+	std::vector<BinaryArray> bodies;
+	bodies.reserve(2 * (raw_block.raw_transactions.size() + 1));
+	const TransactionPrefix &base_prefix = raw_block.base_transaction;
+	bodies.push_back(seria::to_binary(base_prefix));
+	bodies.push_back(seria::to_binary(base_prefix.inputs, base_prefix.version));
+	for (const auto &tx : raw_block.raw_transactions) {
+		bodies.push_back(seria::to_binary(tx));
+		bodies.push_back(seria::to_binary(tx.inputs, tx.version));
+	}
+	const std::vector<Hash> hashes = crypto::cn_fast_hash_batch(bodies);
 	// We pass copies because we wish to keep raw_block as is
-	transactions.emplace_back(base_transaction_hash, base_transaction_size, Transaction(raw_block.base_transaction),
-	    o_handler, view_secret_key);
+	transactions.emplace_back(base_transaction_hash, base_transaction_size, TransactionPrefix(base_prefix),
+	    hashes.at(0), hashes.at(1), o_handler, view_secret_key);
 	for (size_t tx_index = 0; tx_index != raw_block.raw_transactions.size(); ++tx_index) {
 		const Hash transaction_hash = raw_block.transaction_hashes.at(tx_index);
 		const size_t size           = raw_block.transaction_sizes.at(tx_index);
 		transactions.emplace_back(transaction_hash, size, TransactionPrefix(raw_block.raw_transactions.at(tx_index)),
-		    o_handler, view_secret_key);
+		    hashes.at(2 * tx_index + 2), hashes.at(2 * tx_index + 3), o_handler, view_secret_key);
 	}
 }
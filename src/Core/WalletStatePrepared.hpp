@@ -26,9 +26,15 @@ struct PreparedWalletTransaction {
 	    const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key);
 	PreparedWalletTransaction(const Hash &tid, size_t size, Transaction &&tx, const Wallet::OutputHandler &o_handler,
 	    const SecretKey &view_secret_key);
+	// prefix_hash and inputs_hash already calculated in batch by PreparedWalletBlock
+	PreparedWalletTransaction(const Hash &tid, size_t size, TransactionPrefix &&tx, const Hash &prefix_hash,
+	    const Hash &inputs_hash, const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key);
 
 	// TODO - remove constructors and always use prepare()?
 	void prepare(const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key);
+
+private:
+	void prepare_outputs(const Wallet::OutputHandler &o_handler, const SecretKey &view_secret_key);
 };
 
 struct PreparedWalletBlock {
@@ -52,6 +52,8 @@ void WalletSync::set_sync_error(const std::string &str, bool immediate_sync) {
 		m_log(logging::INFO) << "Sync successfully continues from state " << m_sync_error;
 	if (!str.empty() && m_sync_error != str)
 		m_log(logging::INFO) << "Sync stopped with error " << str;
+	if (!str.empty())
+		m_last_syncpool_pool_log_id = 0;  // pool changes could be lost, so compare whole pool next time
 	m_sync_error = str;
 	m_state_changed_handler();  // Not only sync error changed
 	if (immediate_sync)
@@ -60,8 +62,10 @@ void WalletSync::set_sync_error(const std::string &str, bool immediate_sync) {
 
 void WalletSync::on_hw_reconnect() {
 	m_hw_reconnect_timer.once(10.0f);
-	if (m_wallet_state.get_wallet().get_hw()->reconnect())
+	if (m_wallet_state.get_wallet().get_hw()->reconnect()) {
 		preparator.wallet_reconnected();
+		m_last_syncpool_pool_log_id = 0;  // transactions prepared while disconnected could be lost
+	}
 }
 
 bool WalletSync::on_prepared_block(const PreparedWalletBlock &block) {
@@ -175,7 +179,11 @@ void WalletSync::advance_sync() {
 void WalletSync::send_sync_pool() {
 	m_log(logging::TRACE) << "Sending SyncMemPool request";
 	api::cnd::SyncMemPool::Request msg;
-	msg.known_hashes = m_wallet_state.get_tx_pool_hashes();
+	if (m_last_syncpool_pool_log_id != 0) {  // daemon sends only changes since our last sync
+		msg.known_pool_version = m_last_syncpool_status.transaction_pool_version;
+		msg.known_pool_log_id  = m_last_syncpool_pool_log_id;
+	} else
+		msg.known_hashes = m_wallet_state.get_tx_pool_hashes();
 	http::RequestBody req_header;
 	req_header.r.set_firstline("POST", api::cnd::binary_url(), 1, 1);
 	req_header.r.basic_authorization = m_config.bytecoind_authorization;
@@ -204,6 +212,15 @@ void WalletSync::send_sync_pool() {
 			    return;
 		    }
 		    m_last_node_status = m_last_syncpool_status = resp.status;
+		    m_last_syncpool_pool_log_id                 = resp.pool_log_id;
+		    if (resp.removed_all) {  // we get whole pool, so remove what is not there
+			    std::set<Hash> pool_hashes;
+			    for (const auto &tx : resp.added_transactions)
+				    pool_hashes.insert(tx.hash);
+			    for (const auto &tid : m_wallet_state.get_tx_pool_hashes())
+				    if (pool_hashes.count(tid) == 0)
+					    resp.removed_hashes.push_back(tid);
+		    }
 		    m_wallet_state.sync_with_blockchain(resp.removed_hashes);
 		    size_t c = std::min(resp.added_raw_transactions.size(), resp.added_transactions.size());
 		    for (size_t i = 0; i != c; ++i) {
@@ -37,7 +37,8 @@ protected:
 
 	api::cnd::GetStatus::Response m_last_node_status;
 	api::cnd::GetStatus::Response m_last_syncpool_status;
-	bool last_static_sync_blocks_failed = false;
+	uint64_t m_last_syncpool_pool_log_id = 0;  // 0 if daemon does not support incremental pool sync
+	bool last_static_sync_blocks_failed  = false;
 	std::string m_sync_error;
 	void set_sync_error(const std::string &str, bool immediate_sync = false);
 
@@ -528,6 +528,37 @@ Hash cn::get_transaction_hash(const Transaction &tx) {
 	return crypto::cn_fast_hash(ba.data(), ba.size());
 }
 
+std::vector<Hash> cn::get_transaction_hashes(const std::vector<Transaction> &txs) {
+	// Amethyst hash is hash of (prefix hash, signatures hash) pair, so we need 2 batches
+	std::vector<BinaryArray> bodies;
+	bodies.reserve(2 * txs.size());
+	for (const auto &tx : txs) {
+		if (tx.version >= parameters::TRANSACTION_VERSION_AMETHYST) {
+			bodies.push_back(seria::to_binary(static_cast<const TransactionPrefix &>(tx)));
+			bodies.push_back(seria::to_binary(tx.signatures, static_cast<const TransactionPrefix &>(tx)));
+		} else
+			bodies.push_back(seria::to_binary(tx));
+	}
+	const std::vector<Hash> body_hashes = crypto::cn_fast_hash_batch(bodies);
+	std::vector<Hash> result(txs.size());
+	std::vector<size_t> amethyst_indexes;
+	bodies.clear();
+	size_t pos = 0;
+	for (size_t i = 0; i != txs.size(); ++i) {
+		if (txs[i].version >= parameters::TRANSACTION_VERSION_AMETHYST) {
+			std::pair<Hash, Hash> ha(body_hashes.at(pos), body_hashes.at(pos + 1));
+			pos += 2;
+			bodies.push_back(seria::to_binary(ha));
+			amethyst_indexes.push_back(i);
+		} else
+			result[i] = body_hashes.at(pos++);
+	}
+	const std::vector<Hash> pair_hashes = crypto::cn_fast_hash_batch(bodies);
+	for (size_t i = 0; i != amethyst_indexes.size(); ++i)
+		result[amethyst_indexes[i]] = pair_hashes[i];
+	return result;
+}
+
 Hash cn::get_block_hash(const BlockHeader &bh, const BlockBodyProxy &body_proxy) {
 	// get_object_hash prepends array size before hashing.
 	// this was a mistake of initial cryptonote developers
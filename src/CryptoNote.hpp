@@ -231,6 +231,8 @@ inline bool operator<(const AccountAddressAmethyst &a, const AccountAddressAmeth
 Hash get_transaction_inputs_hash(const TransactionPrefix &);
 Hash get_transaction_prefix_hash(const TransactionPrefix &);
 Hash get_transaction_hash(const Transaction &);
+// Same as get_transaction_hash for each transaction, but hashes are computed in batches with multi-lane keccak
+std::vector<Hash> get_transaction_hashes(const std::vector<Transaction> &);
 
 Hash get_block_hash(const BlockHeader &, const BlockBodyProxy &);
 Hash get_block_header_prehash(const BlockHeader &, const BlockBodyProxy &);
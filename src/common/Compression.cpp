@@ -0,0 +1,122 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "Compression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+// Sequence is token (literal length << 4 | match length - MIN_MATCH), extra literal length bytes, literals,
+// 2-byte little-endian offset, extra match length bytes. Length nibble 15 is followed by bytes
+// added to it until byte != 255. Last sequence has only literals and ends at the end of data.
+
+static const size_t MIN_MATCH  = 4;
+static const size_t MAX_OFFSET = 65535;
+static const size_t HASH_BITS  = 12;
+// Input byte decodes to at most 255 output bytes (extra length byte), larger original_size means corruption
+static const size_t MAX_EXPANSION = 255;
+
+static uint32_t read32(const uint8_t *p) {
+	uint32_t v = 0;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static size_t hash4(uint32_t v) { return (v * 2654435761U) >> (32 - HASH_BITS); }
+
+static void write_length(common::BinaryArray *result, size_t len) {
+	for (; len >= 255; len -= 255)
+		result->push_back(255);
+	result->push_back(static_cast<uint8_t>(len));
+}
+
+static void write_literals(common::BinaryArray *result, const uint8_t *literals, size_t count, size_t match_nibble) {
+	result->push_back(static_cast<uint8_t>((std::min<size_t>(count, 15) << 4) | match_nibble));
+	if (count >= 15)
+		write_length(result, count - 15);
+	result->insert(result->end(), literals, literals + count);
+}
+
+void common::lz_compress(const uint8_t *data, size_t size, BinaryArray *result) {
+	std::vector<size_t> table(size_t(1) << HASH_BITS, 0);  // position + 1, 0 means empty
+	size_t anchor = 0;
+	size_t pos    = 0;
+	while (pos + MIN_MATCH <= size) {
+		const uint32_t seq     = read32(data + pos);
+		size_t &slot           = table[hash4(seq)];
+		const size_t candidate = slot;
+		slot                   = pos + 1;
+		if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET || read32(data + candidate - 1) != seq) {
+			pos += 1 + ((pos - anchor) >> 6);  // skip faster over incompressible data (keys, signatures)
+			continue;
+		}
+		const size_t ref = candidate - 1;
+		size_t len       = MIN_MATCH;
+		while (pos + len < size && data[ref + len] == data[pos + len])
+			len += 1;
+		const size_t match_len = len - MIN_MATCH;
+		const size_t offset    = pos - ref;
+		write_literals(result, data + anchor, pos - anchor, std::min<size_t>(match_len, 15));
+		result->push_back(static_cast<uint8_t>(offset));
+		result->push_back(static_cast<uint8_t>(offset >> 8));
+		if (match_len >= 15)
+			write_length(result, match_len - 15);
+		pos += len;
+		anchor = pos;
+	}
+	write_literals(result, data + anchor, size - anchor, 0);
+}
+
+static size_t read_length(const uint8_t *data, size_t size, size_t *pos, size_t len) {
+	if (len != 15)
+		return len;
+	while (true) {
+		if (*pos == size)
+			throw std::runtime_error("lz_decompress length out of data");
+		const uint8_t b = data[(*pos)++];
+		len += b;
+		if (b != 255)
+			return len;
+	}
+}
+
+void common::lz_decompress(const uint8_t *data, size_t size, size_t original_size, BinaryArray *result) {
+	if (original_size / MAX_EXPANSION > size)  // checked before reserve, corrupted size must not allocate
+		throw std::runtime_error("lz_decompress original size too big");
+	const size_t start = result->size();
+	result->reserve(start + original_size);
+	size_t pos = 0;
+	while (true) {
+		if (pos == size)
+			throw std::runtime_error("lz_decompress token out of data");
+		const uint8_t token     = data[pos++];
+		const size_t lit_length = read_length(data, size, &pos, token >> 4);
+		if (lit_length > size - pos || lit_length > original_size - (result->size() - start))
+			throw std::runtime_error("lz_decompress literals too long");
+		result->insert(result->end(), data + pos, data + pos + lit_length);
+		pos += lit_length;
+		if (pos == size)
+			break;
+		if (size - pos < 2)
+			throw std::runtime_error("lz_decompress offset out of data");
+		const size_t offset    = data[pos] | (size_t(data[pos + 1]) << 8);
+		pos                    = pos + 2;
+		const size_t match_len = read_length(data, size, &pos, token & 15) + MIN_MATCH;
+		if (offset == 0 || offset > result->size() - start)
+			throw std::runtime_error("lz_decompress offset too far");
+		if (match_len > original_size - (result->size() - start))
+			throw std::runtime_error("lz_decompress match too long");
+		const size_t from = result->size() - offset;
+		result->resize(result->size() + match_len);
+		uint8_t *dst       = result->data() + result->size() - match_len;
+		const uint8_t *src = result->data() + from;
+		if (offset >= match_len)
+			memcpy(dst, src, match_len);
+		else
+			for (size_t i = 0; i != match_len; ++i)  // overlapping match repeats pattern
+				dst[i] = src[i];
+	}
+	if (result->size() - start != original_size)
+		throw std::runtime_error("lz_decompress size mismatch");
+}
@@ -0,0 +1,18 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "BinaryArray.hpp"
+
+namespace common {
+
+// Byte-aligned LZ77 similar to LZ4 block format, used for DB records
+// Decompression is single forward pass with back references only, so fast and streaming friendly
+void lz_compress(const uint8_t *data, size_t size, BinaryArray *result);  // appends to result
+// throws std::runtime_error on corrupted data, never writes more than original_size bytes
+void lz_decompress(const uint8_t *data, size_t size, size_t original_size, BinaryArray *result);  // appends to result
+
+}  // namespace common
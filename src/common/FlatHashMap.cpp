@@ -0,0 +1,13 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "FlatHashMap.hpp"
+#include <random>
+
+uint64_t common::flat_hash_seed() {
+	static const uint64_t seed = [] {
+		std::random_device rd;
+		return (uint64_t(rd()) << 32) ^ rd();
+	}();
+	return seed;
+}
@@ -0,0 +1,214 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace common {
+
+uint64_t flat_hash_seed();  // random per process, so peers cannot grind keys into one probe chain
+
+// Keys are crypto values (hashes, key images, public keys), so first 8 bytes are already random
+template<typename K>
+struct KeyBytesHash {
+	static_assert(std::is_trivially_copyable<K>::value && sizeof(K) >= 8, "KeyBytesHash needs raw key bytes");
+	uint64_t operator()(const K &key) const {
+		uint64_t result = 0;
+		memcpy(&result, &key, sizeof(result));
+		return result;
+	}
+};
+
+// Open addressing with linear probing in a single array, no per-element allocations and no tombstones
+// (erase shifts following elements back). Subset of std::unordered_map interface.
+// Unlike std::unordered_map, any insert or erase invalidates iterators and references,
+// and V must be default constructible (empty slots hold V{}).
+template<typename K, typename V, typename H = KeyBytesHash<K>>
+class FlatHashMap {
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<K, V> value_type;  // key must not be modified through iterator
+
+	template<typename M, typename VT>
+	class Iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef VT value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef VT *pointer;
+		typedef VT &reference;
+
+		Iterator() = default;
+		Iterator(M *map, size_t pos) : map(map), pos(pos) { skip_empty(); }
+		template<typename M2, typename VT2>
+		Iterator(const Iterator<M2, VT2> &other) : map(other.map), pos(other.pos) {}
+		VT &operator*() const { return map->m_slots[pos]; }
+		VT *operator->() const { return &map->m_slots[pos]; }
+		Iterator &operator++() {
+			++pos;
+			skip_empty();
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator result = *this;
+			++*this;
+			return result;
+		}
+		template<typename M2, typename VT2>
+		bool operator==(const Iterator<M2, VT2> &other) const {
+			return pos == other.pos;
+		}
+		template<typename M2, typename VT2>
+		bool operator!=(const Iterator<M2, VT2> &other) const {
+			return pos != other.pos;
+		}
+
+	private:
+		template<typename, typename, typename>
+		friend class FlatHashMap;
+		template<typename, typename>
+		friend class Iterator;
+		M *map     = nullptr;
+		size_t pos = 0;
+		void skip_empty() {
+			while (pos < map->m_used.size() && !map->m_used[pos])
+				++pos;
+		}
+	};
+	typedef Iterator<FlatHashMap, value_type> iterator;
+	typedef Iterator<const FlatHashMap, const value_type> const_iterator;
+
+	FlatHashMap() : m_seed(flat_hash_seed()) {}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, m_used.size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, m_used.size()); }
+
+	iterator find(const K &key) {
+		const size_t pos = find_pos(key);
+		return iterator(this, pos == NOT_FOUND ? m_used.size() : pos);
+	}
+	const_iterator find(const K &key) const {
+		const size_t pos = find_pos(key);
+		return const_iterator(this, pos == NOT_FOUND ? m_used.size() : pos);
+	}
+	size_t count(const K &key) const { return find_pos(key) == NOT_FOUND ? 0 : 1; }
+	V &at(const K &key) {
+		const size_t pos = find_pos(key);
+		if (pos == NOT_FOUND)
+			throw std::out_of_range("FlatHashMap key not found");
+		return m_slots[pos].second;
+	}
+	const V &at(const K &key) const { return const_cast<FlatHashMap *>(this)->at(key); }
+	V &operator[](const K &key) { return emplace(key, V{}).first->second; }
+
+	std::pair<iterator, bool> insert(const value_type &value) { return emplace(value.first, value.second); }
+	std::pair<iterator, bool> insert(value_type &&value) {
+		return emplace(value.first, std::move(value.second));
+	}
+	template<typename VV>
+	std::pair<iterator, bool> emplace(const K &key, VV &&value) {
+		size_t pos = find_pos(key);
+		if (pos != NOT_FOUND)
+			return std::make_pair(iterator(this, pos), false);
+		if ((m_size + 1) * MAX_LOAD_DEN > m_used.size() * MAX_LOAD_NUM)
+			rehash(m_used.empty() ? MIN_CAPACITY : 2 * m_used.size());
+		pos = home_pos(key);
+		while (m_used[pos])
+			pos = (pos + 1) & m_mask;
+		m_slots[pos] = value_type(key, std::forward<VV>(value));
+		m_used[pos]  = 1;
+		++m_size;
+		return std::make_pair(iterator(this, pos), true);
+	}
+	size_t erase(const K &key) {
+		const size_t pos = find_pos(key);
+		if (pos == NOT_FOUND)
+			return 0;
+		erase_pos(pos);
+		return 1;
+	}
+	void clear() {
+		m_slots.clear();
+		m_used.clear();
+		m_size = 0;
+		m_mask = 0;
+	}
+	void reserve(size_t count) {
+		size_t capacity = MIN_CAPACITY;
+		while (capacity * MAX_LOAD_NUM < count * MAX_LOAD_DEN)
+			capacity *= 2;
+		if (capacity > m_used.size())
+			rehash(capacity);
+	}
+
+private:
+	static const size_t NOT_FOUND    = size_t(-1);
+	static const size_t MIN_CAPACITY = 16;
+	static const size_t MAX_LOAD_NUM = 7;  // linear probing stays short up to 7/8 with random keys
+	static const size_t MAX_LOAD_DEN = 8;
+
+	std::vector<value_type> m_slots;
+	std::vector<uint8_t> m_used;
+	size_t m_size = 0;
+	size_t m_mask = 0;
+	uint64_t m_seed;
+	H m_hash;
+
+	size_t home_pos(const K &key) const {
+		// Multiplication moves key bits into high bits, seed makes positions unpredictable
+		const uint64_t h = (m_hash(key) ^ m_seed) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<size_t>(h >> 32) & m_mask;
+	}
+	size_t find_pos(const K &key) const {
+		if (m_size == 0)
+			return NOT_FOUND;
+		for (size_t pos = home_pos(key); m_used[pos]; pos = (pos + 1) & m_mask)
+			if (m_slots[pos].first == key)
+				return pos;
+		return NOT_FOUND;
+	}
+	void erase_pos(size_t hole) {
+		// Move back elements whose probe chain passes through hole, so lookups never see a gap
+		for (size_t pos = (hole + 1) & m_mask; m_used[pos]; pos = (pos + 1) & m_mask) {
+			const size_t home = home_pos(m_slots[pos].first);
+			if (((pos - home) & m_mask) >= ((pos - hole) & m_mask)) {
+				m_slots[hole] = std::move(m_slots[pos]);
+				hole          = pos;
+			}
+		}
+		m_slots[hole] = value_type{};
+		m_used[hole]  = 0;
+		--m_size;
+	}
+	void rehash(size_t capacity) {
+		std::vector<value_type> old_slots(capacity);
+		std::vector<uint8_t> old_used(capacity);
+		old_slots.swap(m_slots);
+		old_used.swap(m_used);
+		m_mask = capacity - 1;
+		for (size_t i = 0; i != old_used.size(); ++i) {
+			if (!old_used[i])
+				continue;
+			size_t pos = home_pos(old_slots[i].first);
+			while (m_used[pos])
+				pos = (pos + 1) & m_mask;
+			m_slots[pos] = std::move(old_slots[i]);
+			m_used[pos]  = 1;
+		}
+	}
+};
+
+}  // namespace common
@@ -0,0 +1,168 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "Metrics.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace common { namespace metrics {
+
+static uint64_t double_to_bits(double value) {
+	uint64_t result = 0;
+	static_assert(sizeof(result) == sizeof(value), "");
+	std::memcpy(&result, &value, sizeof(value));
+	return result;
+}
+
+static double bits_to_double(uint64_t bits) {
+	double result = 0;
+	std::memcpy(&result, &bits, sizeof(bits));
+	return result;
+}
+
+Gauge::Gauge() : m_value_bits(double_to_bits(0)) {}
+
+void Gauge::set(double value) { m_value_bits.store(double_to_bits(value), std::memory_order_relaxed); }
+
+void Gauge::add(double value) {
+	uint64_t old_bits = m_value_bits.load(std::memory_order_relaxed);
+	while (!m_value_bits.compare_exchange_weak(
+	    old_bits, double_to_bits(bits_to_double(old_bits) + value), std::memory_order_relaxed)) {
+	}
+}
+
+double Gauge::get() const { return bits_to_double(m_value_bits.load(std::memory_order_relaxed)); }
+
+Histogram::Histogram(const std::vector<double> &upper_bounds)
+    : m_upper_bounds(upper_bounds)
+    , m_buckets(new std::atomic<uint64_t>[upper_bounds.size() + 1])
+    , m_sum_bits(double_to_bits(0)) {
+	if (!std::is_sorted(m_upper_bounds.begin(), m_upper_bounds.end()))
+		throw std::logic_error("Histogram upper bounds must be sorted");
+	for (size_t i = 0; i != m_upper_bounds.size() + 1; ++i)
+		m_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void Histogram::observe(double value) {
+	const size_t bucket =
+	    std::lower_bound(m_upper_bounds.begin(), m_upper_bounds.end(), value) - m_upper_bounds.begin();
+	m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	uint64_t old_bits = m_sum_bits.load(std::memory_order_relaxed);
+	while (!m_sum_bits.compare_exchange_weak(
+	    old_bits, double_to_bits(bits_to_double(old_bits) + value), std::memory_order_relaxed)) {
+	}
+}
+
+std::vector<uint64_t> Histogram::get_cumulative_counts() const {
+	std::vector<uint64_t> result(m_upper_bounds.size() + 1);
+	uint64_t total = 0;
+	for (size_t i = 0; i != result.size(); ++i) {
+		total += m_buckets[i].load(std::memory_order_relaxed);
+		result[i] = total;
+	}
+	return result;
+}
+
+double Histogram::get_sum() const { return bits_to_double(m_sum_bits.load(std::memory_order_relaxed)); }
+
+const std::vector<double> &default_latency_buckets() {
+	static const std::vector<double> buckets{
+	    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30};
+	return buckets;
+}
+
+std::string label(const std::string &name, const std::string &value) {
+	std::string result = name + "=\"";
+	for (char c : value) {
+		if (c == '\\' || c == '"')
+			result += '\\';
+		if (c == '\n') {
+			result += "\\n";
+			continue;
+		}
+		result += c;
+	}
+	return result + "\"";
+}
+
+Registry::Family &Registry::get_family(const std::string &name, const std::string &help, Type type) {
+	auto &family = m_families[CRYPTONOTE_NAME "_" + name];
+	if (family.help.empty()) {
+		family.type = type;
+		family.help = help;
+	} else if (family.type != type)
+		throw std::logic_error("Metric " + name + " registered with different types");
+	return family;
+}
+
+Counter &Registry::counter(const std::string &name, const std::string &help, const std::string &labels) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto &ptr = get_family(name, help, COUNTER).counters[labels];
+	if (!ptr)
+		ptr = std::make_unique<Counter>();
+	return *ptr;
+}
+
+Gauge &Registry::gauge(const std::string &name, const std::string &help, const std::string &labels) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto &ptr = get_family(name, help, GAUGE).gauges[labels];
+	if (!ptr)
+		ptr = std::make_unique<Gauge>();
+	return *ptr;
+}
+
+Histogram &Registry::histogram(const std::string &name, const std::string &help, const std::string &labels,
+    const std::vector<double> &upper_bounds) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto &ptr = get_family(name, help, HISTOGRAM).histograms[labels];
+	if (!ptr)
+		ptr = std::make_unique<Histogram>(upper_bounds);
+	return *ptr;
+}
+
+static std::string with_labels(const std::string &name, const std::string &labels, const std::string &extra = "") {
+	if (labels.empty() && extra.empty())
+		return name;
+	return name + "{" + labels + (labels.empty() || extra.empty() ? "" : ",") + extra + "}";
+}
+
+std::string Registry::to_prometheus_text() const {
+	std::stringstream str;
+	str << std::setprecision(17);
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (const auto &fit : m_families) {
+		const std::string &name = fit.first;
+		const Family &family    = fit.second;
+		static const char *const type_names[] = {"counter", "gauge", "histogram"};
+		str << "# HELP " << name << " " << family.help << "\n";
+		str << "# TYPE " << name << " " << type_names[family.type] << "\n";
+		for (const auto &cit : family.counters)
+			str << with_labels(name, cit.first) << " " << cit.second->get() << "\n";
+		for (const auto &git : family.gauges)
+			str << with_labels(name, git.first) << " " << git.second->get() << "\n";
+		for (const auto &hit : family.histograms) {
+			const Histogram &histogram = *hit.second;
+			const auto counts          = histogram.get_cumulative_counts();
+			const auto &bounds         = histogram.get_upper_bounds();
+			for (size_t i = 0; i != bounds.size(); ++i) {
+				std::stringstream le;
+				le << bounds[i];
+				str << with_labels(name + "_bucket", hit.first, label("le", le.str())) << " " << counts[i] << "\n";
+			}
+			str << with_labels(name + "_bucket", hit.first, label("le", "+Inf")) << " " << counts.back() << "\n";
+			str << with_labels(name + "_sum", hit.first) << " " << histogram.get_sum() << "\n";
+			str << with_labels(name + "_count", hit.first) << " " << counts.back() << "\n";
+		}
+	}
+	return str.str();
+}
+
+Registry &registry() {
+	static Registry instance;
+	return instance;
+}
+
+}}  // namespace common::metrics
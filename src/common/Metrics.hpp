@@ -0,0 +1,102 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Nocopy.hpp"
+
+namespace common { namespace metrics {
+
+// Updating metrics is lock-free and can be done from any thread. Looking up metric in registry
+// takes short lock, so hot paths keep references (metrics are never deleted)
+
+class Counter : private Nocopy {
+public:
+	void inc(uint64_t value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+	uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> m_value{0};
+};
+
+class Gauge : private Nocopy {
+public:
+	Gauge();
+	void set(double value);
+	void add(double value);
+	double get() const;
+
+private:
+	std::atomic<uint64_t> m_value_bits;  // double stored as bits, add uses CAS
+};
+
+class Histogram : private Nocopy {
+public:
+	explicit Histogram(const std::vector<double> &upper_bounds);  // sorted, +Inf bucket is implicit
+	void observe(double value);
+	void observe_since(std::chrono::steady_clock::time_point start) {
+		observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	const std::vector<double> &get_upper_bounds() const { return m_upper_bounds; }
+	std::vector<uint64_t> get_cumulative_counts() const;  // last is count of all observations
+	double get_sum() const;
+
+private:
+	const std::vector<double> m_upper_bounds;
+	std::unique_ptr<std::atomic<uint64_t>[]> m_buckets;  // non-cumulative, upper_bounds.size() + 1
+	std::atomic<uint64_t> m_sum_bits{0};                  // double stored as bits, updated with CAS
+};
+
+// Observes time from construction to destruction
+class ScopeTimer : private Nocopy {
+public:
+	explicit ScopeTimer(Histogram &histogram) : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+	~ScopeTimer() { m_histogram.observe_since(m_start); }
+
+private:
+	Histogram &m_histogram;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+// 100us..30s, good enough for most latencies we are interested in
+const std::vector<double> &default_latency_buckets();
+
+// Returns label="value" with value escaped, for labels argument below. Join several labels with ','
+std::string label(const std::string &name, const std::string &value);
+
+class Registry : private Nocopy {
+public:
+	// Same name and labels return the same metric, name must always be used with the same type.
+	// Names are automatically prefixed with CRYPTONOTE_NAME "_"
+	Counter &counter(const std::string &name, const std::string &help, const std::string &labels = std::string());
+	Gauge &gauge(const std::string &name, const std::string &help, const std::string &labels = std::string());
+	Histogram &histogram(const std::string &name, const std::string &help, const std::string &labels = std::string(),
+	    const std::vector<double> &upper_bounds = default_latency_buckets());
+
+	std::string to_prometheus_text() const;  // text exposition format 0.0.4
+
+private:
+	enum Type { COUNTER, GAUGE, HISTOGRAM };
+	struct Family {
+		Type type = COUNTER;
+		std::string help;
+		std::map<std::string, std::unique_ptr<Counter>> counters;  // by labels
+		std::map<std::string, std::unique_ptr<Gauge>> gauges;
+		std::map<std::string, std::unique_ptr<Histogram>> histograms;
+	};
+	mutable std::mutex m_mutex;
+	std::map<std::string, Family> m_families;
+	Family &get_family(const std::string &name, const std::string &help, Type type);
+};
+
+Registry &registry();  // Single for the process, walletd with built-in daemon exports both
+
+}}  // namespace common::metrics
@@ -0,0 +1,72 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "RollingBloomFilter.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace common;
+
+static uint64_t mix64(uint64_t h) {  // finalizer of MurmurHash3
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+RollingBloomFilter::RollingBloomFilter(size_t generation_size, uint64_t seed)
+    : m_generation_size(std::max<size_t>(1, generation_size))
+    , m_seed(seed)
+    , m_current((m_generation_size * BITS_PER_KEY + 63) / 64)
+    , m_previous(m_current.size()) {}
+
+uint64_t RollingBloomFilter::key_hash(const uint8_t *key, size_t size) const {
+	uint64_t h = m_seed ^ size;
+	for (; size >= 8; key += 8, size -= 8) {
+		uint64_t word = 0;
+		memcpy(&word, key, 8);
+		h = mix64(h ^ word);
+	}
+	uint64_t tail = 0;
+	memcpy(&tail, key, size);
+	return mix64(h ^ tail);
+}
+
+void RollingBloomFilter::insert(const uint8_t *key, size_t size) {
+	if (m_current_count == m_generation_size) {
+		m_previous.swap(m_current);
+		std::fill(m_current.begin(), m_current.end(), 0);
+		m_current_count = 0;
+	}
+	const uint64_t h1    = key_hash(key, size);
+	const uint64_t h2    = mix64(h1) | 1;  // double hashing, Kirsch-Mitzenmacher
+	const uint64_t nbits = m_current.size() * 64;
+	for (size_t i = 0; i != HASH_COUNT; ++i) {
+		const uint64_t bit = (h1 + i * h2) % nbits;
+		m_current[bit / 64] |= uint64_t(1) << (bit % 64);
+	}
+	m_current_count += 1;
+}
+
+bool RollingBloomFilter::contains(const uint8_t *key, size_t size) const {
+	const uint64_t h1    = key_hash(key, size);
+	const uint64_t h2    = mix64(h1) | 1;
+	const uint64_t nbits = m_current.size() * 64;
+	bool in_current      = true;
+	bool in_previous     = true;
+	for (size_t i = 0; i != HASH_COUNT && (in_current || in_previous); ++i) {
+		const uint64_t bit  = (h1 + i * h2) % nbits;
+		const uint64_t mask = uint64_t(1) << (bit % 64);
+		in_current          = in_current && (m_current[bit / 64] & mask) != 0;
+		in_previous         = in_previous && (m_previous[bit / 64] & mask) != 0;
+	}
+	return in_current || in_previous;
+}
+
+void RollingBloomFilter::clear() {
+	std::fill(m_current.begin(), m_current.end(), 0);
+	std::fill(m_previous.begin(), m_previous.end(), 0);
+	m_current_count = 0;
+}
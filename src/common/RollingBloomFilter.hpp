@@ -0,0 +1,34 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace common {
+
+// Remembers approximately last 2 * generation_size keys in fixed memory. Keys are expected to be
+// crypto hashes, so we do not hash them much. contains() has rare false positives, never false negatives
+// for keys inserted during current or previous generation
+class RollingBloomFilter {
+public:
+	explicit RollingBloomFilter(size_t generation_size, uint64_t seed);  // seed is random per filter
+	void insert(const uint8_t *key, size_t size);
+	bool contains(const uint8_t *key, size_t size) const;
+	void clear();
+
+private:
+	static const size_t HASH_COUNT    = 8;
+	static const size_t BITS_PER_KEY  = 16;  // false positive rate about 0.1% with 2 generations
+	const size_t m_generation_size;
+	const uint64_t m_seed;
+	std::vector<uint64_t> m_current;
+	std::vector<uint64_t> m_previous;
+	size_t m_current_count = 0;
+
+	uint64_t key_hash(const uint8_t *key, size_t size) const;
+};
+
+}  // namespace common
@@ -0,0 +1,132 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+// Included from hash-keccak-batch.c once per lane count, no include guard by design.
+// Define KECCAK_BATCH_LANES, KECCAK_BATCH_TARGET and KECCAK_BATCH_SUFFIX before including.
+
+#define KECCAK_BATCH_CAT2(a, b) a##b
+#define KECCAK_BATCH_CAT(a, b) KECCAK_BATCH_CAT2(a, b)
+#define KECCAK_BATCH_VEC KECCAK_BATCH_CAT(keccak_lanes, KECCAK_BATCH_SUFFIX)
+#define KECCAK_BATCH_PERMUTE KECCAK_BATCH_CAT(keccak_lanes_permute, KECCAK_BATCH_SUFFIX)
+#define KECCAK_BATCH_HASH KECCAK_BATCH_CAT(keccak_lanes_hash, KECCAK_BATCH_SUFFIX)
+
+// Lane i of each vector belongs to message in lane i
+typedef uint64_t KECCAK_BATCH_VEC __attribute__((vector_size(8 * KECCAK_BATCH_LANES)));
+
+#define KECCAK_BATCH_ROL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static void KECCAK_BATCH_PERMUTE(KECCAK_BATCH_VEC *st) KECCAK_BATCH_TARGET;
+static void KECCAK_BATCH_PERMUTE(KECCAK_BATCH_VEC *st) {
+	KECCAK_BATCH_VEC a[25], b[25], c[5], d[5];
+	memcpy(a, st, sizeof(a));
+	for (int round = 0; round < 24; ++round) {
+		// Theta
+		for (int x = 0; x < 5; ++x)
+			c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+		for (int x = 0; x < 5; ++x)
+			d[x] = c[(x + 4) % 5] ^ KECCAK_BATCH_ROL(c[(x + 1) % 5], 1);
+		for (int i = 0; i < 25; ++i)
+			a[i] ^= d[i % 5];
+		// Rho and Pi, b[y + 5 * ((2 * x + 3 * y) % 5)] = rol(a[x + 5 * y], r[x][y])
+		b[0]  = a[0];
+		b[10] = KECCAK_BATCH_ROL(a[1], 1);
+		b[20] = KECCAK_BATCH_ROL(a[2], 62);
+		b[5]  = KECCAK_BATCH_ROL(a[3], 28);
+		b[15] = KECCAK_BATCH_ROL(a[4], 27);
+		b[16] = KECCAK_BATCH_ROL(a[5], 36);
+		b[1]  = KECCAK_BATCH_ROL(a[6], 44);
+		b[11] = KECCAK_BATCH_ROL(a[7], 6);
+		b[21] = KECCAK_BATCH_ROL(a[8], 55);
+		b[6]  = KECCAK_BATCH_ROL(a[9], 20);
+		b[7]  = KECCAK_BATCH_ROL(a[10], 3);
+		b[17] = KECCAK_BATCH_ROL(a[11], 10);
+		b[2]  = KECCAK_BATCH_ROL(a[12], 43);
+		b[12] = KECCAK_BATCH_ROL(a[13], 25);
+		b[22] = KECCAK_BATCH_ROL(a[14], 39);
+		b[23] = KECCAK_BATCH_ROL(a[15], 41);
+		b[8]  = KECCAK_BATCH_ROL(a[16], 45);
+		b[18] = KECCAK_BATCH_ROL(a[17], 15);
+		b[3]  = KECCAK_BATCH_ROL(a[18], 21);
+		b[13] = KECCAK_BATCH_ROL(a[19], 8);
+		b[14] = KECCAK_BATCH_ROL(a[20], 18);
+		b[24] = KECCAK_BATCH_ROL(a[21], 2);
+		b[9]  = KECCAK_BATCH_ROL(a[22], 61);
+		b[19] = KECCAK_BATCH_ROL(a[23], 56);
+		b[4]  = KECCAK_BATCH_ROL(a[24], 14);
+		// Chi
+		for (int y = 0; y < 25; y += 5)
+			for (int x = 0; x < 5; ++x)
+				a[y + x] = b[y + x] ^ (~b[y + (x + 1) % 5] & b[y + (x + 2) % 5]);
+		// Iota
+		a[0] ^= keccakf_rndc[round];
+	}
+	memcpy(st, a, sizeof(a));
+}
+
+// Each step absorbs one rate-sized block (or padded tail) into every busy lane, then permutes all lanes.
+// When message in a lane is finished, lane is cleared and takes next message, so lanes stay busy
+// even if message lengths differ. Idle lanes at the end of batch permute garbage, which is harmless.
+static void KECCAK_BATCH_HASH(
+    const void *const data[], const size_t lengths[], size_t count, struct cryptoHash hashes[]) KECCAK_BATCH_TARGET;
+static void KECCAK_BATCH_HASH(
+    const void *const data[], const size_t lengths[], size_t count, struct cryptoHash hashes[]) {
+	KECCAK_BATCH_VEC st[25];
+	KECCAK_BATCH_VEC block[HASH_DATA_AREA / 8];
+	size_t message[KECCAK_BATCH_LANES];  // count means idle lane
+	size_t position[KECCAK_BATCH_LANES];  // > length after padded tail is absorbed
+	size_t next = 0, busy = 0;
+	memset(st, 0, sizeof(st));
+	for (size_t lane = 0; lane != KECCAK_BATCH_LANES; ++lane) {
+		message[lane]  = next < count ? next++ : count;
+		position[lane] = 0;
+		busy += message[lane] != count;
+	}
+	while (busy != 0) {
+		memset(block, 0, sizeof(block));
+		for (size_t lane = 0; lane != KECCAK_BATCH_LANES; ++lane) {
+			if (message[lane] == count)
+				continue;
+			const uint8_t *in   = (const uint8_t *)data[message[lane]] + position[lane];
+			const size_t remain = lengths[message[lane]] - position[lane];
+			uint8_t tail[HASH_DATA_AREA];
+			if (remain >= HASH_DATA_AREA) {
+				position[lane] += HASH_DATA_AREA;
+			} else {
+				memcpy(tail, in, remain);
+				memset(tail + remain, 0, HASH_DATA_AREA - remain);
+				tail[remain] ^= 1;  // cn_fast_hash delimiter
+				tail[HASH_DATA_AREA - 1] |= 0x80;
+				in = tail;
+				position[lane] = lengths[message[lane]] + 1;
+			}
+			for (size_t w = 0; w != HASH_DATA_AREA / 8; ++w) {
+				uint64_t word;
+				memcpy(&word, in + 8 * w, 8);  // little-endian only, see dispatch
+				block[w][lane] = word;
+			}
+		}
+		for (size_t w = 0; w != HASH_DATA_AREA / 8; ++w)
+			st[w] ^= block[w];
+		KECCAK_BATCH_PERMUTE(st);
+		for (size_t lane = 0; lane != KECCAK_BATCH_LANES; ++lane) {
+			if (message[lane] == count || position[lane] <= lengths[message[lane]])
+				continue;
+			for (size_t w = 0; w != sizeof(struct cryptoHash) / 8; ++w) {
+				const uint64_t word = st[w][lane];
+				memcpy(hashes[message[lane]].data + 8 * w, &word, 8);
+			}
+			for (size_t w = 0; w != 25; ++w)
+				st[w][lane] = 0;
+			position[lane] = 0;
+			message[lane]  = next < count ? next++ : count;
+			busy -= message[lane] == count;
+		}
+	}
+}
+
+#undef KECCAK_BATCH_ROL
+#undef KECCAK_BATCH_HASH
+#undef KECCAK_BATCH_PERMUTE
+#undef KECCAK_BATCH_VEC
+#undef KECCAK_BATCH_CAT
+#undef KECCAK_BATCH_CAT2
@@ -0,0 +1,101 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hash.h"
+
+// Multi-buffer cn_fast_hash. Independent messages are interleaved in vector lanes, 4 with AVX2, 8 with AVX-512.
+// Lane code uses GCC vector extensions with target attributes, so it compiles without -mavx2 and is selected
+// at runtime. Other compilers and CPUs use ordinary crypto_cn_fast_hash.
+
+#if defined(__GNUC__) && defined(__x86_64__)
+
+#include <cpuid.h>
+
+extern const uint64_t keccakf_rndc[24];  // Forward declaration from keccak.c
+
+#define KECCAK_BATCH_LANES 4
+#define KECCAK_BATCH_TARGET __attribute__((target("avx2")))
+#define KECCAK_BATCH_SUFFIX _avx2
+#include "hash-keccak-batch-impl.h"
+#undef KECCAK_BATCH_SUFFIX
+#undef KECCAK_BATCH_TARGET
+#undef KECCAK_BATCH_LANES
+
+#define KECCAK_BATCH_LANES 8
+#define KECCAK_BATCH_TARGET __attribute__((target("avx512f")))
+#define KECCAK_BATCH_SUFFIX _avx512
+#include "hash-keccak-batch-impl.h"
+#undef KECCAK_BATCH_SUFFIX
+#undef KECCAK_BATCH_TARGET
+#undef KECCAK_BATCH_LANES
+
+enum { KECCAK_BATCH_SCALAR = 1, KECCAK_BATCH_AVX2 = 4, KECCAK_BATCH_AVX512 = 8 };
+
+static uint64_t keccak_batch_xgetbv(void) {
+	uint32_t eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+}
+
+static int keccak_batch_detect_lanes(void) {
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & bit_OSXSAVE) == 0)
+		return KECCAK_BATCH_SCALAR;
+	if (__get_cpuid_max(0, NULL) < 7)
+		return KECCAK_BATCH_SCALAR;
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	const uint64_t xcr0 = keccak_batch_xgetbv();
+	// OS must save YMM (bits 1, 2) and for AVX-512 also opmask and ZMM (bits 5, 6, 7)
+	if ((ebx & bit_AVX512F) != 0 && (xcr0 & 0xe6) == 0xe6)
+		return KECCAK_BATCH_AVX512;
+	if ((ebx & bit_AVX2) != 0 && (xcr0 & 0x06) == 0x06)
+		return KECCAK_BATCH_AVX2;
+	return KECCAK_BATCH_SCALAR;
+}
+
+static int keccak_batch_lanes(void) {
+	static int lanes = 0;  // Races are benign, all threads will detect the same value
+	if (lanes == 0)
+		lanes = keccak_batch_detect_lanes();
+	return lanes;
+}
+
+#else
+
+static int keccak_batch_lanes(void) { return 1; }
+
+#endif
+
+void crypto_cn_fast_hash_batch(
+    const void *const data[], const size_t lengths[], size_t count, struct cryptoHash hashes[]) {
+	const int lanes = keccak_batch_lanes();
+	if (count < 2 || lanes == 1) {
+		for (size_t i = 0; i != count; ++i)
+			crypto_cn_fast_hash(data[i], lengths[i], hashes + i);
+		return;
+	}
+#if defined(__GNUC__) && defined(__x86_64__)
+	if (lanes == KECCAK_BATCH_AVX512)
+		keccak_lanes_hash_avx512(data, lengths, count, hashes);
+	else
+		keccak_lanes_hash_avx2(data, lengths, count, hashes);
+#endif
+}
+
+void crypto_cn_fast_hash_pairs(const struct cryptoHash pairs[], size_t count, struct cryptoHash hashes[]) {
+	enum { CHUNK = 64 };
+	const void *data[CHUNK];
+	size_t lengths[CHUNK];
+	for (size_t start = 0; start < count; start += CHUNK) {
+		const size_t chunk = count - start < CHUNK ? count - start : CHUNK;
+		for (size_t i = 0; i != chunk; ++i) {
+			data[i]    = pairs + 2 * (start + i);
+			lengths[i] = 2 * sizeof(struct cryptoHash);
+		}
+		crypto_cn_fast_hash_batch(data, lengths, chunk, hashes + start);
+	}
+}
@@ -19,6 +19,18 @@
 
 namespace crypto {
 
+std::vector<Hash> cn_fast_hash_batch(const std::vector<std::vector<uint8_t>> &datas) {
+	std::vector<const void *> data(datas.size());
+	std::vector<size_t> lengths(datas.size());
+	for (size_t i = 0; i != datas.size(); ++i) {
+		data[i]    = datas[i].data();
+		lengths[i] = datas[i].size();
+	}
+	std::vector<Hash> result(datas.size());
+	crypto_cn_fast_hash_batch(data.data(), lengths.data(), datas.size(), result.data());
+	return result;
+}
+
 enum { MAP_SIZE = SLOW_HASH_CONTEXT_SIZE + ((-SLOW_HASH_CONTEXT_SIZE) & 0xfff) };
 
 #if defined(_WIN32)
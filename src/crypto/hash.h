@@ -20,6 +20,11 @@ struct cryptoHash {
 enum { HASH_DATA_AREA = 136, SLOW_HASH_CONTEXT_SIZE = 2097552 };
 
 void crypto_cn_fast_hash(const void *data, size_t length, struct cryptoHash *hash);
+// Same results as crypto_cn_fast_hash for each message, but independent messages are hashed in parallel lanes
+void crypto_cn_fast_hash_batch(
+    const void *const data[], const size_t lengths[], size_t count, struct cryptoHash hashes[]);
+// hashes[i] = cn_fast_hash(pairs[2 * i], pairs[2 * i + 1]), hashes can be the same as pairs (tree levels in place)
+void crypto_cn_fast_hash_pairs(const struct cryptoHash pairs[], size_t count, struct cryptoHash hashes[]);
 // void crypto_cn_fast_hash64(const void *data, size_t length, unsigned char hash[64]);
 
 void crypto_cn_slow_hash(void *scratchpad, const void *data, size_t length, struct cryptoHash *hash);
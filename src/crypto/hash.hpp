@@ -23,6 +23,8 @@ inline Hash cn_fast_hash(const std::vector<uint8_t> &data) {
 	crypto_cn_fast_hash(data.data(), data.size(), &h);
 	return h;
 }
+// Hashes independent messages in parallel lanes where CPU allows, results are the same as cn_fast_hash
+std::vector<Hash> cn_fast_hash_batch(const std::vector<std::vector<uint8_t>> &datas);
 
 class CryptoNightContext {
 public:
@@ -22,21 +22,17 @@ void crypto_tree_hash(const struct cryptoHash hashes[], size_t count, struct cry
 		crypto_cn_fast_hash(hashes, 2 * sizeof(struct cryptoHash), root_hash);
 		return;
 	}
-	size_t i, j;
 	size_t cnt = 1;
 	while (cnt * 2 < count)
 		cnt *= 2;
+	const size_t first      = 2 * cnt - count;
 	struct cryptoHash *ints = (struct cryptoHash *)malloc(cnt * sizeof(struct cryptoHash));
-	memcpy(ints, hashes, (2 * cnt - count) * sizeof(struct cryptoHash));
-	for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-		crypto_cn_fast_hash(hashes + i, 2 * sizeof(struct cryptoHash), ints + j);
-	}
-	assert(i == count);
+	memcpy(ints, hashes, first * sizeof(struct cryptoHash));
+	// Whole level is hashed at once, so multi-lane keccak can be used
+	crypto_cn_fast_hash_pairs(hashes + first, cnt - first, ints + first);
 	while (cnt > 2) {
 		cnt /= 2;
-		for (j = 0; j < cnt; ++j) {
-			crypto_cn_fast_hash(ints + 2 * j, 2 * sizeof(struct cryptoHash), ints + j);
-		}
+		crypto_cn_fast_hash_pairs(ints, cnt, ints);
 	}
 	crypto_cn_fast_hash(ints, 2 * sizeof(struct cryptoHash), root_hash);
 	free(ints);
@@ -10,10 +10,13 @@
 
 using namespace http;
 
+static const size_t MAX_STREAM_QUEUED_SIZE = 1024 * 1024;
+
 Client::Client()
     : buffer(8192)
     , receiving_body(false)
     , waiting_write_response(false)
+    , streaming(false)
     , sock([this](bool, bool) { advance_state(true); }, std::bind(&Client::on_disconnect, this))
     , keep_alive(true) {}
 
@@ -25,6 +28,10 @@ void Client::disconnect() {
 void Client::clear() {
 	waiting_write_response = false;
 	keep_alive             = true;
+	streaming              = false;
+	stream_chunks.clear();
+	stream_chunk_position = 0;
+	stream_queued_size    = 0;
 	parser.reset();
 	buffer.clear();
 	responses.clear();
@@ -60,7 +67,17 @@ void Client::write() {
 			break;
 		responses.pop_front();
 	}
-	if (!waiting_write_response && responses.empty() && !keep_alive) {
+	while (responses.empty() && !stream_chunks.empty()) {
+		const std::string &chunk = *stream_chunks.front();
+		stream_chunk_position += sock.write_some(
+		    chunk.data() + stream_chunk_position, chunk.size() - stream_chunk_position);
+		if (stream_chunk_position != chunk.size())
+			break;
+		stream_queued_size -= chunk.size();
+		stream_chunks.pop_front();
+		stream_chunk_position = 0;
+	}
+	if (!waiting_write_response && !streaming && responses.empty() && !keep_alive) {
 		sock.shutdown_both();
 		keep_alive = true;
 	}
@@ -78,8 +95,39 @@ void Client::write(ResponseBody &&response) {
 	write();
 }
 
+void Client::start_stream(ResponseHeader &&header) {
+	invariant(waiting_write_response, "Client unexpected start_stream");
+	invariant(header.http_version_major == 1 && header.http_version_minor >= 1, "Chunked encoding requires HTTP/1.1");
+	waiting_write_response = false;
+	streaming              = true;
+	header.content_length  = std::numeric_limits<size_t>::max();
+	header.headers.push_back({"Transfer-Encoding", "chunked"});
+	std::string str = header.to_string();
+	responses.emplace_back();
+	responses.back().write(str.data(), str.size());
+	write();
+}
+
+bool Client::stream(const std::shared_ptr<const std::string> &chunk) {
+	invariant(streaming, "Client unexpected stream");
+	if (stream_queued_size > MAX_STREAM_QUEUED_SIZE) {
+		disconnect();  // Slow reader would make us buffer forever
+		return false;
+	}
+	stream_queued_size += chunk->size();
+	stream_chunks.push_back(chunk);
+	write();
+	return true;
+}
+
 void Client::advance_state(bool called_from_runloop) {
 	write();
+	if (streaming) {  // Nothing more is processed, but we keep reading, so socket notices disconnect
+		uint8_t discard[256];
+		while (sock.read_some(discard, sizeof(discard)) != 0) {
+		}
+		return;
+	}
 	if (!responses.empty() || waiting_write_response) {
 		return;  // do not process new request until previous response completely sent. TODO - process.short responses
 	}
@@ -21,6 +21,8 @@ public:
 
 private:
 	void write(ResponseBody &&response);
+	void start_stream(ResponseHeader &&header);
+	bool stream(const std::shared_ptr<const std::string> &chunk);
 	void disconnect();
 	bool read_next(RequestBody &request);
 
@@ -37,6 +39,12 @@ private:
 
 	bool waiting_write_response;
 
+	// Streaming response never finishes, chunks are shared between all clients receiving the same stream
+	bool streaming;
+	std::deque<std::shared_ptr<const std::string>> stream_chunks;
+	size_t stream_chunk_position = 0;
+	size_t stream_queued_size    = 0;
+
 	void advance_state(bool called_from_runloop);
 	void write();
 	void on_disconnect();
@@ -46,12 +46,17 @@ void make_generic_error_reponse(common::JsonValue &resp, const std::string &what
 }
 
 void Request::parse(const std::string &request_body, bool allow_empty_id) {
-	stripped_req = common::JsonValue{};
+	common::JsonValue request_value;
 	try {
-		stripped_req = common::JsonValue::from_string(request_body);
+		request_value = common::JsonValue::from_string(request_body);
 	} catch (const std::exception &ex) {
 		throw Error(PARSE_ERROR, common::what(ex));
 	}
+	parse(std::move(request_value), allow_empty_id);
+}
+
+void Request::parse(common::JsonValue &&request_value, bool allow_empty_id) {
+	stripped_req = std::move(request_value);
 	if (!stripped_req.is_object())
 		throw Error(INVALID_REQUEST, "Request is not a json object");
 	if (!stripped_req.contains("jsonrpc"))
@@ -144,6 +149,59 @@ std::string create_error_response_body(const Error &error, const common::JsonVal
 	ps_req.set("error", s.move_value());
 	return ps_req.to_string();
 }
+bool is_batch(const std::string &request_body) {
+	for (char c : request_body)
+		if (!isspace(static_cast<unsigned char>(c)))
+			return c == '[';
+	return false;
+}
+
+static common::JsonValue get_batch_element_id(const common::JsonValue &element) {
+	if (element.is_object() && element.contains("id")) {
+		const auto &p = element("id");
+		if (p.is_string() || p.is_number())
+			return p;
+	}
+	return common::JsonValue(nullptr);
+}
+
+std::string process_batch(const std::string &request_body, const BatchHandler &handler) {
+	common::JsonValue batch;
+	try {
+		batch = common::JsonValue::from_string(request_body);
+	} catch (const std::exception &ex) {
+		throw Error(PARSE_ERROR, common::what(ex));
+	}
+	if (!batch.is_array() || batch.size() == 0)  // Json RPC spec 6
+		throw Error(INVALID_REQUEST, "Batch must be non-empty array");
+	if (batch.size() > MAX_BATCH_SIZE)
+		throw Error(INVALID_REQUEST, "Batch too big, max size is " + common::to_string(MAX_BATCH_SIZE));
+	const auto deadline = std::chrono::steady_clock::now() + BATCH_TIME_BUDGET;
+	std::string body    = "[";
+	for (auto &element : batch.get_array()) {
+		if (body.size() != 1)
+			body += ",";
+		common::JsonValue jid = get_batch_element_id(element);
+		bool nas              = false;
+		const size_t rollback = body.size();
+		try {
+			if (std::chrono::steady_clock::now() > deadline)
+				throw Error(BATCH_TIMEOUT, "Batch time budget exceeded before this request started");
+			Request req(std::move(element));
+			nas = req.get_numbers_as_strings();
+			handler(std::move(req), body);
+		} catch (const Error &err) {
+			body.resize(rollback);
+			body += create_error_response_body(err, jid, nas);
+		} catch (const std::exception &ex) {
+			body.resize(rollback);
+			body += create_error_response_body(Error(INTERNAL_ERROR, common::what(ex)), jid, nas);
+		}
+	}
+	body += "]";
+	return body;
+}
+
 std::string create_binary_response_error_body(const Error &error, const common::JsonValue &jid) {
 	//	static_assert(std::is_base_of<json_rpc::Error, ErrorType>::value, "ErrorType must be an json_rpc::Error
 	// descendant");
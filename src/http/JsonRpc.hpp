@@ -4,6 +4,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <chrono>
 #include <functional>
 
 #include "common/Invariant.hpp"
@@ -19,6 +20,11 @@ const int INVALID_REQUEST  = -32600;
 const int METHOD_NOT_FOUND = -32601;
 const int INVALID_PARAMS   = -32602;
 const int INTERNAL_ERROR   = -32603;
+const int BATCH_TIMEOUT    = -32000;  // from implementation-defined server error range
+
+const size_t MAX_BATCH_SIZE = 1000;
+// Batch elements not started within budget are answered with BATCH_TIMEOUT, so one batch cannot stall server
+const std::chrono::steady_clock::duration BATCH_TIME_BUDGET = std::chrono::seconds(5);
 
 class Error : public std::exception {
 public:
@@ -44,6 +50,9 @@ public:
     explicit Request(const std::string &request_body, bool allow_empty_id = false) {
 		parse(request_body, allow_empty_id);
 	}
+	explicit Request(common::JsonValue &&request_value, bool allow_empty_id = false) {
+		parse(std::move(request_value), allow_empty_id);
+	}
 	template<typename T>
 	void load_params(T &v) const {
 		static_assert(!std::is_pointer<T>::value, "Cannot be called with pointer");
@@ -63,6 +72,7 @@ public:
 
 private:
 	void parse(const std::string &request_body, bool allow_empty_id);
+	void parse(common::JsonValue &&request_value, bool allow_empty_id);
 
 	common::JsonValue stripped_req;  // req with params and excess fields
 	bool numbers_as_strings = false;
@@ -117,13 +127,21 @@ http::RequestBody create_request(const std::string &uri, const std::string &meth
 	return http_request;
 }
 
+// Appends, so batch responses are serialized into one shared buffer
 template<typename ResultType>
-std::string create_response_body(const ResultType &result, const common::JsonValue &jid, bool numbers_as_strings) {
-	std::string result_body = prepare_result_prefix(jid);
+void append_response_body(
+    std::string &result_body, const ResultType &result, const common::JsonValue &jid, bool numbers_as_strings) {
+	result_body += prepare_result_prefix(jid);
 	seria::JsonOutputStreamText s(result_body);
 	s.set_numbers_as_strings(numbers_as_strings);
 	ser(const_cast<ResultType &>(result), s);
 	result_body += "}";
+}
+
+template<typename ResultType>
+std::string create_response_body(const ResultType &result, const common::JsonValue &jid, bool numbers_as_strings) {
+	std::string result_body;
+	append_response_body(result_body, result, jid, numbers_as_strings);
 	return result_body;
 	//	common::JsonValue ps_req(common::JsonValue::OBJECT);
 	//	ps_req.set("jsonrpc", std::string("2.0"));
@@ -137,8 +155,25 @@ std::string create_response_body(const ResultType &result, const Request &req) {
 }
 
 std::string create_error_response_body(const Error &error, const common::JsonValue &jid, bool numbers_as_strings);
+
+// Request without id, server sends them to subscribers
+template<typename ParamsType>
+std::string create_notification_body(const std::string &method, const ParamsType &params) {
+	std::string body = "{\"jsonrpc\":\"2.0\",\"method\":" + common::JsonValue(method).to_string() + ",\"params\":";
+	seria::JsonOutputStreamText s(body);
+	ser(const_cast<ParamsType &>(params), s);
+	body += "}";
+	return body;
+}
 std::string create_error_response_body(const Error &error, const Request &req);
 
+// Batch is a json array of requests, answered with array of responses in one http round trip
+bool is_batch(const std::string &request_body);
+// handler appends response of single request to body or throws, body is rolled back on throw.
+// Throws Error if whole batch is malformed, caller replies with single error as for ordinary request
+typedef std::function<void(Request &&req, std::string &body)> BatchHandler;
+std::string process_batch(const std::string &request_body, const BatchHandler &handler);
+
 template<typename ResultType>  //, typename ErrorType
 bool parse_response(const std::string &body, ResultType &result, Error &error, OptionalJsonValue *jid = nullptr) {
 	json_rpc::Response json_resp(body);
@@ -163,7 +198,7 @@ bool invoke_method(
 	bool success          = handler(agent, std::move(http_request), std::move(json_req), std::move(params), result);
 
 	if (success)
-		raw_response = create_response_body(result, jid, nas);
+		append_response_body(raw_response, result, jid, nas);
 	return success;
 }
 
@@ -7,204 +7,108 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "RequestParser.hpp"
-#include <cctype>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include "common/Math.hpp"
 
 using namespace http;
 
-RequestParser::RequestParser() : state_(method_start) {}
+RequestParser::RequestParser() : state_(request_line) {}
 
 void RequestParser::reset() {
-	state_  = method_start;
-	lowcase = Header{};
+	state_ = request_line;
+	lines.reset();
 }
 
-RequestParser::state RequestParser::consume(RequestHeader &req, char input) {
+const char *RequestParser::parse(RequestHeader &req, const char *begin, const char *end) {
+	while (state_ != good && state_ != bad) {
+		common::StringView line;
+		auto result = lines.next(begin, end, line);
+		if (result == LineReader::incomplete)
+			break;
+		state_ = result == LineReader::bad ? bad : consume(req, line);
+	}
+	return begin;
+}
+
+RequestParser::state RequestParser::consume(RequestHeader &req, common::StringView line) {
 	switch (state_) {
-	case method_start:
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-			return bad;
-		req.method.reserve(7);
-		req.method.push_back(input);
-		return method;
-	case method:
-		if (input == ' ')
-			return uri;
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-			return bad;
-		req.method.push_back(input);
-		return method;
-	case uri:
-		if (input == ' ')
-			return http_version_h;
-		if (is_ctl(input))
-			return bad;
-		req.uri.push_back(input);
-		return uri;
-	case http_version_h:
-		if (input == 'H')
-			return http_version_t_1;
-		return bad;
-	case http_version_t_1:
-		if (input == 'T')
-			return http_version_t_2;
-		return bad;
-	case http_version_t_2:
-		if (input == 'T')
-			return http_version_p;
-		return bad;
-	case http_version_p:
-		if (input == 'P')
-			return http_version_slash;
-		return bad;
-	case http_version_slash:
-		if (input == '/')
-			return http_version_major_start;
-		return bad;
-	case http_version_major_start:
-		if (is_digit(input)) {
-			req.http_version_major = req.http_version_major * 10 + input - '0';
-			return http_version_major;
-		}
-		return bad;
-	case http_version_major:
-		if (input == '.')
-			return http_version_minor_start;
-		if (is_digit(input)) {
-			req.http_version_major = req.http_version_major * 10 + input - '0';
-			return http_version_major;
-		}
-		return bad;
-	case http_version_minor_start:
-		if (is_digit(input)) {
-			req.http_version_minor = req.http_version_minor * 10 + input - '0';
-			return http_version_minor;
-		}
-		return bad;
-	case http_version_minor:
-		if (input == '\r') {
-			req.keep_alive = req.http_version_major == 1 && req.http_version_minor == 1;
-			return expecting_newline_1;
-		}
-		if (is_digit(input)) {
-			req.http_version_minor = req.http_version_minor * 10 + input - '0';
-			return http_version_minor;
-		}
-		return bad;
-	case expecting_newline_1:
-		if (input == '\n') {
-			req.headers.reserve(20);
-			return header_line_start;
-		}
-		return bad;
-	case header_line_start:
-		if (input == '\r')
-			return expecting_newline_3;
-		if (!req.headers.empty() && (input == ' ' || input == '\t'))
-			return header_lws;
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-			return bad;
-		req.headers.push_back(Header{});
-		req.headers.back().name.reserve(16);
-		req.headers.back().value.reserve(16);
-		req.headers.back().name.push_back(input);
-		lowcase.name.push_back(std::tolower(input));
-		return header_name;
-	case header_lws:
-		if (input == '\r')
-			return expecting_newline_2;
-		if (input == ' ' || input == '\t')
-			return header_lws;
-		if (is_ctl(input))
-			return bad;
-		req.headers.back().value.push_back(input);
-		lowcase.value.push_back(std::tolower(input));
-		return header_value;
-	case header_name:
-		if (input == ':')
-			return space_before_header_value;
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
+	case request_line:
+		if (!process_request_line(req, line))
 			return bad;
-		req.headers.back().name.push_back(input);
-		lowcase.name.push_back(std::tolower(input));
-		return header_name;
-	case space_before_header_value:
-		if (input == ' ')
-			return header_value;
-		return bad;
-	case header_value:
-		if (input == '\r') {
-			if (!process_ready_header(req))
-				return bad;
-			lowcase = Header{};
-			return expecting_newline_2;
-		}
-		if (is_ctl(input))
-			return bad;
-		req.headers.back().value.push_back(input);
-		lowcase.value.push_back(std::tolower(input));
-		return header_value;
-	case expecting_newline_2:
-		if (input == '\n')
-			return header_line_start;
-		return bad;
-	case expecting_newline_3:
-		if (input == '\n')
+		return first_header_line;
+	case first_header_line:
+	case header_line: {
+		if (line.empty())
 			return good;
-		return bad;
+		if (line[0] == ' ' || line[0] == '\t')  // obsolete line folding, we ignore continuations
+			return state_ == header_line ? header_line : bad;
+		common::StringView name, value;
+		if (!split_header_line(line, name, value) || !process_ready_header(req, name, value))
+			return bad;
+		return header_line;
+	}
 	default:
 		return bad;
 	}
 }
 
-bool RequestParser::process_ready_header(RequestHeader &req) {
-	if (lowcase.name == "content-length") {
+bool RequestParser::process_request_line(RequestHeader &req, common::StringView line) {
+	const char *method_end = static_cast<const char *>(std::memchr(line.data(), ' ', line.size()));
+	if (!method_end)
+		return false;
+	common::StringView method(line.data(), method_end - line.data());
+	if (!is_token(method))
+		return false;
+	const char *uri_begin = method_end + 1;
+	const char *uri_end = static_cast<const char *>(std::memchr(uri_begin, ' ', line.end() - uri_begin));
+	if (!uri_end || std::find(uri_begin, uri_end, '\t') != uri_end)
+		return false;
+	if (!parse_http_version(
+	        common::StringView(uri_end + 1, line.end() - uri_end - 1), req.http_version_major, req.http_version_minor))
+		return false;
+	req.method.assign(method.data(), method.size());
+	req.uri.assign(uri_begin, uri_end);
+	req.keep_alive = req.http_version_major == 1 && req.http_version_minor == 1;
+	return true;
+}
+
+bool RequestParser::process_ready_header(RequestHeader &req, common::StringView name, common::StringView value) {
+	if (equals_lowcase(name, "content-length")) {
 		try {
-			req.content_length = common::integer_cast<decltype(req.content_length)>(lowcase.value);  // std::stoull
-			req.headers.pop_back();
+			req.content_length =
+			    common::integer_cast<decltype(req.content_length)>(std::string(value));  // std::stoull
 			return true;
 		} catch (const std::exception &) {
 		}
 		return false;
 	}
-	if (lowcase.name == "host") {
-		req.host = lowcase.value;
-		req.headers.pop_back();
+	if (equals_lowcase(name, "host")) {
+		req.host = to_lowcase(value);
 		return true;
 	}
-	if (lowcase.name == "origin") {
-		req.origin = lowcase.value;
-		req.headers.pop_back();
+	if (equals_lowcase(name, "origin")) {
+		req.origin = to_lowcase(value);
 		return true;
 	}
-	if (lowcase.name == "connection") {
-		if (lowcase.value == "close") {
+	if (equals_lowcase(name, "connection")) {
+		if (equals_lowcase(value, "close")) {
 			req.keep_alive = false;
-			req.headers.pop_back();
 			return true;
 		}
-		if (lowcase.value == "keep-alive") {
+		if (equals_lowcase(value, "keep-alive")) {
 			req.keep_alive = true;
-			req.headers.pop_back();
 			return true;
 		}
 		return false;
 	}
-	if (lowcase.name == "authorization") {
-		if (lowcase.value.find("basic") != 0)
+	if (equals_lowcase(name, "authorization")) {
+		if (!starts_with_lowcase(value, "basic"))
 			return true;
-		size_t start             = 5;  // "basic".size()
-		const std::string &value = req.headers.back().value;
+		size_t start = 5;  // "basic".size(), value is already stripped at the end
 		while (start < value.size() && (value[start] == ' ' || value[start] == '\t'))
 			start += 1;
-		//		if( start == value.size())
-		//			return false; // token required after basic
-		size_t finish = value.size();
-		while (finish > start && (value[finish - 1] == ' ' || value[finish - 1] == '\t'))
-			finish -= 1;
-		req.basic_authorization = value.substr(start, finish - start);
-		req.headers.pop_back();
+		req.basic_authorization.assign(value.data() + start, value.size() - start);
 		return true;
 	}
 	return true;
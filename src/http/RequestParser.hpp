@@ -14,50 +14,30 @@ namespace http {
 
 struct RequestHeader;
 
+// Parses header line by line with SIMD search for line ends. Only headers used by Server
+// (Content-Length, Connection, Host, Origin, Authorization: Basic) are copied into RequestHeader,
+// other headers are validated and skipped without allocations
 class RequestParser {
-	enum state {
-		method_start,
-		method,
-		uri,
-		http_version_h,
-		http_version_t_1,
-		http_version_t_2,
-		http_version_p,
-		http_version_slash,
-		http_version_major_start,
-		http_version_major,
-		http_version_minor_start,
-		http_version_minor,
-		expecting_newline_1,
-		header_line_start,
-		header_lws,
-		header_name,
-		space_before_header_value,
-		header_value,
-		expecting_newline_2,
-		expecting_newline_3,
-		good,
-		bad
-	} state_;
+	enum state { request_line, first_header_line, header_line, good, bad } state_;
 
 public:
 	RequestParser();
 
 	void reset();
 
-	template<typename InputIterator>
-	InputIterator parse(RequestHeader &req, InputIterator begin, InputIterator end) {
-		while (begin != end && state_ != good && state_ != bad)
-			state_ = consume(req, *begin++);
-		return begin;
+	const char *parse(RequestHeader &req, const char *begin, const char *end);
+	const unsigned char *parse(RequestHeader &req, const unsigned char *begin, const unsigned char *end) {
+		auto b = reinterpret_cast<const char *>(begin);
+		return begin + (parse(req, b, reinterpret_cast<const char *>(end)) - b);
 	}
 	bool is_good() const { return state_ == good; }
 	bool is_bad() const { return state_ == bad; }
 
 private:
-	bool process_ready_header(RequestHeader &req);
-	Header lowcase;
-	state consume(RequestHeader &req, char input);
+	LineReader lines;
+	state consume(RequestHeader &req, common::StringView line);
+	static bool process_request_line(RequestHeader &req, common::StringView line);
+	static bool process_ready_header(RequestHeader &req, common::StringView name, common::StringView value);
 };
 
 }  // namespace http
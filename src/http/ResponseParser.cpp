@@ -7,184 +7,83 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "ResponseParser.hpp"
-#include <sstream>
+#include <algorithm>
 #include "common/Math.hpp"
 
 using namespace http;
 
-ResponseParser::ResponseParser() : state_(http_version_h) {}
+ResponseParser::ResponseParser() : state_(status_line) {}
 
 void ResponseParser::reset() {
-	state_  = http_version_h;
-	lowcase = Header{};
+	state_ = status_line;
+	lines.reset();
 }
 
-ResponseParser::state ResponseParser::consume(ResponseHeader &req, char input) {
+const char *ResponseParser::parse(ResponseHeader &req, const char *begin, const char *end) {
+	while (state_ != good && state_ != bad) {
+		common::StringView line;
+		auto result = lines.next(begin, end, line);
+		if (result == LineReader::incomplete)
+			break;
+		state_ = result == LineReader::bad ? bad : consume(req, line);
+	}
+	return begin;
+}
+
+ResponseParser::state ResponseParser::consume(ResponseHeader &req, common::StringView line) {
 	switch (state_) {
-	case http_version_h:
-		if (input == 'H')
-			return http_version_t_1;
-		return bad;
-	case http_version_t_1:
-		if (input == 'T')
-			return http_version_t_2;
-		return bad;
-	case http_version_t_2:
-		if (input == 'T')
-			return http_version_p;
-		return bad;
-	case http_version_p:
-		if (input == 'P')
-			return http_version_slash;
-		return bad;
-	case http_version_slash:
-		if (input == '/')
-			return http_version_major_start;
-		return bad;
-	case http_version_major_start:
-		if (is_digit(input)) {
-			req.http_version_major = req.http_version_major * 10 + input - '0';
-			return http_version_major;
-		}
-		return bad;
-	case http_version_major:
-		if (input == '.')
-			return http_version_minor_start;
-		if (is_digit(input)) {
-			req.http_version_major = req.http_version_major * 10 + input - '0';
-			return http_version_major;
-		}
-		return bad;
-	case http_version_minor_start:
-		if (is_digit(input)) {
-			req.http_version_minor = req.http_version_minor * 10 + input - '0';
-			return http_version_minor;
-		}
-		return bad;
-	case http_version_minor:
-		if (input == ' ') {
-			req.keep_alive = req.http_version_major == 1 && req.http_version_minor == 1;
-			return status_code_1;
-		}
-		if (is_digit(input)) {
-			req.http_version_minor = req.http_version_minor * 10 + input - '0';
-			return http_version_minor;
-		}
-		return bad;
-	case status_code_1:
-		if (is_digit(input)) {
-			req.status = req.status * 10 + input - '0';
-			return status_code_2;
-		}
-		return bad;
-	case status_code_2:
-		if (is_digit(input)) {
-			req.status = req.status * 10 + input - '0';
-			return status_code_3;
-		}
-		return bad;
-	case status_code_3:
-		if (is_digit(input)) {
-			req.status = req.status * 10 + input - '0';
-			return status_code_space;
-		}
-		return bad;
-	case status_code_space:
-		if (input == ' ')
-			return status_text;
-		return bad;
-	case status_text:
-		if (input == '\r')
-			return expecting_newline_1;
-		if (is_ctl(input))
-			return bad;
-		req.status_text.push_back(input);
-		return status_text;
-	case expecting_newline_1:
-		if (input == '\n') {
-			req.headers.reserve(20);
-			return header_line_start;
-		}
-		return bad;
-	case header_line_start:
-		if (input == '\r')
-			return expecting_newline_3;
-		if (!req.headers.empty() && (input == ' ' || input == '\t'))
-			return header_lws;
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-			return bad;
-		req.headers.push_back(Header{});
-		req.headers.back().name.reserve(16);
-		req.headers.back().value.reserve(16);
-		req.headers.back().name.push_back(input);
-		lowcase.name.push_back(tolower(input));
-		return header_name;
-	case header_lws:
-		if (input == '\r')
-			return expecting_newline_2;
-		if (input == ' ' || input == '\t')
-			return header_lws;
-		if (is_ctl(input))
-			return bad;
-		req.headers.back().value.push_back(input);
-		lowcase.value.push_back(tolower(input));
-		return header_value;
-	case header_name:
-		if (input == ':')
-			return space_before_header_value;
-		if (!is_char(input) || is_ctl(input) || is_tspecial(input))
-			return bad;
-		req.headers.back().name.push_back(input);
-		lowcase.name.push_back(tolower(input));
-		return header_name;
-	case space_before_header_value:
-		if (input == ' ')
-			return header_value;
-		return bad;
-	case header_value:
-		if (input == '\r') {
-			if (!process_ready_header(req))
-				return bad;
-			lowcase = Header{};
-			return expecting_newline_2;
-		}
-		if (is_ctl(input))
+	case status_line:
+		if (!process_status_line(req, line))
 			return bad;
-		req.headers.back().value.push_back(input);
-		lowcase.value.push_back(tolower(input));
-		return header_value;
-	case expecting_newline_2:
-		if (input == '\n')
-			return header_line_start;
-		return bad;
-	case expecting_newline_3:
-		if (input == '\n')
+		return first_header_line;
+	case first_header_line:
+	case header_line: {
+		if (line.empty())
 			return good;
-		return bad;
+		if (line[0] == ' ' || line[0] == '\t')  // obsolete line folding, we ignore continuations
+			return state_ == header_line ? header_line : bad;
+		common::StringView name, value;
+		if (!split_header_line(line, name, value) || !process_ready_header(req, name, value))
+			return bad;
+		return header_line;
+	}
 	default:
 		return bad;
 	}
 }
 
-bool ResponseParser::process_ready_header(ResponseHeader &req) {
-	if (lowcase.name == "content-length") {
+bool ResponseParser::process_status_line(ResponseHeader &req, common::StringView line) {
+	// "HTTP/1.1 200 OK"
+	const char *version_end = std::find(line.begin(), line.end(), ' ');
+	if (version_end == line.end() || !parse_http_version(common::StringView(line.data(), version_end - line.data()),
+	                                     req.http_version_major, req.http_version_minor))
+		return false;
+	const char *pos = version_end + 1;
+	if (line.end() - pos < 4 || !is_digit(pos[0]) || !is_digit(pos[1]) || !is_digit(pos[2]) || pos[3] != ' ')
+		return false;
+	req.status = (pos[0] - '0') * 100 + (pos[1] - '0') * 10 + (pos[2] - '0');
+	req.status_text.assign(pos + 4, line.end());
+	req.keep_alive = req.http_version_major == 1 && req.http_version_minor == 1;
+	return true;
+}
+
+bool ResponseParser::process_ready_header(ResponseHeader &req, common::StringView name, common::StringView value) {
+	if (equals_lowcase(name, "content-length")) {
 		try {
-			req.content_length = common::integer_cast<decltype(req.content_length)>(lowcase.value);  // std::stoull
-			req.headers.pop_back();
+			req.content_length =
+			    common::integer_cast<decltype(req.content_length)>(std::string(value));  // std::stoull
 			return true;
 		} catch (const std::exception &) {
 		}
 		return false;
 	}
-	if (lowcase.name == "connection") {
-		if (lowcase.value == "close") {
+	if (equals_lowcase(name, "connection")) {
+		if (equals_lowcase(value, "close")) {
 			req.keep_alive = false;
-			req.headers.pop_back();
 			return true;
 		}
-		if (lowcase.value == "keep-alive") {
+		if (equals_lowcase(value, "keep-alive")) {
 			req.keep_alive = true;
-			req.headers.pop_back();
 			return true;
 		}
 		return false;
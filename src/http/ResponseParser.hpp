@@ -14,52 +14,30 @@ namespace http {
 
 struct ResponseHeader;
 
+// Parses header line by line with SIMD search for line ends. Only headers used by Agent
+// (Content-Length, Connection) are copied into ResponseHeader,
+// other headers are validated and skipped without allocations
 class ResponseParser {
-	enum state {
-		http_version_h,
-		http_version_t_1,
-		http_version_t_2,
-		http_version_p,
-		http_version_slash,
-		http_version_major_start,
-		http_version_major,
-		http_version_minor_start,
-		http_version_minor,
-		status_code_1,
-		status_code_2,
-		status_code_3,
-		status_code_space,
-		status_text,
-		expecting_newline_1,
-		header_line_start,
-		header_lws,
-		header_name,
-		space_before_header_value,
-		header_value,
-		expecting_newline_2,
-		expecting_newline_3,
-		good,
-		bad
-	} state_;
+	enum state { status_line, first_header_line, header_line, good, bad } state_;
 
 public:
 	ResponseParser();
 
 	void reset();
 
-	template<typename InputIterator>
-	InputIterator parse(ResponseHeader &req, InputIterator begin, InputIterator end) {
-		while (begin != end && state_ != good && state_ != bad)
-			state_ = consume(req, *begin++);
-		return begin;
+	const char *parse(ResponseHeader &req, const char *begin, const char *end);
+	const unsigned char *parse(ResponseHeader &req, const unsigned char *begin, const unsigned char *end) {
+		auto b = reinterpret_cast<const char *>(begin);
+		return begin + (parse(req, b, reinterpret_cast<const char *>(end)) - b);
 	}
 	bool is_good() const { return state_ == good; }
 	bool is_bad() const { return state_ == bad; }
 
 private:
-	bool process_ready_header(ResponseHeader &req);
-	Header lowcase;
-	state consume(ResponseHeader &req, char input);
+	LineReader lines;
+	state consume(ResponseHeader &req, common::StringView line);
+	static bool process_status_line(ResponseHeader &req, common::StringView line);
+	static bool process_ready_header(ResponseHeader &req, common::StringView name, common::StringView value);
 };
 
 }  // namespace http
@@ -38,6 +38,8 @@ public:
 		}
 		global_server->on_client_disconnected(this);
 	}
+	void start_stream(ResponseHeader &&) { throw std::runtime_error("Streaming responses are not supported"); }
+	bool stream(const std::shared_ptr<const std::string> &) { return false; }
 };
 
 }  // namespace http
@@ -193,6 +195,33 @@ void Server::accept_all() {
 
 void Server::write(Client *who, ResponseBody &&response) { who->write(std::move(response)); }
 
+void Server::start_stream(Client *who, ResponseHeader &&header) { who->start_stream(std::move(header)); }
+
+bool Server::stream(Client *who, const std::shared_ptr<const std::string> &chunk) { return who->stream(chunk); }
+
+std::shared_ptr<const std::string> Server::make_chunk(const std::string &data) {
+	invariant(!data.empty(), "Empty chunk would finish chunked response");
+	std::stringstream ss;
+	ss << std::hex << data.size() << "\r\n" << data << "\r\n";
+	return std::make_shared<const std::string>(ss.str());
+}
+
+void StreamGroup::start(Client *who, ResponseHeader &&header, const std::string &first_line) {
+	Server::start_stream(who, std::move(header));
+	clients.insert(who);
+	Server::stream(who, Server::make_chunk(first_line + "\n"));
+}
+
+void StreamGroup::broadcast(const std::string &line) {
+	if (clients.empty())
+		return;
+	const auto chunk = Server::make_chunk(line + "\n");
+	// We need copy because slow client is disconnected inside stream, and disconnect_handler calls erase
+	const std::vector<Client *> clients_copy{clients.begin(), clients.end()};
+	for (auto who : clients_copy)
+		Server::stream(who, chunk);
+}
+
 void Server::on_client_disconnected(Client *who) {
 	auto cit = clients.find(who);
 	if (cit == clients.end())
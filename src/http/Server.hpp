@@ -7,7 +7,9 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
+#include <string>
 
 namespace platform {
 class TCPAcceptor;
@@ -60,6 +62,13 @@ public:
 
 	static void write(Client *who, ResponseBody &&response);
 
+	// Instead of write, request handler can start chunked response which is never finished.
+	// The same chunk can be pushed to many clients without copying. Slow clients are disconnected
+	// (with disconnect_handler called) when too much data is queued, then stream returns false.
+	static void start_stream(Client *who, ResponseHeader &&header);
+	static bool stream(Client *who, const std::shared_ptr<const std::string> &chunk);
+	static std::shared_ptr<const std::string> make_chunk(const std::string &data);
+
 #ifdef __EMSCRIPTEN__
 	void global_request(std::unique_ptr<Client> &&client, RequestBody &&request);
 	void global_disconnect(Client *client);
@@ -84,4 +93,18 @@ private:
 	request_handler r_handler;
 	disconnect_handler d_handler;
 };
+
+// Clients receiving the same never finishing stream of text lines. Each line is framed as chunk once
+// and shared between all clients. Owner must call erase from its disconnect_handler
+class StreamGroup {
+public:
+	void start(Client *who, ResponseHeader &&header, const std::string &first_line);
+	void broadcast(const std::string &line);
+	void erase(Client *who) { clients.erase(who); }
+	bool empty() const { return clients.empty(); }
+	size_t size() const { return clients.size(); }
+
+private:
+	std::set<Client *> clients;
+};
 }  // namespace http
@@ -7,7 +7,13 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "types.hpp"
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define http_USE_SSE2 1
+#endif
 
 namespace http {
 
@@ -58,6 +64,142 @@ bool is_tspecial(int c) {
 
 bool is_digit(int c) { return c >= '0' && c <= '9'; }
 
+bool is_token(common::StringView str) {
+	if (str.empty())
+		return false;
+	for (char c : str)
+		if (!is_char(c) || is_ctl(c) || is_tspecial(c))
+			return false;
+	return true;
+}
+
+static char ascii_tolower(char c) { return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c; }
+
+bool equals_lowcase(common::StringView str, common::StringView lowcase) {
+	return str.size() == lowcase.size() && starts_with_lowcase(str, lowcase);
+}
+
+bool starts_with_lowcase(common::StringView str, common::StringView lowcase) {
+	if (str.size() < lowcase.size())
+		return false;
+	for (size_t i = 0; i != lowcase.size(); ++i)
+		if (ascii_tolower(str[i]) != lowcase[i])
+			return false;
+	return true;
+}
+
+std::string to_lowcase(common::StringView str) {
+	std::string result(str.data(), str.size());
+	for (auto &c : result)
+		c = ascii_tolower(c);
+	return result;
+}
+
+const char *find_ctl(const char *begin, const char *end) {
+#if http_USE_SSE2
+	// Control is c <= 31 || c == 127, bytes >= 128 are allowed as in is_ctl(char)
+	const __m128i ctl_max = _mm_set1_epi8(31);
+	const __m128i del     = _mm_set1_epi8(127);
+	const __m128i tab     = _mm_set1_epi8('\t');
+	for (; end - begin >= 16; begin += 16) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+		__m128i ctl     = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl_max), v);
+		ctl             = _mm_or_si128(ctl, _mm_cmpeq_epi8(v, del));
+		ctl             = _mm_andnot_si128(_mm_cmpeq_epi8(v, tab), ctl);
+		const int mask  = _mm_movemask_epi8(ctl);
+		if (mask != 0) {
+			int pos = 0;
+			while ((mask & (1 << pos)) == 0)
+				pos += 1;
+			return begin + pos;
+		}
+	}
+#endif
+	for (; begin != end; ++begin)
+		if (*begin != '\t' && is_ctl(*begin))
+			return begin;
+	return end;
+}
+
+void LineReader::reset() {
+	carry.clear();
+	carry_consumed = false;
+}
+
+LineReader::Result LineReader::next(const char *&begin, const char *end, common::StringView &result) {
+	if (carry_consumed)
+		reset();
+	if (begin == end)
+		return incomplete;
+	if (!carry.empty() && carry.back() == '\r') {  // CR was last char of previous chunk
+		if (*begin != '\n')
+			return bad;
+		begin += 1;
+		result         = common::StringView(carry.data(), carry.size() - 1);
+		carry_consumed = true;
+		return line;
+	}
+	const char *cr = find_ctl(begin, end);
+	if (cr != end && *cr != '\r')
+		return bad;
+	if (cr == end || cr + 1 == end) {
+		if (carry.size() + (cr - begin) > MAX_LINE_SIZE)
+			return bad;
+		carry.append(begin, end);
+		begin = end;
+		return incomplete;
+	}
+	if (cr[1] != '\n' || carry.size() + (cr - begin) > MAX_LINE_SIZE)
+		return bad;
+	if (carry.empty()) {
+		result = common::StringView(begin, cr - begin);
+	} else {
+		carry.append(begin, cr);
+		result         = common::StringView(carry);
+		carry_consumed = true;
+	}
+	begin = cr + 2;
+	return line;
+}
+
+static bool parse_version_number(const char *&pos, const char *end, int &result) {
+	if (pos == end || !is_digit(*pos))
+		return false;
+	for (; pos != end && is_digit(*pos); ++pos)
+		result = result * 10 + *pos - '0';
+	return true;
+}
+
+bool parse_http_version(common::StringView str, int &major, int &minor) {
+	if (str.size() < 5 || std::memcmp(str.data(), "HTTP/", 5) != 0)
+		return false;
+	const char *pos = str.data() + 5;
+	if (!parse_version_number(pos, str.end(), major))
+		return false;
+	if (pos == str.end() || *pos++ != '.')
+		return false;
+	return parse_version_number(pos, str.end(), minor) && pos == str.end();
+}
+
+static common::StringView strip_spaces(const char *begin, const char *end) {
+	while (begin != end && (*begin == ' ' || *begin == '\t'))
+		++begin;
+	while (end != begin && (end[-1] == ' ' || end[-1] == '\t'))
+		--end;
+	return common::StringView(begin, end - begin);
+}
+
+bool split_header_line(common::StringView line, common::StringView &name, common::StringView &value) {
+	const char *colon = static_cast<const char *>(std::memchr(line.data(), ':', line.size()));
+	if (!colon)
+		return false;
+	name = common::StringView(line.data(), colon - line.data());
+	if (!is_token(name))
+		return false;
+	value = strip_spaces(colon + 1, line.end());
+	return true;
+}
+
 std::string RequestHeader::to_string() const {
 	std::stringstream ss;
 	ss << method << " " << uri << " "
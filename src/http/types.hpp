@@ -11,6 +11,7 @@
 #include <limits>
 #include <string>
 #include <vector>
+#include "common/StringView.hpp"
 
 namespace http {
 
@@ -95,6 +96,36 @@ bool is_char(int c);
 bool is_ctl(int c);
 bool is_tspecial(int c);
 bool is_digit(int c);
+bool is_token(common::StringView str);
+// Compares ASCII case-insensitively, lowcase must be in lower case
+bool equals_lowcase(common::StringView str, common::StringView lowcase);
+bool starts_with_lowcase(common::StringView str, common::StringView lowcase);
+std::string to_lowcase(common::StringView str);
+
+// Returns pointer to the first control character except '\t', or end. Uses SIMD when available
+const char *find_ctl(const char *begin, const char *end);
+
+// Splits header stream into CRLF-terminated lines. Lines contained in a single input chunk
+// are returned as views into that chunk without copying, only lines split between chunks
+// are gathered into internal buffer. Lines never contain control characters except '\t'.
+// Lines longer than MAX_LINE_SIZE are bad, so peer never sending CRLF cannot make buffer grow forever
+class LineReader {
+public:
+	static const size_t MAX_LINE_SIZE = 8192;  // same as connection read buffer
+	enum Result { incomplete, line, bad };
+	// On line, 'result' is valid until next call to next() or reset()
+	Result next(const char *&begin, const char *end, common::StringView &result);
+	void reset();
+
+private:
+	std::string carry;
+	bool carry_consumed = false;
+};
+
+// Parses "HTTP/major.minor"
+bool parse_http_version(common::StringView str, int &major, int &minor);
+// Splits "name: value" line. Value is stripped of surrounding whitespace
+bool split_header_line(common::StringView line, common::StringView &name, common::StringView &value);
 
 std::string status_to_string(int status);
 
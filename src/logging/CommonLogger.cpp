@@ -52,7 +52,7 @@ std::string format_pattern(const std::string &pattern, const std::string &catego
 }  // namespace
 
 void CommonLogger::write(const std::string &category, Level level, std::time_t time, const std::string &body) {
-	if (level <= log_level && m_disabled_categories.count(category) == 0) {
+	if (CommonLogger::is_enabled(category, level)) {
 		std::string body2 = body;
 		if (!pattern.empty()) {
 			size_t insert_pos = 0;
@@ -66,6 +66,10 @@ void CommonLogger::write(const std::string &category, Level level, std::time_t t
 	}
 }
 
+bool CommonLogger::is_enabled(const std::string &category, Level level) const {
+	return level <= log_level && m_disabled_categories.count(category) == 0;
+}
+
 void CommonLogger::set_pattern(const std::string &pt) { pattern = pt; }
 
 void CommonLogger::enable_category(const std::string &category) { m_disabled_categories.erase(category); }
@@ -11,6 +11,7 @@ namespace logging {
 class CommonLogger : public ILogger {
 public:
 	virtual void write(const std::string &category, Level level, std::time_t time, const std::string &body) override;
+	virtual bool is_enabled(const std::string &category, Level level) const override;
 	virtual void enable_category(const std::string &category);
 	virtual void disable_category(const std::string &category);
 	virtual void set_max_level(Level level);
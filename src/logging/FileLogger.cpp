@@ -3,20 +3,75 @@
 
 #include "FileLogger.hpp"
 #include <iostream>
+#include "common/string.hpp"
 #include "common/ConsoleTools.hpp"
 #include "common/exception.hpp"
 #include "platform/PathTools.hpp"
 
 namespace logging {
 
-FileLogger::FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level)
-    : CommonLogger(level), initial_max_size(max_size), max_size(max_size), fullfilenamenoext(fullfilenamenoext) {
+static const size_t MAX_BATCH_SIZE = 256 * 1024;
+
+FileLogger::FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level, AsyncMode async_mode,
+    size_t async_queue_size)
+    : CommonLogger(level)
+    , initial_max_size(max_size)
+    , max_size(max_size)
+    , fullfilenamenoext(fullfilenamenoext)
+    , async_mode(async_mode) {
 	file_stream = std::make_unique<platform::FileStream>(this->fullfilenamenoext + ".log", platform::O_OPEN_ALWAYS);
 	file_stream->seek(0, SEEK_END);
+	if (async_mode != SYNC_WRITE) {
+		queue  = std::make_unique<RecordQueue>(async_queue_size);
+		writer = std::thread(&FileLogger::writer_thread, this);
+	}
+}
+
+FileLogger::~FileLogger() {
+	if (!writer.joinable())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		writer_stop = true;
+	}
+	writer_cv.notify_all();
+	writer.join();  // Writer flushes everything before exiting
+}
+
+void FileLogger::wake_writer() {
+	if (!writer_idle.load())
+		return;
+	std::unique_lock<std::mutex> lock(writer_mutex);  // So notification is not lost between check and wait
+	writer_cv.notify_one();
+}
+
+void FileLogger::writer_thread() {
+	std::string batch;
+	std::string record;
+	while (true) {
+		batch.clear();
+		while (batch.size() < MAX_BATCH_SIZE && queue->try_pop(record))
+			batch += record;
+		if (const size_t dr = dropped.exchange(0))
+			batch += "Log queue overflow, dropped " + common::to_string(dr) + " message(s)\n";
+		if (!batch.empty()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			write_to_file(batch);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(writer_mutex);
+		if (writer_stop && queue->empty() && dropped.load() == 0)
+			break;  // Otherwise records were pushed after our last pop, but before stop
+		if (writer_stop)
+			continue;
+		writer_idle.store(true);
+		if (queue->empty())  // Recheck after publishing idle, producer might have missed it
+			writer_cv.wait_for(lock, std::chrono::milliseconds(100));
+		writer_idle.store(false);
+	}
 }
 
 void FileLogger::do_log_string(const std::string &message) {
-	std::lock_guard<std::mutex> lock(mutex);
 	std::string real_message;
 	real_message.reserve(message.size());
 
@@ -32,6 +87,24 @@ void FileLogger::do_log_string(const std::string &message) {
 				real_message += message[char_pos];
 		}
 	}
+	if (queue) {
+		while (!queue->try_push(std::move(real_message))) {
+			if (async_mode == ASYNC_DROP) {
+				dropped += 1;
+				dropped_total += 1;
+				return;
+			}
+			wake_writer();
+			std::this_thread::yield();
+		}
+		wake_writer();
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	write_to_file(real_message);
+}
+
+void FileLogger::write_to_file(const std::string &real_message) {
 	try {
 		if (file_stream)
 			file_stream->write(real_message.data(), real_message.size());
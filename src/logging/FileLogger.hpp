@@ -3,16 +3,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include "CommonLogger.hpp"
+#include "RecordQueue.hpp"
 #include "platform/Files.hpp"
 
 namespace logging {
 
 class FileLogger : public CommonLogger {
 public:
-	explicit FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level = DEBUGGING);
+	explicit FileLogger(const std::string &fullfilenamenoext, size_t max_size, Level level = DEBUGGING,
+	    AsyncMode async_mode = SYNC_WRITE, size_t async_queue_size = 65536);
+	~FileLogger() override;
+
+	size_t get_dropped_count() const { return dropped_total; }
 
 protected:
 	virtual void do_log_string(const std::string &message) override;
@@ -24,5 +32,19 @@ private:
 	bool using_prev = false;  // atomic_replaced success, but create new file failed
 	const std::string fullfilenamenoext;
 	std::unique_ptr<platform::FileStream> file_stream;
+
+	void write_to_file(const std::string &data);  // Rotates if necessary
+
+	const AsyncMode async_mode;
+	std::unique_ptr<RecordQueue> queue;
+	std::atomic<size_t> dropped{0};  // since last report written to file
+	std::atomic<size_t> dropped_total{0};
+	std::atomic<bool> writer_idle{false};
+	bool writer_stop = false;  // protected by writer_mutex
+	std::mutex writer_mutex;
+	std::condition_variable writer_cv;
+	std::thread writer;
+	void writer_thread();
+	void wake_writer();
 };
 }  // namespace logging
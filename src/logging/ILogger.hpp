@@ -12,6 +12,10 @@ namespace logging {
 
 enum Level { FATAL = 0, ERROR = 1, WARNING = 2, INFO = 3, DEBUGGING = 4, TRACE = 5 };
 
+// ASYNC_ modes write log files on background thread, caller only formats record and puts it into queue.
+// When queue is full, ASYNC_DROP counts and drops records, ASYNC_BLOCK waits for writer
+enum AsyncMode { SYNC_WRITE, ASYNC_DROP, ASYNC_BLOCK };
+
 using namespace common::console;  // We want Color enum and members here
 
 class ILogger {
@@ -22,6 +26,8 @@ public:
 	const static std::array<std::string, 6> LEVEL_NAMES;
 
 	virtual void write(const std::string &category, Level level, std::time_t time, const std::string &body) = 0;
+	// LoggerMessage checks it before formatting, so filtered messages cost almost nothing
+	virtual bool is_enabled(const std::string &category, Level level) const { return true; }
 	virtual ~ILogger() {}
 };
 
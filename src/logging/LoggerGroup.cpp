@@ -15,10 +15,17 @@ void LoggerGroup::remove_logger(ILogger &logger) {
 }
 
 void LoggerGroup::write(const std::string &category, Level level, std::time_t time, const std::string &body) {
-	if (level <= log_level && m_disabled_categories.count(category) == 0) {
+	if (CommonLogger::is_enabled(category, level)) {
 		for (auto &logger : loggers) {
 			logger->write(category, level, time, body);
 		}
 	}
 }
+
+bool LoggerGroup::is_enabled(const std::string &category, Level level) const {
+	if (!CommonLogger::is_enabled(category, level))
+		return false;
+	return std::any_of(
+	    loggers.begin(), loggers.end(), [&](const ILogger *logger) { return logger->is_enabled(category, level); });
+}
 }  // namespace logging
@@ -15,6 +15,7 @@ public:
 	void add_logger(ILogger &logger);
 	void remove_logger(ILogger &logger);
 	virtual void write(const std::string &category, Level level, std::time_t time, const std::string &body) override;
+	virtual bool is_enabled(const std::string &category, Level level) const override;
 
 protected:
 	std::vector<ILogger *> loggers;
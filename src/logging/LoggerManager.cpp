@@ -15,17 +15,18 @@ void LoggerManager::write(const std::string &category, Level level, std::time_t
 }
 
 void LoggerManager::configure_default(
-    const std::string &log_folder, const std::string &log_prefix, const std::string &version) {
+    const std::string &log_folder, const std::string &log_prefix, const std::string &version, AsyncMode async_mode) {
 	{
 		loggers.clear();
 		LoggerGroup::loggers.clear();
 
-		std::unique_ptr<logging::CommonLogger> logger =
-		    std::make_unique<FileLogger>(log_folder + "/" + log_prefix + "verbose", 1024 * 1024, DEBUGGING);
+		std::unique_ptr<logging::CommonLogger> logger = std::make_unique<FileLogger>(
+		    log_folder + "/" + log_prefix + "verbose", 1024 * 1024, DEBUGGING, async_mode);
 		loggers.emplace_back(std::move(logger));
 		add_logger(*loggers.back());
 
-		logger = std::make_unique<FileLogger>(log_folder + "/" + log_prefix + "errors", 1024 * 1024, ERROR);
+		logger =
+		    std::make_unique<FileLogger>(log_folder + "/" + log_prefix + "errors", 1024 * 1024, ERROR, async_mode);
 		loggers.emplace_back(std::move(logger));
 		add_logger(*loggers.back());
 
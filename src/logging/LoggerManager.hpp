@@ -5,6 +5,7 @@
 
 #include <memory>
 #include <vector>
+#include "FileLogger.hpp"
 #include "LoggerGroup.hpp"
 #include "LoggerMessage.hpp"
 
@@ -13,7 +14,8 @@ namespace logging {
 class LoggerManager : public LoggerGroup {
 public:
 	LoggerManager() = default;
-	void configure_default(const std::string &log_folder, const std::string &log_prefix, const std::string &version);
+	void configure_default(const std::string &log_folder, const std::string &log_prefix, const std::string &version,
+	    AsyncMode async_mode = SYNC_WRITE);
 	// log_folder must exist
 	virtual void write(const std::string &category, Level level, std::time_t time, const std::string &body) override;
 
@@ -6,7 +6,14 @@
 namespace logging {
 
 LoggerMessage::LoggerMessage(ILogger &logger, const std::string &category, Level level)
-    : std::ostream(this), logger(logger), category(category), log_level(level), timestamp(time(nullptr)) {
+    : std::ostream(this)
+    , logger(logger)
+    , category(category)
+    , log_level(level)
+    , timestamp(time(nullptr))
+    , enabled(logger.is_enabled(category, level)) {
+	if (!enabled)
+		setstate(std::ios_base::badbit);
 	//	(*this) << std::string{ILogger::COLOR_PREFIX, static_cast<char>(ILogger::COLOR_LETTER_DEFAULT + color)};
 	//	(*this) << color;
 }
@@ -21,12 +28,19 @@ LoggerMessage::LoggerMessage(LoggerMessage &&other)
     , logger(other.logger)
     , category(other.category)
     , log_level(other.log_level)
-    , timestamp(time(nullptr)) {
+    , timestamp(time(nullptr))
+    , enabled(other.enabled) {
+	if (!enabled) {
+		setstate(std::ios_base::badbit);
+		return;
+	}
 	(*this) << other.str();
 	other.str(std::string{});
 }
 
 int LoggerMessage::sync() {
+	if (!enabled)
+		return 0;
 	logger.write(category, log_level, timestamp, str());
 	str(std::string{});
 	return 0;
@@ -22,6 +22,7 @@ private:
 	const std::string category;
 	Level log_level;
 	std::time_t timestamp;
+	bool enabled;  // If not, stream is in bad state and operator<< does no formatting
 };
 
 class LoggerRef {
@@ -0,0 +1,55 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#include "RecordQueue.hpp"
+
+namespace logging {
+
+RecordQueue::RecordQueue(size_t min_capacity) {
+	size_t capacity = 2;
+	while (capacity < min_capacity)
+		capacity *= 2;
+	cells.reset(new Cell[capacity]);
+	mask = capacity - 1;
+	for (size_t i = 0; i != capacity; ++i)
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool RecordQueue::try_push(std::string &&record) {
+	size_t pos = push_pos.load(std::memory_order_relaxed);
+	while (true) {
+		Cell &cell      = cells[pos & mask];
+		const size_t sq = cell.sequence.load(std::memory_order_acquire);
+		const auto diff = static_cast<std::ptrdiff_t>(sq) - static_cast<std::ptrdiff_t>(pos);
+		if (diff == 0) {
+			if (push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				cell.record = std::move(record);
+				cell.sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}  // pos was updated by compare_exchange_weak
+		} else if (diff < 0) {
+			return false;
+		} else {
+			pos = push_pos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool RecordQueue::try_pop(std::string &record) {
+	const size_t pos = pop_pos.load(std::memory_order_relaxed);  // single consumer
+	Cell &cell       = cells[pos & mask];
+	if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+		return false;
+	record = std::move(cell.record);
+	cell.record.clear();
+	pop_pos.store(pos + 1, std::memory_order_relaxed);
+	cell.sequence.store(pos + mask + 1, std::memory_order_release);
+	return true;
+}
+
+bool RecordQueue::empty() const {
+	const size_t pos = pop_pos.load(std::memory_order_relaxed);
+	return cells[pos & mask].sequence.load(std::memory_order_acquire) != pos + 1;
+}
+
+}  // namespace logging
@@ -0,0 +1,36 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for details.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "common/Nocopy.hpp"
+
+namespace logging {
+
+// Bounded lock-free queue of preformatted log records, many producers, single consumer.
+// Each cell carries sequence number telling whether it is ready for push or pop (D. Vyukov's design)
+class RecordQueue : private common::Nocopy {
+public:
+	explicit RecordQueue(size_t min_capacity);  // rounded up to power of 2
+
+	bool try_push(std::string &&record);  // false if queue is full
+	bool try_pop(std::string &record);    // false if queue is empty
+	bool empty() const;
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence{0};
+		std::string record;
+	};
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+	char pad0[64]{};
+	std::atomic<size_t> push_pos{0};
+	char pad1[64]{};
+	std::atomic<size_t> pop_pos{0};
+};
+
+}  // namespace logging
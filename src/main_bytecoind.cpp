@@ -7,6 +7,7 @@
 #include "Core/Node.hpp"
 #include "common/CommandLine.hpp"
 #include "common/ConsoleTools.hpp"
+#include "common/StringTools.hpp"
 #include "logging/ConsoleLogger.hpp"
 #include "logging/LoggerManager.hpp"
 #include "platform/ExclusiveLock.hpp"
@@ -37,8 +38,18 @@ Options:
   --bytecoind-authorization-private=<usr:pass>   HTTP basic authentication credentials for get_statistics and get_archive methods.
   --import-blocks=<folder-path>          Perform import of blockchain from specified folder as blocks.bin and blockindexes.bin, then exit.
   --export-blocks=<folder-path>          Perform hot export of blockchain into specified folder as blocks.bin and blockindexes.bin, then exit. This overwrites existing files.
+  --export-state-snapshot=<file-path>    Perform hot export of consensus state (outputs, key images, headers) into specified file, print its hash, then exit.
+  --import-state-snapshot=<file-path>    Before start, fill empty blockchain database from state snapshot instead of syncing blocks below last hard checkpoint.
+  --state-snapshot-hash=<hash>           Hash of state snapshot from trusted source, required for --import-state-snapshot.
   --archive                              Work as an archive node [default: off].
-  --paranoid-checks                      Perform consensus checks for blocks in checkpoints range (very slow sync))";
+  --paranoid-checks                      Perform consensus checks for blocks in checkpoints range (very slow sync).
+  --log-async=<drop|block>               Write log files on background thread, when log queue is full drop messages or wait [default: off].
+  --db-sync-lag=<seconds>                Unsafe. Do not wait for disk on blockchain commits, flush in background within this lag. OS crash or power loss can corrupt blockchain DB [default: 0].
+  --sqlite-cache-size=<MB>               Page cache of blockchain database, SQLite builds only [default: 64].
+  --sqlite-mmap-size=<MB>                Memory mapped part of blockchain database, SQLite builds only [default: 1024, 0 on 32-bit].
+  --sqlite-wal                           Use write-ahead log with synchronous=NORMAL for blockchain database, SQLite builds only. Faster commits, but power failure can lose last commits [default: off].
+  --prune-below-depth=<blocks>           Delete bodies of blocks this deep below last hard checkpoint, keeping consensus state. Pruned node cannot serve old blocks to peers and wallets [default: 0 - off].
+  --block-trace=<file-path>              Write time spent in each phase of every applied block as CSV, for sync profiling [default: off].)";
 
 int main(int argc, const char *argv[]) try {
 	common::console::UnicodeConsoleSetup console_setup;
@@ -84,6 +95,18 @@ int main(int argc, const char *argv[]) try {
 			return 1;
 		return 0;
 	}
+	if (const char *pa = cmd.get("--export-state-snapshot")) {
+		const std::string export_state_snapshot = pa;
+		if (cmd.show_errors("cannot be used with --export-state-snapshot"))
+			return api::BYTECOIND_WRONG_ARGS;
+		logging::ConsoleLogger log_console;
+		BlockChainState block_chain_read_only(log_console, config, currency, true);
+		std::cout << "Exporting state snapshot of height " << block_chain_read_only.get_tip_height() << " to "
+		          << export_state_snapshot << std::endl;
+		const Hash snapshot_hash = block_chain_read_only.export_state_snapshot(export_state_snapshot);
+		std::cout << "Finished, --state-snapshot-hash=" << snapshot_hash << std::endl;
+		return 0;
+	}
 	if (const char *pa = cmd.get("--export-sync-blocks")) {  // Experimental, for public nodes
 		const auto export_sync_blocks = platform::normalize_folder(pa);
 		if (cmd.show_errors("cannot be used with --export-sync-blocks"))
@@ -112,14 +135,31 @@ int main(int argc, const char *argv[]) try {
 	std::string import_blocks;
 	if (const char *pa = cmd.get("--import-blocks"))
 		import_blocks = platform::normalize_folder(pa);
+	std::string import_state_snapshot;
+	Hash state_snapshot_hash;
+	if (const char *pa = cmd.get("--import-state-snapshot")) {
+		import_state_snapshot = pa;
+		const char *pa2       = cmd.get("--state-snapshot-hash");
+		if (!pa2 || !common::pod_from_hex(pa2, &state_snapshot_hash)) {
+			std::cout << "--import-state-snapshot requires valid --state-snapshot-hash" << std::endl;
+			return api::BYTECOIND_WRONG_ARGS;
+		}
+	}
 	if (cmd.show_errors())
 		return api::BYTECOIND_WRONG_ARGS;
 
 	platform::ExclusiveLock coin_lock(coin_folder, CRYPTONOTE_NAME "d.lock");
 
 	logging::LoggerManager log_manager;
-	log_manager.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version());
+	log_manager.configure_default(
+	    config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version(), config.log_async_mode);
 
+	if (!import_state_snapshot.empty()) {
+		std::cout << "Importing state snapshot from " << import_state_snapshot << std::endl;
+		BlockChain::import_state_snapshot(
+		    currency, coin_folder + "/blockchain", import_state_snapshot, state_snapshot_hash);
+		std::cout << "Finished state snapshot import" << std::endl;
+	}
 	BlockChainState block_chain(log_manager, config, currency, false);
 	if (!import_blocks.empty()) {
 		LegacyBlockChainReader::import_blockchain2(import_blocks + "/" + config.block_indexes_file_name,
@@ -8,6 +8,7 @@
 #include <sstream>
 #include <thread>
 
+#include "Core/BlockTrace.hpp"
 #include "Core/hardware/HardwareWallet.hpp"
 #include "common/BIPs.hpp"
 #include "common/Base58.hpp"
@@ -17,10 +18,19 @@
 #include "platform/DB.hpp"
 #include "version.hpp"
 
+#include "../tests/common/benchmark_flat_hash_map.hpp"
+#include "../tests/common/test_compression.hpp"
+#include "../tests/common/test_rolling_bloom_filter.hpp"
 #include "../tests/crypto/benchmarks.hpp"
 #include "../tests/crypto/test_crypto.hpp"
+#include "../tests/db/benchmark_db.hpp"
 #include "../tests/hash/test_hash.hpp"
+#include "../tests/http/test_http.hpp"
+#include "../tests/http/test_http_stream.hpp"
 #include "../tests/json/test_json.hpp"
+#include "../tests/logging/test_logging.hpp"
+#include "../tests/mempool/benchmark_mempool.hpp"
+#include "../tests/p2p/test_p2p.hpp"
 
 #ifndef __EMSCRIPTEN__
 #include "../tests/blockchain/test_blockchain.hpp"
@@ -95,21 +105,40 @@ int main(int argc, const char *argv[]) {
 #endif
 
 	std::vector<std::string> crypto_function_tests{};
-	all["--crypto"]    = std::bind(test_crypto, "../tests/crypto", crypto_function_tests, "", false);
-	all["--bip32"]     = test_bip32;
-	all["--benchmark"] = std::bind(benchmark_crypto_ops, 10000, std::ref(std::cout));
-	all["--hash"]      = std::bind(test_hashes, test_folder + "/hash");
+	all["--crypto"]                  = std::bind(test_crypto, "../tests/crypto", crypto_function_tests, "", false);
+	all["--bip32"]                   = test_bip32;
+	all["--benchmark"]               = std::bind(benchmark_crypto_ops, 10000, std::ref(std::cout));
+	all["--benchmark-flat-hash-map"] = std::bind(benchmark_flat_hash_map, 1000000, std::ref(std::cout));
+	all["--compression"]             = std::bind(test_compression, 1000);
+	all["--benchmark-compression"]   = std::bind(benchmark_compression, 10000, std::ref(std::cout));
+	all["--rolling-bloom-filter"]    = std::bind(test_rolling_bloom_filter, 8192);
+	all["--hash"]                    = std::bind(test_hashes, test_folder + "/hash");
+	all["--http"]                    = test_http;
+	all["--benchmark-http"]          = std::bind(benchmark_http_parser, 1000000, std::ref(std::cout));
+	all["--p2p"]                     = test_p2p;
 #ifndef __EMSCRIPTEN__
-	all["--blockchain"]   = std::bind(test_blockchain, std::ref(cmd));
-	all["--db"]           = platform::DB::run_tests;
-	all["--json"]         = std::bind(test_json, test_folder + "/json");
-	all["--wallet"]       = std::bind(test_wallet_file, test_folder + "/wallet_file");
-	all["--wallet-state"] = std::bind(test_wallet_state, std::ref(cmd));
+	all["--blockchain"]        = std::bind(test_blockchain, std::ref(cmd));
+	all["--db"]                = platform::DB::run_tests;
+	all["--http-stream"]       = test_http_stream;
+	all["--benchmark-db"]      = std::bind(benchmark_db, 200000, std::ref(std::cout));
+	all["--benchmark-mempool"] = std::bind(benchmark_mempool, 100000, std::ref(std::cout));
+	all["--json"]              = std::bind(test_json, test_folder + "/json");
+	all["--logging"]           = std::bind(test_logging, test_folder + "/scratchpad", 20);
+	all["--wallet"]            = std::bind(test_wallet_file, test_folder + "/wallet_file");
+	all["--wallet-state"]      = std::bind(test_wallet_state, std::ref(cmd));
 #endif
 	for (const auto &t : all)
 		USAGE += "    " + t.first + "\n";
+	USAGE += "Analyzers (run instead of tests)\n"
+	         "    --block-trace-summary=<file>  Summarize " CRYPTONOTE_NAME "d --block-trace output\n";
 	if (cmd.show_help(USAGE.c_str(), cn::app_version()))
 		return 0;
+	if (const char *pa = cmd.get("--block-trace-summary")) {
+		if (cmd.show_errors("cannot be used with --block-trace-summary"))
+			return 1;
+		cn::BlockTrace::summarize(pa, std::cout);
+		return 0;
+	}
 
 	int found_on_cmd_line = 0;
 	for (const auto &t : all) {
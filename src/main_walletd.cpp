@@ -59,6 +59,7 @@ Running with selected wallet:
                                         Use https://<host:port> format to connect to a daemon via HTTPS.
   --bytecoind-authorization=<user:pass> HTTP basic authentication credentials for RPC API [default: ""].
   --net=<main|stage|test>               Configure for mainnet, stagenet, or testnet [default: main].
+  --log-async=<drop|block>              Write log files on background thread, when log queue is full drop messages or wait [default: off].
 
 Options for BIP39 mnemonic creation:
   --create-mnemonic                     Create a new random BIP39 mnemonic, then exit.
@@ -332,7 +333,8 @@ int main(int argc, const char *argv[]) try {
 		walletd_http_auth = boost::algorithm::trim_copy(std::string(pa));
 
 	logging::LoggerManager logManagerWalletNode;
-	logManagerWalletNode.configure_default(config.get_data_folder("logs"), "walletd-", cn::app_version());
+	logManagerWalletNode.configure_default(
+	    config.get_data_folder("logs"), "walletd-", cn::app_version(), config.log_async_mode);
 
 	boost::asio::io_service io;
 	platform::EventLoop run_loop(io);  // must be before Wallet creation (trezor uses io)
@@ -498,7 +500,8 @@ int main(int argc, const char *argv[]) try {
 	std::unique_ptr<Node> node;
 
 	logging::LoggerManager logManagerNode;
-	logManagerNode.configure_default(config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version());
+	logManagerNode.configure_default(
+	    config.get_data_folder("logs"), CRYPTONOTE_NAME "d-", cn::app_version(), config.log_async_mode);
 
 	auto wallet_node = std::make_unique<WalletNode>(logManagerWalletNode, wallet_state);
 
@@ -4,13 +4,19 @@
 #include "P2PProtocolBasic.hpp"
 #include <iostream>
 #include "Core/Config.hpp"
+#include "common/Metrics.hpp"
 #include "platform/Time.hpp"
 
 using namespace cn;
 
 template<typename Cmd>
 P2PProtocolBasic::LevinHandlerFunction levin_method(void (P2PProtocolBasic::*handler)(Cmd &&)) {
-	return [handler](P2PProtocolBasic *who, BinaryArray &&body) {
+	static const char *const type_names[] = {"notify", "request", "response"};
+	auto &seconds = common::metrics::registry().histogram("p2p_message_seconds", "P2P message handler duration",
+	    common::metrics::label("id", std::to_string(Cmd::ID)) + "," +
+	        common::metrics::label("type", type_names[static_cast<int>(Cmd::TYPE)]));
+	return [handler, &seconds](P2PProtocolBasic *who, BinaryArray &&body) {
+		common::metrics::ScopeTimer timer(seconds);
 		Cmd req{};
 		if (!LevinProtocol::decode(body, req)) {
 			who->disconnect("Request failed to parse");
@@ -78,11 +84,12 @@ Timestamp P2PProtocolBasic::get_local_time() const { return platform::now_unix_t
 
 BasicNodeData P2PProtocolBasic::get_my_node_data() const {
 	BasicNodeData node_data;
-	node_data.version    = P2PProtocolVersion::AMETHYST;
-	node_data.local_time = get_local_time();
-	node_data.peer_id    = my_unique_number;
-	node_data.my_port    = config.p2p_external_port;
-	node_data.network_id = config.network_id;
+	node_data.version           = P2PProtocolVersion::AMETHYST;
+	node_data.local_time        = get_local_time();
+	node_data.peer_id           = my_unique_number;
+	node_data.my_port           = config.p2p_external_port;
+	node_data.network_id        = config.network_id;
+	node_data.get_objects_batch = p2p::GetObjects::Request::MAX_BATCH_COUNT;
 	return node_data;
 }
 
@@ -105,6 +112,7 @@ void P2PProtocolBasic::on_disconnect(const std::string &ban_reason) {
 	no_outgoing_timer.cancel();
 	no_incoming_timer.cancel();
 	peer_version                            = P2PProtocolVersion::NO_HANDSHAKE_YET;
+	peer_get_objects_batch                  = 1;
 	first_message_after_handshake_processed = false;
 	set_peer_sync_data(CoreSyncData{});
 	peer_unique_number = 0;
@@ -163,7 +171,8 @@ void P2PProtocolBasic::msg_handshake(p2p::Handshake::Request &&req) {
 
 	BinaryArray raw_msg = LevinProtocol::send(msg);
 	send(std::move(raw_msg));
-	peer_version = req.node_data.version;
+	peer_version           = req.node_data.version;
+	peer_get_objects_batch = std::max<size_t>(1, req.node_data.get_objects_batch);
 	set_peer_sync_data(req.payload_data);
 	peer_unique_number = req.node_data.peer_id;
 	update_my_port(req.node_data.my_port);  // We set port to unknown on accept
@@ -181,7 +190,8 @@ void P2PProtocolBasic::msg_handshake(p2p::Handshake::Response &&req) {
 	// self-connect, incoming side replies so that outgoing side can add to ban
 	if (req.node_data.peer_id == my_unique_number)
 		return disconnect("203 self-connect");
-	peer_version = req.node_data.version;
+	peer_version           = req.node_data.version;
+	peer_get_objects_batch = std::max<size_t>(1, req.node_data.get_objects_batch);
 	if (req.local_peerlist.size() > p2p::Handshake::Response::MAX_PEER_COUNT)
 		return disconnect("204 max_local_peer_count");
 	if (req.peerlist.size() > p2p::Handshake::Response::MAX_PEER_COUNT)
@@ -19,6 +19,7 @@ private:
 	platform::Timer no_incoming_timer;
 	platform::Timer no_outgoing_timer;
 	int peer_version                             = 0;  // 0 means no handshake yet
+	size_t peer_get_objects_batch                = 1;
 	bool first_message_after_handshake_processed = false;
 	// we add node to peerdb after first non-handshake message received to avoid adding seed nodes
 	const uint64_t my_unique_number;
@@ -74,6 +75,7 @@ protected:
 public:
 	explicit P2PProtocolBasic(const Config &config, uint64_t my_unique_number, P2PClient *client);
 	int get_peer_version() const { return peer_version; }
+	size_t get_peer_get_objects_batch() const { return peer_get_objects_batch; }  // at least 1
 	uint64_t get_my_unique_number() const { return my_unique_number; }
 	void send(BinaryArray &&body) override;
 	virtual BasicNodeData get_my_node_data() const;
@@ -90,23 +90,38 @@ struct RelayTransactions {
 struct GetObjects {
 	// Request and Response have NOTIFY type for historic purposes
 	struct Request {
-		enum { ID = BC_COMMANDS_POOL_BASE + 3, TYPE = LevinProtocol::NOTIFY, MAX_SIZE = 1024 };
+		enum {
+			ID                = BC_COMMANDS_POOL_BASE + 3,
+			TYPE              = LevinProtocol::NOTIFY,
+			MAX_BATCH_COUNT   = 100,
+			MAX_RESPONSE_SIZE = 4 * 1024 * 1024,
+			MAX_SIZE          = 1024 + MAX_BATCH_COUNT * sizeof(Hash)
+		};
 		std::vector<Hash> txs;
 		std::vector<Hash> blocks;
 		// In protocol V4, either txs or blocks must contain exactly 1 hash, otherwise ban
+		// If peer advertised get_objects_batch in handshake, up to that many hashes total are allowed
+		uint64_t max_response_size = 0;  // 0 means MAX_RESPONSE_SIZE
+		// Peers advertising get_objects_batch also return blocks without transactions if asked
+		bool headers_only = false;
 	};
 	struct Response {
 		enum {
 			ID       = BC_COMMANDS_POOL_BASE + 4,
 			TYPE     = LevinProtocol::NOTIFY,
 			MAX_SIZE = 4096 + parameters::MAX_HEADER_SIZE + parameters::BLOCK_CAPACITY_VOTE_MAX +
-			           parameters::BLOCK_CAPACITY_VOTE_MAX * sizeof(Hash) / MIN_NONCOINBASE_TRANSACTION_SIZE
+			           parameters::BLOCK_CAPACITY_VOTE_MAX * sizeof(Hash) / MIN_NONCOINBASE_TRANSACTION_SIZE +
+			           Request::MAX_RESPONSE_SIZE + Request::MAX_BATCH_COUNT * sizeof(Hash)
 		};
 		// MAX_SIZE is like this because BlockTemplate contains transaction id per block transaction
 		// In protocol V4, we request only single object, so get exactly 1 object (or missed id) back
+		// In batch, each requested hash is returned as object, missed id or over budget id
 		std::vector<BinaryArray> txs;
 		std::vector<RawBlock> blocks;
 		std::vector<Hash> missed_ids;
+		std::vector<Hash> over_budget_ids;  // Not sent because response reached max_response_size, ask again
+
+		std::string get_error() const;  // empty if response is acceptable, otherwise reason to disconnect
 	};
 };
 
@@ -45,16 +45,18 @@ struct PeerlistEntryLegacy {
 
 struct BasicNodeData {
 	UUID network_id;
-	uint8_t version      = 0;
-	Timestamp local_time = 0;
-	uint16_t my_port     = 0;  // p2p external port.
-	PeerIdType peer_id   = 0;
+	uint8_t version            = 0;
+	Timestamp local_time       = 0;
+	uint16_t my_port           = 0;  // p2p external port.
+	PeerIdType peer_id         = 0;
+	uint32_t get_objects_batch = 0;  // max objects in GetObjects request peer accepts, 0 means exactly 1 (V4)
 };
 
 struct CoreSyncData {
 	Height current_height = 0;  // crazy, but this one is top block + 1 instead of top block
 	// We conform to legacy by sending incremented field on wire
 	Hash top_id;
+	Height pruned_below_height = 0;  // peer has no block bodies below, do not request them
 };
 
 struct TransactionDesc {
@@ -85,6 +87,13 @@ struct ConnectionDesc {
 	bool is_incoming    = false;
 	uint8_t p2p_version = 0;
 	TopBlockDesc top_block_desc;
+	uint64_t download_bytes_per_second = 0;  // measured on blocks we downloaded from peer
+	uint32_t download_latency_ms       = 0;  // from request to received block
+	size_t download_quota              = 0;  // blocks we allow in flight to this peer now
+	size_t downloading_block_count     = 0;
+	size_t downloaded_block_count      = 0;
+	size_t hedged_request_count        = 0;  // blocks also requested here because other peer stalled
+	size_t relay_suppressed_count      = 0;  // transactions and blocks not relayed, because peer knows them
 };
 
 struct CoreStatistics {
@@ -107,6 +116,8 @@ struct CoreStatistics {
 	Height upgrade_decided_height               = 0;
 	Height upgrade_votes_in_top_block           = 0;
 	uint64_t node_database_size                 = 0;
+	size_t archive_queue_size                   = 0;  // only with --archive
+	size_t archive_dropped_count                = 0;
 };
 
 // inline bool operator<(const NetworkAddressLegacy &a, const NetworkAddressLegacy &b) {
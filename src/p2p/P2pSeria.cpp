@@ -19,6 +19,15 @@ Hash p2p::ProofOfTrust::get_hash() const {
 }
 #endif
 
+std::string p2p::GetObjects::Response::get_error() const {
+	if (blocks.size() + txs.size() + missed_ids.size() + over_budget_ids.size() > Request::MAX_BATCH_COUNT)
+		return "Too much objects in GetObjectsResponse";
+	// Responder always sends first object, otherwise we would ask the same peer again forever
+	if (blocks.empty() && txs.empty() && missed_ids.empty() && !over_budget_ids.empty())
+		return "Over budget without any object";
+	return std::string{};
+}
+
 namespace seria {
 
 // TODO - Endianness
@@ -75,6 +84,8 @@ void ser_members(CoreStatistics &v, seria::ISeria &s) {
 	seria_kv("peer_list_gray", v.peer_list_gray, s);
 	seria_kv("connected_peers", v.connected_peers, s);
 	seria_kv("node_database_size", v.node_database_size, s);
+	seria_kv_optional("archive_queue_size", v.archive_queue_size, s);
+	seria_kv_optional("archive_dropped_count", v.archive_dropped_count, s);
 }
 
 void ser_members(BasicNodeData &v, seria::ISeria &s) {
@@ -83,6 +94,8 @@ void ser_members(BasicNodeData &v, seria::ISeria &s) {
 	seria_kv("peer_id", v.peer_id, s);
 	seria_kv("local_time", v.local_time, s);
 	seria_kv("my_port", v.my_port, s);
+	if (s.is_input() || v.get_objects_batch != 0)
+		seria_kv_optional("get_objects_batch", v.get_objects_batch, s);
 }
 
 void ser_kv_plus1(common::StringView name, Height &v, seria::ISeria &s) {
@@ -103,6 +116,8 @@ void ser_members(CoreSyncData &v, seria::ISeria &s) {
 	// TODO - in V5, remove serialization as current_height
 	seria_kv("height", height, s);
 	seria_kv("top_id", v.top_id, s);
+	if (s.is_input() || v.pruned_below_height != 0)
+		seria_kv_optional("pruned_below_height", v.pruned_below_height, s);
 }
 
 void ser_members(p2p::Handshake::Request &v, seria::ISeria &s) {
@@ -151,12 +166,18 @@ void ser_members(p2p::RelayTransactions::Notify &v, seria::ISeria &s) {
 void ser_members(p2p::GetObjects::Request &v, seria::ISeria &s) {
 	serialize_as_binary(v.txs, "txs", s);
 	serialize_as_binary(v.blocks, "blocks", s);
+	if (s.is_input() || v.max_response_size != 0)
+		seria_kv_optional("max_response_size", v.max_response_size, s);
+	if (s.is_input() || v.headers_only)
+		seria_kv_optional("headers_only", v.headers_only, s);
 }
 
 void ser_members(p2p::GetObjects::Response &v, seria::ISeria &s) {
 	seria_kv("txs", v.txs, s);
 	seria_kv("blocks", v.blocks, s);
 	serialize_as_binary(v.missed_ids, "missed_ids", s);
+	if (s.is_input() || !v.over_budget_ids.empty())
+		serialize_as_binary(v.over_budget_ids, "over_budget_ids", s);
 }
 
 void ser_members(p2p::GetChain::Request &v, seria::ISeria &s) { serialize_as_binary(v.block_ids, "block_ids", s); }
@@ -207,6 +228,13 @@ void ser_members(ConnectionDesc &v, seria::ISeria &s) {
 	seria_kv("is_incoming", v.is_incoming, s);
 	seria_kv("p2p_version", v.p2p_version, s);
 	seria_kv("top_block_desc", v.top_block_desc, s);
+	seria_kv_optional("download_bytes_per_second", v.download_bytes_per_second, s);
+	seria_kv_optional("download_latency_ms", v.download_latency_ms, s);
+	seria_kv_optional("download_quota", v.download_quota, s);
+	seria_kv_optional("downloading_block_count", v.downloading_block_count, s);
+	seria_kv_optional("downloaded_block_count", v.downloaded_block_count, s);
+	seria_kv_optional("hedged_request_count", v.hedged_request_count, s);
+	seria_kv_optional("relay_suppressed_count", v.relay_suppressed_count, s);
 }
 void ser_members(TopBlockDesc &v, seria::ISeria &s) {
 	seria_kv("hash", v.hash, s);
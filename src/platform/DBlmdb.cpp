@@ -2,10 +2,18 @@
 // Licensed under the GNU Lesser General Public License. See LICENSE for details.
 
 #include "DBlmdb.hpp"
+#include <fstream>
 #include <iostream>
 #include "PathTools.hpp"
+#include "common/Invariant.hpp"
 #include "common/Math.hpp"
+#include "common/Metrics.hpp"
 #include "common/string.hpp"
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace platform;
 
@@ -26,6 +34,32 @@ static void lmdb_check(int rc, const std::string &msg) {
 		lmdb::Error::do_throw(msg, rc);
 }
 
+static std::string unsynced_marker_path(const std::string &full_path) { return full_path + "/unsynced"; }
+
+// Same boot id means only process crashed, so OS page cache still has every commit
+static std::string get_boot_id() {  // empty if unknown, then every unclean shutdown is treated as OS crash
+	std::string boot_id;
+#if defined(__linux__)
+	std::ifstream in("/proc/sys/kernel/random/boot_id");  // size of /proc files is 0, so no load_file
+	std::getline(in, boot_id);
+#endif
+	return boot_id;
+}
+
+static void write_unsynced_marker(const std::string &full_path) {
+	FileStream fs(unsynced_marker_path(full_path), O_CREATE_ALWAYS);
+	const std::string boot_id = get_boot_id();
+	fs.write(boot_id.data(), boot_id.size());
+	fs.fsync();
+#if !defined(_WIN32)
+	const int fd = ::open(platform::expand_path(full_path).c_str(), O_RDONLY);  // new file needs folder sync
+	if (fd != -1) {
+		::fsync(fd);
+		::close(fd);
+	}
+#endif
+}
+
 platform::lmdb::Env::Env(bool read_only) : m_read_only(read_only) {
 	lmdb_check(::mdb_env_create(&handle), "mdb_env_create ");
 }
@@ -86,10 +120,103 @@ DBlmdb::DBlmdb(OpenMode open_mode, const std::string &full_path, uint64_t max_tx
 	               MDB_NOMETASYNC | (open_mode == O_READ_EXISTING ? MDB_RDONLY : 0), 0644),
 	    "Failed to open database " + full_path + " in mdb_env_open ");
 	// MDB_NOMETASYNC - We agree to trade chance of losing 1 last transaction for 2x performance boost
+	recover_after_unsynced_shutdown();
 	resize_and_begin_tx();
 	db_dbi = std::make_unique<lmdb::Dbi>(*db_txn);
 }
 
+DBlmdb::~DBlmdb() {
+	if (!sync_thread.joinable())
+		return;
+	{
+		std::unique_lock<std::mutex> lock(sync_mutex);
+		sync_quit = true;
+	}
+	sync_cv.notify_one();
+	sync_thread.join();  // Thread makes final sync before quitting
+	if (sync_error == MDB_SUCCESS && committed_counter == synced_counter)
+		platform::remove_file(unsynced_marker_path(full_path));
+}
+
+void DBlmdb::recover_after_unsynced_shutdown() {
+	std::string marker;
+	if (!platform::load_file(unsynced_marker_path(full_path), marker))
+		return;
+	const std::string boot_id = get_boot_id();
+	if (boot_id.empty() || marker != boot_id)
+		throw lmdb::Error("Database " + full_path +
+		                  " was not synced to disk before OS restart or power loss, it may be corrupted, please "
+		                  "delete it");
+	if (db_env.m_read_only)
+		return;  // Owner will sync and remove marker
+	lmdb_check(::mdb_env_sync(db_env.handle, 1), "mdb_env_sync ");
+	if (!platform::remove_file(unsynced_marker_path(full_path)))
+		throw lmdb::Error("Failed to remove " + unsynced_marker_path(full_path));
+}
+
+void DBlmdb::set_background_sync(float max_lag_seconds) {
+	invariant(!sync_thread.joinable(), "Background sync can be set only once");
+	if (max_lag_seconds <= 0 || db_env.m_read_only)
+		return;
+	write_unsynced_marker(full_path);  // before first unsynced commit
+	lmdb_check(::mdb_env_set_flags(db_env.handle, MDB_NOSYNC, 1), "mdb_env_set_flags ");
+	max_sync_lag = max_lag_seconds;
+	sync_thread  = std::thread(&DBlmdb::sync_thread_run, this);
+}
+
+std::string DBlmdb::get_sync_error() const {
+	std::unique_lock<std::mutex> lock(sync_mutex);
+	if (sync_error == MDB_SUCCESS)
+		return std::string{};
+	return common::to_string(sync_error) + " " + std::string(::mdb_strerror(sync_error));
+}
+
+float DBlmdb::get_durability_lag() const {
+	std::unique_lock<std::mutex> lock(sync_mutex);
+	if (committed_counter == synced_counter)
+		return 0;
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - oldest_unsynced_commit).count();
+}
+
+void DBlmdb::sync_thread_run() {
+	const auto max_lag = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	    std::chrono::duration<float>(max_sync_lag));
+	std::unique_lock<std::mutex> lock(sync_mutex);
+	while (true) {
+		if (committed_counter == synced_counter) {
+			if (sync_quit)
+				return;
+			sync_cv.wait(lock);
+			continue;
+		}
+		if (!sync_quit && std::chrono::steady_clock::now() < oldest_unsynced_commit + max_lag) {
+			sync_cv.wait_until(lock, oldest_unsynced_commit + max_lag);  // group commits
+			continue;
+		}
+		const uint64_t target = committed_counter;
+		const auto sync_start = std::chrono::steady_clock::now();
+		lock.unlock();
+		// Without MDB_WRITEMAP this is fdatasync of data file, which does not interfere with writer or mapsize
+		const int rc = ::mdb_env_sync(db_env.handle, 1);
+		lock.lock();
+		if (rc != MDB_SUCCESS) {
+			// Error can be transient (full disk, NFS hiccup), so we retry. Until then commits do not wait for disk,
+			// owner reports get_sync_error() and durability lag keeps growing
+			sync_error = rc;
+			synced_cv.notify_all();
+			if (sync_quit)
+				return;  // Final sync failed, nothing more we can do
+			sync_cv.wait_until(lock, sync_start + max_lag, [&]() { return sync_quit; });
+			continue;
+		}
+		sync_error     = MDB_SUCCESS;
+		synced_counter = target;
+		if (committed_counter != synced_counter)  // Those commits were made after sync_start
+			oldest_unsynced_commit = sync_start;
+		synced_cv.notify_all();
+	}
+}
+
 void DBlmdb::resize_and_begin_tx() {
 	// VALGRIND is limited to 32GB, modify code appropriately
 
@@ -181,8 +308,23 @@ DBlmdb::Cursor DBlmdb::rbegin(const std::string &prefix, const std::string &midd
 }
 
 void DBlmdb::commit_db_txn() {
+	static auto &commit_seconds =
+	    common::metrics::registry().histogram("db_commit_seconds", "DB transaction commit duration");
+	common::metrics::ScopeTimer timer(commit_seconds);
 	db_txn->commit();
 	db_txn.reset();
+	if (sync_thread.joinable()) {
+		const auto max_lag = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		    std::chrono::duration<float>(max_sync_lag * 2));
+		std::unique_lock<std::mutex> lock(sync_mutex);
+		if (committed_counter == synced_counter)
+			oldest_unsynced_commit = std::chrono::steady_clock::now();
+		committed_counter += 1;
+		sync_cv.notify_one();
+		while (sync_error == MDB_SUCCESS && committed_counter != synced_counter &&
+		       std::chrono::steady_clock::now() - oldest_unsynced_commit > max_lag)
+			synced_cv.wait(lock);
+	}
 	resize_and_begin_tx();
 }
 
@@ -264,6 +406,7 @@ void DBlmdb::delete_db(const std::string &full_path) {
 	auto ep = platform::expand_path(full_path);
 	std::remove((ep + "/data.mdb").c_str());
 	std::remove((ep + "/lock.mdb").c_str());
+	std::remove(unsynced_marker_path(ep).c_str());
 	std::remove(ep.c_str());
 }
 
@@ -356,6 +499,72 @@ void DBlmdb::run_tests() {
 			std::cout << cur.get_suffix() << std::endl;
 		}
 	}
+	{
+		DBlmdb db(platform::O_OPEN_EXISTING, "temp_db");
+		db.set_background_sync(0.05f);
+		for (size_t i = 0; i != 10; ++i) {
+			db.put("sync/" + common::to_string(i), "v", false);
+			db.commit_db_txn();
+		}
+		std::cout << "-- background sync lag=" << db.get_durability_lag() << std::endl;
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		invariant(db.get_durability_lag() == 0 && db.get_sync_error().empty(), "Background sync did not catch up");
+	}
+	std::string marker;
+	invariant(!load_file(unsynced_marker_path("temp_db"), marker), "Unsynced marker left after clean shutdown");
+	{
+		DBlmdb db(platform::O_READ_EXISTING, "temp_db");
+		size_t count = 0;
+		for (auto cur = db.begin("sync/"); !cur.end(); cur.next())
+			count += 1;
+		invariant(count == 10, "Commits lost with background sync");
+	}
+#if !defined(_WIN32)
+	{  // Process crash with commits not yet synced, no final sync and no mdb_env_close
+		const pid_t pid = ::fork();
+		invariant(pid >= 0, "fork failed");
+		if (pid == 0) {
+			auto db = new DBlmdb(platform::O_OPEN_EXISTING, "temp_db");  // leaked on purpose
+			db->set_background_sync(3600);
+			for (size_t i = 0; i != 10; ++i) {
+				db->put("crash/" + common::to_string(i), "v", false);
+				db->commit_db_txn();
+			}
+			::_exit(db->get_durability_lag() > 0 ? 0 : 1);
+		}
+		int status = 0;
+		invariant(::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+		    "Crashing process failed");
+		invariant(load_file(unsynced_marker_path("temp_db"), marker), "Unsynced marker not left by crashed process");
+		if (get_boot_id().empty()) {  // cannot tell process crash from OS crash, so DB is refused
+			bool thrown = false;
+			try {
+				DBlmdb db(platform::O_OPEN_EXISTING, "temp_db");
+			} catch (const lmdb::Error &) {
+				thrown = true;
+			}
+			invariant(thrown, "Database with unsynced marker and unknown boot id was opened");
+			remove_file(unsynced_marker_path("temp_db"));
+		}
+		DBlmdb db(platform::O_OPEN_EXISTING, "temp_db");
+		invariant(!load_file(unsynced_marker_path("temp_db"), marker), "Unsynced marker not removed after recovery");
+		size_t count = 0;
+		for (auto cur = db.begin("crash/"); !cur.end(); cur.next())
+			count += 1;
+		invariant(count == 10, "Commits lost after process crash with background sync");
+	}
+#endif
+	{  // OS crash or power loss with commits not yet synced, marker is from previous boot
+		invariant(save_file(unsynced_marker_path("temp_db"), std::string("previous boot")), "");
+		bool thrown = false;
+		try {
+			DBlmdb db(platform::O_READ_EXISTING, "temp_db");
+		} catch (const lmdb::Error &) {
+			thrown = true;
+		}
+		invariant(thrown, "Database not synced before OS restart was opened");
+		remove_file(unsynced_marker_path("temp_db"));
+	}
 	delete_db("temp_db");
 }
 
@@ -5,8 +5,12 @@
 
 #include <lmdb.h>
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include "Files.hpp"  // For OpenMode
 #include "common/BinaryArray.hpp"
 #include "common/Nocopy.hpp"
@@ -67,11 +71,38 @@ class DBlmdb {
 	uint64_t max_tx_size;
 	void resize_and_begin_tx();
 
+	// Background sync, all fields protected by sync_mutex
+	float max_sync_lag = 0;
+	mutable std::mutex sync_mutex;
+	std::condition_variable sync_cv;    // wakes sync thread
+	std::condition_variable synced_cv;  // wakes commit waiting for lagging disk
+	uint64_t committed_counter = 0;
+	uint64_t synced_counter    = 0;
+	std::chrono::steady_clock::time_point oldest_unsynced_commit;
+	int sync_error = MDB_SUCCESS;
+	bool sync_quit = false;
+	std::thread sync_thread;
+	void sync_thread_run();
+	void recover_after_unsynced_shutdown();  // throws if DB can be corrupted
+
 public:
 	explicit DBlmdb(OpenMode open_mode, const std::string &full_path,
 	    uint64_t max_tx_size = 0x100000000);  // 4 Gb default
+	~DBlmdb();
 	const std::string &get_path() const { return full_path; }
 	void commit_db_txn();
+	void set_cache_sizes(size_t, size_t) {}  // lmdb uses OS page cache
+	void set_write_ahead_log() {}            // lmdb has no journal
+	// Unsafe, opt-in. Opens env with MDB_NOSYNC, commits stop waiting for disk, fsync runs on background thread,
+	// grouping commits made during max_lag_seconds. If disk cannot keep up, commit waits until lag is back within
+	// 2 * max_lag_seconds. Process crash loses nothing, data is already in OS page cache. But OS crash or power
+	// loss can corrupt DB, because without sync OS may write meta page before data pages it refers to
+	// (LMDB keeps integrity only on file systems preserving write order). Failed syncs are retried.
+	// Synced "unsynced" marker with boot id lives in DB folder from first unsynced commit until final sync.
+	// If it is found on open, DB is synced and opened after process crash, but refused after OS restart.
+	void set_background_sync(float max_lag_seconds);
+	float get_durability_lag() const;    // seconds since oldest commit not yet on disk
+	std::string get_sync_error() const;  // empty if last background sync succeeded
 	size_t test_get_approximate_size() const;
 	size_t get_approximate_items_count() const;
 
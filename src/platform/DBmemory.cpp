@@ -3,7 +3,11 @@
 
 #include "DBmemory.hpp"
 #include <string.h>
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <random>
 #include "common/Invariant.hpp"
 #include "common/Math.hpp"
 #include "common/MemoryStreams.hpp"
@@ -61,68 +65,250 @@ std::vector<DBmemory::JournalEntry> DBmemory::move_journal() {
 
 size_t DBmemory::test_get_approximate_size() const { return total_size; }
 
-size_t DBmemory::get_approximate_items_count() const { return storage.size(); }
+size_t DBmemory::get_approximate_items_count() const { return items_count; }
+
+static const size_t ARENA_CHUNK = 1024 * 1024;
+
+char *DBmemory::arena_allocate(size_t size) {
+	arena_used += size;
+	if (size > ARENA_CHUNK / 4) {  // dedicated chunk, current one continues to be used
+		arena_chunks.push_back(std::make_unique<char[]>(size));
+		return arena_chunks.back().get();
+	}
+	if (size > arena_left) {
+		arena_chunks.push_back(std::make_unique<char[]>(ARENA_CHUNK));
+		arena_top  = arena_chunks.back().get();
+		arena_left = ARENA_CHUNK;
+	}
+	char *result = arena_top;
+	arena_top += size;
+	arena_left -= size;
+	return result;
+}
+
+void DBmemory::arena_free(const Item &item) {
+	arena_garbage += item.capacity;
+	if (arena_garbage > 16 * ARENA_CHUNK && arena_garbage > arena_used / 2)
+		compact_arena();
+}
+
+void DBmemory::compact_arena() {
+	auto old_chunks = std::move(arena_chunks);
+	arena_chunks.clear();
+	arena_top     = nullptr;
+	arena_left    = 0;
+	arena_used    = 0;
+	arena_garbage = 0;
+	for (auto &page : pages)
+		for (size_t i = 0; i != page->count; ++i) {
+			Item &item    = page->items[i];
+			item.capacity = item.key_size + item.value_size;
+			char *data    = arena_allocate(item.capacity);
+			memcpy(data, item.data, item.capacity);
+			item.data = data;
+		}
+}
+
+uint64_t DBmemory::key_head(const char *key, size_t size) {
+	uint64_t result = 0;
+	for (size_t i = 0; i != 8; ++i)
+		result = (result << 8) | (i < size ? static_cast<unsigned char>(key[i]) : 0);
+	return result;
+}
+
+static int compare_key(uint64_t head, const char *data, size_t size, uint64_t khead, const std::string &key) {
+	if (head != khead)
+		return head < khead ? -1 : 1;
+	int res = memcmp(data, key.data(), std::min(size, key.size()));
+	if (res != 0)
+		return res;
+	return size < key.size() ? -1 : size > key.size() ? 1 : 0;
+}
+
+template<class Before>
+DBmemory::Position DBmemory::search(Before before) const {
+	// Last page whose first item is before, then first item in it which is not
+	auto pit = std::partition_point(
+	    pages.begin(), pages.end(), [&](const std::unique_ptr<Page> &page) { return before(page->items[0]); });
+	if (pit == pages.begin())
+		return Position{0, 0};  // also end for empty db
+	--pit;
+	const Page &page = **pit;
+	Position result{static_cast<size_t>(pit - pages.begin()), 0};
+	result.pos = std::partition_point(page.items, page.items + page.count, before) - page.items;
+	if (result.pos == page.count) {
+		result.page += 1;
+		result.pos = 0;
+	}
+	return result;
+}
+
+DBmemory::Position DBmemory::lower_bound(const std::string &key) const {
+	const uint64_t khead = key_head(key.data(), key.size());
+	return search(
+	    [&](const Item &item) { return compare_key(item.head, item.data, item.key_size, khead, key) < 0; });
+}
+
+DBmemory::Position DBmemory::upper_bound(const std::string &key) const {
+	const uint64_t khead = key_head(key.data(), key.size());
+	return search(
+	    [&](const Item &item) { return compare_key(item.head, item.data, item.key_size, khead, key) <= 0; });
+}
+
+DBmemory::Position DBmemory::prefix_upper_bound(const std::string &prefix) const {
+	// Items truncated to prefix size are compared with prefix
+	return search([&](const Item &item) {
+		return memcmp(item.data, prefix.data(), std::min<size_t>(item.key_size, prefix.size())) <= 0;
+	});
+}
+
+bool DBmemory::find(const std::string &key, Position &p) const {
+	p = lower_bound(key);
+	if (is_end(p))
+		return false;
+	const Item &item = at(p);
+	return item.key_size == key.size() && memcmp(item.data, key.data(), key.size()) == 0;
+}
+
+void DBmemory::next(Position &p) const {
+	if (is_end(p))
+		return;
+	if (++p.pos == pages[p.page]->count) {
+		p.page += 1;
+		p.pos = 0;
+	}
+}
+
+void DBmemory::prev(Position &p) const {
+	if (p.pos != 0) {
+		p.pos -= 1;
+		return;
+	}
+	if (p.page == 0 || pages.empty()) {
+		p = Position{pages.size(), 0};  // before first is end
+		return;
+	}
+	p.page -= 1;
+	p.pos = pages[p.page]->count - 1;
+}
+
+void DBmemory::insert_at(Position p, const Item &item) {
+	if (pages.empty())
+		pages.push_back(std::make_unique<Page>());
+	if (is_end(p))
+		p = Position{pages.size() - 1, pages.back()->count};
+	Page *page = pages[p.page].get();
+	if (page->count == PAGE_ITEMS) {
+		auto new_page = std::make_unique<Page>();
+		const size_t half = PAGE_ITEMS / 2;
+		std::copy(page->items + half, page->items + PAGE_ITEMS, new_page->items);
+		new_page->count = PAGE_ITEMS - half;
+		page->count     = half;
+		if (p.pos > half) {
+			p.pos -= half;
+			page = new_page.get();
+		}
+		pages.insert(pages.begin() + p.page + 1, std::move(new_page));
+	}
+	std::copy_backward(page->items + p.pos, page->items + page->count, page->items + page->count + 1);
+	page->items[p.pos] = item;
+	page->count += 1;
+	items_count += 1;
+	version += 1;
+}
+
+void DBmemory::erase_at(const Position &p) {
+	Page *page          = pages[p.page].get();
+	const Item old_item = page->items[p.pos];
+	std::copy(page->items + p.pos + 1, page->items + page->count, page->items + p.pos);
+	page->count -= 1;
+	items_count -= 1;
+	version += 1;
+	if (page->count == 0)
+		pages.erase(pages.begin() + p.page);
+	else if (p.page + 1 != pages.size() && page->count + pages[p.page + 1]->count <= PAGE_ITEMS / 2) {
+		const Page &next_page = *pages[p.page + 1];
+		std::copy(next_page.items, next_page.items + next_page.count, page->items + page->count);
+		page->count += next_page.count;
+		pages.erase(pages.begin() + p.page + 1);
+	}
+	arena_free(old_item);
+}
 
 DBmemory::Cursor::Cursor(DBmemory *db, const std::string &prefix, const std::string &middle, bool forward)
     : db(db), prefix(prefix), forward(forward) {
-	std::string start  = prefix + middle;
-	std::string finish = start;
-	if (finish.size() < db->max_key_size)
-		finish += std::string(db->max_key_size - finish.size(), char(0xff));  // char('~')
+	const std::string start = prefix + middle;
 	if (forward)
-		it = db->storage.lower_bound(start);
+		position = db->lower_bound(start);
 	else {
-		it = db->storage.upper_bound(finish);
-		if (it == db->storage.begin())
-			it = db->storage.end();
-		else
-			--it;
+		position = db->prefix_upper_bound(start);
+		db->prev(position);
 	}
 	check_prefix();
 }
 
 void DBmemory::Cursor::check_prefix() {
-	if (it == db->storage.end())
+	version = db->version;
+	if (db->is_end(position)) {
+		is_end = true;
 		return;
-	if (!common::starts_with(it->first, prefix)) {
-		it = db->storage.end();
+	}
+	const Item &item = db->at(position);
+	if (item.key_size < prefix.size() || memcmp(item.data, prefix.data(), prefix.size()) != 0) {
+		is_end = true;
 		return;
 	}
-	suffix = it->first.substr(prefix.size());
+	suffix.assign(item.data + prefix.size(), item.key_size - prefix.size());
+}
+
+const DBmemory::Item &DBmemory::Cursor::current() const {
+	if (version == db->version)
+		return db->at(position);
+	Position p;
+	invariant(db->find(prefix + suffix, p), "DBmemory::Cursor current item was erased");
+	return db->at(p);
 }
 
 void DBmemory::Cursor::next() {
-	if (it == db->storage.end())
+	if (is_end)
 		return;
-	if (forward)
-		++it;
-	else {
-		if (it == db->storage.begin())
-			it = db->storage.end();
+	if (version == db->version) {
+		if (forward)
+			db->next(position);
 		else
-			--it;
+			db->prev(position);
+	} else if (forward)
+		position = db->upper_bound(prefix + suffix);
+	else {
+		position = db->lower_bound(prefix + suffix);
+		db->prev(position);
 	}
 	check_prefix();
 }
 
 void DBmemory::Cursor::erase() {
-	if (it == db->storage.end())
+	if (is_end)
+		return;
+	if (version != db->version && !db->find(prefix + suffix, position)) {
+		next();  // current item was already erased through db
 		return;
-	db->total_size -= it->first.size() + it->second.size();
-	if (db->use_journal)
-		db->journal.push_back(JournalEntry{it->first, common::BinaryArray{}, true});
-	it = db->storage.erase(it);
-	if (!forward) {
-		if (it == db->storage.begin())
-			it = db->storage.end();
-		else
-			--it;
 	}
-	check_prefix();
+	const Item &item = db->at(position);
+	db->total_size -= item.key_size + item.value_size;
+	if (db->use_journal)
+		db->journal.push_back(JournalEntry{prefix + suffix, common::BinaryArray{}, true});
+	db->erase_at(position);
+	next();
 }
 
-std::string DBmemory::Cursor::get_value_string() const { return common::as_string(it->second); }
-common::BinaryArray DBmemory::Cursor::get_value_array() const { return it->second; }
+std::string DBmemory::Cursor::get_value_string() const {
+	const Item &item = current();
+	return std::string(item.value(), item.value_size);
+}
+common::BinaryArray DBmemory::Cursor::get_value_array() const {
+	const Item &item = current();
+	return common::BinaryArray(item.value(), item.value() + item.value_size);
+}
 
 DBmemory::Cursor DBmemory::begin(const std::string &prefix, const std::string &middle, bool forward) const {
 	return Cursor(const_cast<DBmemory *>(this), prefix, middle, forward);
@@ -141,14 +327,16 @@ void DBmemory::commit_db_txn() {
 	std::string committed_state;
 	committed_state.reserve(test_get_approximate_size() * 4 / 3);
 	common::StringOutputStream stream(committed_state);
-	//	std::cout << "DBmemory::commit_db_txn kv count=" << storage.size() << std::endl;
-	stream.write_varint(storage.size());
-	for (const auto &item : storage) {
-		stream.write_varint(item.first.size());
-		stream.write(item.first);
-		stream.write_varint(item.second.size());
-		stream.write(item.second);
-	}
+	//	std::cout << "DBmemory::commit_db_txn kv count=" << items_count << std::endl;
+	stream.write_varint(items_count);
+	for (const auto &page : pages)
+		for (size_t i = 0; i != page->count; ++i) {
+			const Item &item = page->items[i];
+			stream.write_varint(item.key_size);
+			stream.write(item.data, item.key_size);
+			stream.write_varint(item.value_size);
+			stream.write(item.value(), item.value_size);
+		}
 	async_op =
 	    std::make_unique<AsyncIndexDBOperation>(full_path, committed_state.data(), committed_state.size(), [=]() {
 		    std::cout << "DBmemory::commit_db_txn async op finished" << std::endl;
@@ -157,55 +345,81 @@ void DBmemory::commit_db_txn() {
 #endif
 }
 
-void DBmemory::put(const std::string &key, const common::BinaryArray &value, bool nooverwrite) {
-	auto res = storage.emplace(key, value);
-	if (res.second) {
-		total_size += key.size() + value.size();
-		//		if (key.size() > max_key_size)
-		//			std::cout << "max_key_size=" << key.size() << std::endl;
-		max_key_size = std::max(max_key_size, key.size());
+void DBmemory::put(const std::string &key, const char *value, size_t value_size, bool nooverwrite) {
+	invariant(key.size() <= std::numeric_limits<uint32_t>::max() &&
+	              value_size <= std::numeric_limits<uint32_t>::max() - key.size(),
+	    "DBmemory::put key or value too big");
+	Position p = lower_bound(key);
+	if (!is_end(p) && at(p).key_size == key.size() && memcmp(at(p).data, key.data(), key.size()) == 0) {
+		if (nooverwrite)
+			throw std::runtime_error("DBmemory::put will overwrite row");
+		Item &item = at(p);
+		total_size -= item.value_size;
+		total_size += value_size;
+		item.value_size = static_cast<uint32_t>(value_size);
+		if (key.size() + value_size <= item.capacity) {
+			memcpy(item.data + key.size(), value, value_size);
+		} else {
+			const Item old_item = item;
+			item.capacity       = static_cast<uint32_t>(key.size() + value_size);
+			item.data           = arena_allocate(item.capacity);
+			memcpy(item.data, key.data(), key.size());
+			memcpy(item.data + key.size(), value, value_size);
+			arena_free(old_item);
+		}
 		if (use_journal)
-			journal.push_back(JournalEntry{key, value, false});
+			journal.push_back(JournalEntry{key, common::BinaryArray(value, value + value_size), false});
 		return;
 	}
-	if (nooverwrite)
-		throw std::runtime_error("DBmemory::put will overwrite row");
-	total_size -= res.first->second.size();
-	total_size += value.size();
-	res.first->second = value;
+	Item item;
+	item.head       = key_head(key.data(), key.size());
+	item.key_size   = static_cast<uint32_t>(key.size());
+	item.value_size = static_cast<uint32_t>(value_size);
+	item.capacity   = item.key_size + item.value_size;
+	item.data       = arena_allocate(item.capacity);
+	memcpy(item.data, key.data(), key.size());
+	memcpy(item.data + key.size(), value, value_size);
+	insert_at(p, item);
+	total_size += key.size() + value_size;
 	if (use_journal)
-		journal.push_back(JournalEntry{key, value, false});
+		journal.push_back(JournalEntry{key, common::BinaryArray(value, value + value_size), false});
+}
+
+void DBmemory::put(const std::string &key, const common::BinaryArray &value, bool nooverwrite) {
+	put(key, reinterpret_cast<const char *>(value.data()), value.size(), nooverwrite);
 }
 
 void DBmemory::put(const std::string &key, const std::string &svalue, bool nooverwrite) {
-	put(key, common::as_binary_array(svalue), nooverwrite);
+	put(key, svalue.data(), svalue.size(), nooverwrite);
 }
 
 bool DBmemory::get(const std::string &key, common::BinaryArray &value) const {
-	auto it = storage.find(key);
-	if (it == storage.end())
+	Position p;
+	if (!find(key, p))
 		return false;
-	value = it->second;
+	const Item &item = at(p);
+	value.assign(item.value(), item.value() + item.value_size);
 	return true;
 }
 
 bool DBmemory::get(const std::string &key, std::string &value) const {
-	auto it = storage.find(key);
-	if (it == storage.end())
+	Position p;
+	if (!find(key, p))
 		return false;
-	value = common::as_string(it->second);
+	const Item &item = at(p);
+	value.assign(item.value(), item.value_size);
 	return true;
 }
 
 void DBmemory::del(const std::string &key, bool mustexist) {
-	auto it = storage.find(key);
-	if (it == storage.end()) {
+	Position p;
+	if (!find(key, p)) {
 		if (mustexist)
 			throw std::runtime_error("DBmemory::del row does not exits");
 		return;
 	}
-	total_size -= key.size() + it->second.size();
-	it = storage.erase(it);
+	total_size -= key.size() + at(p).value_size;
+	erase_at(p);
 	if (use_journal)
 		journal.push_back(JournalEntry{key, common::BinaryArray{}, true});
 }
@@ -245,6 +459,101 @@ void DBmemory::backup_db(const std::string &path, const std::string &dst_path) {
 	throw std::runtime_error("Memory backed does not support hot backup");
 }
 
+// Random puts, dels and cursor walks compared with std::map. Db is mutated while cursors are open
+static void test_random_vs_map() {
+	typedef std::map<std::string, std::string, DBmemory::CmpByUnsigned> Model;
+	const DBmemory::CmpByUnsigned less{};
+	std::mt19937_64 rnd(1234);
+	const std::string alphabet("\x00\x01" "ab" "\x7f\x80\xfe\xff", 8);  // unsigned order matters
+	auto random_string = [&](size_t max_size) {
+		std::string result;
+		for (size_t i = rnd() % (max_size + 1); i-- > 0;)
+			result += alphabet[rnd() % alphabet.size()];
+		return result;
+	};
+	auto has_prefix = [](const std::string &key, const std::string &prefix) {
+		return key.compare(0, prefix.size(), prefix) == 0;
+	};
+	DBmemory db(platform::O_CREATE_NEW, "temp_db", []() {});
+	Model model;
+	// Key cursor must be at, "<end>" if at end (alphabet has no '<')
+	auto expect = [&](Model::const_iterator it, bool forward, const std::string &prefix) {
+		if (forward)
+			return it != model.end() && has_prefix(it->first, prefix) ? it->first : std::string{"<end>"};
+		if (it == model.begin())
+			return std::string{"<end>"};
+		--it;
+		return has_prefix(it->first, prefix) ? it->first : std::string{"<end>"};
+	};
+	auto actual = [&](const DBmemory::Cursor &cur, const std::string &prefix) {
+		if (cur.end())
+			return std::string{"<end>"};
+		const std::string key = prefix + cur.get_suffix();
+		const auto mit        = model.find(key);
+		invariant(mit != model.end() && cur.get_value_string() == mit->second, "Cursor value differs from std::map");
+		return key;
+	};
+	for (size_t step = 0; step != 20000; ++step) {
+		const auto op = rnd() % 8;
+		if (op < 4) {
+			const std::string key   = random_string(10);
+			const std::string value = random_string(40);  // sometimes does not fit into item capacity
+			db.put(key, value, false);
+			model[key] = value;
+		} else if (op < 6) {
+			const std::string key = model.empty() || rnd() % 4 == 0
+			                            ? random_string(10)
+			                            : std::next(model.begin(), rnd() % model.size())->first;
+			db.del(key, false);
+			model.erase(key);
+		} else {
+			const std::string prefix = random_string(1);
+			const std::string start  = prefix + random_string(2);
+			const bool forward       = rnd() % 2 == 0;
+			const std::string middle = start.substr(prefix.size());
+			auto cur                 = forward ? db.begin(prefix, middle) : db.rbegin(prefix, middle);
+			auto mit                 = model.lower_bound(start);
+			if (!forward)  // after all keys starting with start
+				while (mit != model.end() && !less(start, mit->first.substr(0, start.size())))
+					++mit;
+			invariant(actual(cur, prefix) == expect(mit, forward, prefix), "Cursor start differs from std::map");
+			while (!cur.end()) {
+				const std::string key = actual(cur, prefix);
+				switch (rnd() % 4) {
+				case 0: {  // insert, cursor position becomes stale
+					const std::string other = random_string(10);
+					db.put(other, "m", false);
+					model[other] = "m";
+					break;
+				}
+				case 1: {  // erase other item, sometimes the current one
+					const std::string other = std::next(model.begin(), rnd() % model.size())->first;
+					db.del(other, true);
+					model.erase(other);
+					break;
+				}
+				}
+				if (rnd() % 3 == 0) {
+					cur.erase();
+					model.erase(key);
+				} else
+					cur.next();
+				invariant(actual(cur, prefix) == expect(forward ? model.upper_bound(key) : model.lower_bound(key),
+				                                     forward, prefix),
+				    "Cursor step differs from std::map");
+			}
+		}
+		invariant(db.get_approximate_items_count() == model.size(), "Item count differs from std::map");
+	}
+	auto cur = db.begin(std::string{});
+	for (const auto &kv : model) {
+		invariant(!cur.end() && cur.get_suffix() == kv.first && cur.get_value_string() == kv.second,
+		    "Full scan differs from std::map");
+		cur.next();
+	}
+	invariant(cur.end(), "Full scan has extra items");
+}
+
 void DBmemory::run_tests() {
 	delete_db("temp_db");
 	{
@@ -348,5 +657,6 @@ void DBmemory::run_tests() {
 			std::cout << cur.get_suffix() << std::endl;
 		}
 	}
+	test_random_vs_map();
 	delete_db("temp_db");
 }
@@ -4,8 +4,9 @@
 #pragma once
 
 #include <functional>
-#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #include "Files.hpp"  // For OpenMode
 #include "common/BinaryArray.hpp"
 #include "common/Nocopy.hpp"
@@ -13,6 +14,9 @@
 namespace platform {
 
 class AsyncIndexDBOperation;
+
+// Keys and values live in arena chunks, ordered index is a B+-tree of height 2 - flat vector of
+// pages of sorted items. Item keeps first 8 key bytes inline, so most comparisons do not touch arena
 class DBmemory {
 public:
 	struct JournalEntry {
@@ -25,7 +29,6 @@ public:
 		int compare(const std::string &a, const std::string &b) const;
 		bool operator()(const std::string &a, const std::string &b) const { return compare(a, b) < 0; }
 	};
-	typedef std::map<std::string, common::BinaryArray, CmpByUnsigned> Storage;
 
 	explicit DBmemory(OpenMode open_mode, const std::string &full_path, std::function<void()> &&o_handler);
 	~DBmemory();
@@ -34,6 +37,11 @@ public:
 	std::vector<JournalEntry> move_journal();
 
 	void commit_db_txn();
+	void set_cache_sizes(size_t, size_t) {}  // everything is in memory
+	void set_write_ahead_log() {}            // nothing to write
+	void set_background_sync(float) {}       // nothing to sync
+	float get_durability_lag() const { return 0; }
+	std::string get_sync_error() const { return std::string{}; }
 	size_t test_get_approximate_size() const;
 	size_t get_approximate_items_count() const;
 
@@ -45,22 +53,45 @@ public:
 
 	void del(const std::string &key, bool mustexist);
 
+private:
+	struct Item {
+		uint64_t head;  // first 8 key bytes, big-endian, zero-padded
+		char *data;     // key followed by value, in arena
+		uint32_t key_size;
+		uint32_t value_size;
+		uint32_t capacity;
+		const char *value() const { return data + key_size; }
+	};
+	static constexpr size_t PAGE_ITEMS = 64;
+	struct Page {
+		size_t count = 0;
+		Item items[PAGE_ITEMS];
+	};
+	struct Position {
+		size_t page = 0;
+		size_t pos  = 0;
+	};
+
+public:
 	class Cursor {
 		DBmemory *const db;
 		std::string suffix;
 		const std::string prefix;
 		bool forward = false;
-		std::map<std::string, common::BinaryArray>::iterator it;
+		bool is_end  = false;
+		Position position;
+		size_t version = 0;  // position is valid only while db->version is the same
 		friend class DBmemory;
 		void check_prefix();
+		const Item &current() const;
 		Cursor(DBmemory *db, const std::string &prefix, const std::string &middle, bool forward);
 
 	public:
 		const std::string &get_suffix() const noexcept { return suffix; }
 		std::string get_value_string() const;
 		common::BinaryArray get_value_array() const;
-		bool end() const noexcept { return it == db->storage.end(); }
-		void next();
+		bool end() const noexcept { return is_end; }
+		void next();   // if db was modified, continues from the key after (before) current one
 		void erase();  // moves to the next value
 	};
 	friend class Cursor;
@@ -91,11 +122,39 @@ private:
 	std::unique_ptr<AsyncIndexDBOperation> async_op;
 #endif
 	std::function<void()> o_handler;
-	Storage storage;
 	std::vector<JournalEntry> journal;
-	bool use_journal    = false;
-	size_t total_size   = 0;
-	size_t max_key_size = 0;
+	bool use_journal  = false;
+	size_t total_size = 0;
+
+	std::vector<std::unique_ptr<Page>> pages;
+	size_t items_count = 0;
+	size_t version     = 0;  // incremented on each insert or erase, invalidates positions
+
+	std::vector<std::unique_ptr<char[]>> arena_chunks;
+	char *arena_top      = nullptr;
+	size_t arena_left    = 0;
+	size_t arena_used    = 0;
+	size_t arena_garbage = 0;  // overwritten or erased bytes, reclaimed by compact_arena
+	char *arena_allocate(size_t size);
+	void arena_free(const Item &item);
+	void compact_arena();
+
+	static uint64_t key_head(const char *key, size_t size);
+	template<class Before>
+	Position search(Before before) const;  // first position where before(item) is false
+	Position lower_bound(const std::string &key) const;
+	Position upper_bound(const std::string &key) const;
+	Position prefix_upper_bound(const std::string &prefix) const;  // after all keys starting with prefix
+	bool is_end(const Position &p) const { return p.page == pages.size(); }
+	const Item &at(const Position &p) const { return pages[p.page]->items[p.pos]; }
+	Item &at(const Position &p) { return pages[p.page]->items[p.pos]; }
+	bool find(const std::string &key, Position &p) const;
+	void next(Position &p) const;
+	void prev(Position &p) const;
+	void insert_at(Position p, const Item &item);
+	void erase_at(const Position &p);
+
+	void put(const std::string &key, const char *value, size_t value_size, bool nooverwrite);
 };
 
 }  // namespace platform
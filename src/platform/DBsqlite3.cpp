@@ -6,6 +6,7 @@
 #include "PathTools.hpp"
 #include "common/Invariant.hpp"
 #include "common/Math.hpp"
+#include "common/Metrics.hpp"
 #include "common/string.hpp"
 
 using namespace platform;
@@ -63,8 +64,9 @@ sqlite::Dbi::~Dbi() {
 void sqlite::Stmt::prepare(const Dbi &dbi, const char *statement) {
 	sqlite::check(sqlite3_prepare_v2(dbi.handle, statement, -1, &handle, nullptr), statement);
 }
-void sqlite::Stmt::bind_blob(int position, const void *data, size_t size) const {
-	sqlite::check(sqlite3_bind_blob(handle, position, data == nullptr ? "" : data, static_cast<int>(size), nullptr),
+void sqlite::Stmt::bind_blob(int position, const void *data, size_t size, bool copy) const {
+	sqlite::check(sqlite3_bind_blob(handle, position, data == nullptr ? "" : data, static_cast<int>(size),
+	                  copy ? SQLITE_TRANSIENT : SQLITE_STATIC),
 	    "sqlite3_bind_blob failed");
 	// sqlite3_bind_blob uses nullptr as a NULL indicator. Empty arrays can have nullptr as a data().
 }
@@ -108,6 +110,21 @@ DBsqliteKV::DBsqliteKV(OpenMode open_mode, const std::string &full_path, uint64_
 	stmt_del.prepare(db_dbi, "DELETE FROM kv_table WHERE kk = ?");
 }
 
+void DBsqliteKV::set_cache_sizes(size_t cache_mb, size_t mmap_mb) {
+	db_dbi.commit_txn();  // mmap_size is applied to new transactions
+	db_dbi.exec(("PRAGMA cache_size=-" + common::to_string(cache_mb * 1024)).c_str());  // negative means KiB
+	db_dbi.exec(("PRAGMA mmap_size=" + common::to_string(uint64_t(mmap_mb) * 1024 * 1024)).c_str());
+	db_dbi.begin_txn();
+}
+
+void DBsqliteKV::set_write_ahead_log() {
+	db_dbi.commit_txn();  // journal mode cannot be changed inside transaction
+	db_dbi.exec("PRAGMA journal_mode=WAL");
+	// In WAL mode NORMAL keeps database consistent, but last transactions can be lost on power failure
+	db_dbi.exec("PRAGMA synchronous=NORMAL");
+	db_dbi.begin_txn();
+}
+
 size_t DBsqliteKV::test_get_approximate_size() const { return 0; }
 
 size_t DBsqliteKV::get_approximate_items_count() const {
@@ -123,23 +140,50 @@ size_t DBsqliteKV::get_approximate_items_count() const {
 
 static const size_t max_key_size = 255;
 
-DBsqliteKV::Cursor::Cursor(const DBsqliteKV *db,
-    const sqlite::Dbi &db_dbi,
-    const std::string &prefix,
-    const std::string &middle,
-    bool forward)
-    : db(db), prefix(prefix) {
-	std::string start  = prefix + middle;
+static std::string range_finish(const std::string &start) {
 	std::string finish = start;
 	if (finish.size() < max_key_size)
 		finish += std::string(max_key_size - finish.size(), char(0xff));  // char('~')
-	const char *sql = forward ? "SELECT kk, vv FROM kv_table WHERE kk >= ? ORDER BY kk ASC"
-	                          : "SELECT kk, vv FROM kv_table WHERE kk <= ? ORDER BY kk DESC";
-	stmt_get.prepare(db_dbi, sql);
-	stmt_get.bind_blob(1, forward ? start.data() : finish.data(), forward ? start.size() : finish.size());
+	return finish;
+}
+
+sqlite::Stmt DBsqliteKV::take_cursor_stmt(bool forward) const {
+	auto &free_stmts = free_cursor_stmts[forward];
+	if (free_stmts.empty()) {
+		sqlite::Stmt stmt;
+		stmt.prepare(db_dbi, forward ? "SELECT kk, vv FROM kv_table WHERE kk BETWEEN ? AND ? ORDER BY kk ASC"
+		                             : "SELECT kk, vv FROM kv_table WHERE kk BETWEEN ? AND ? ORDER BY kk DESC");
+		return stmt;
+	}
+	sqlite::Stmt stmt(std::move(free_stmts.back()));
+	free_stmts.pop_back();
+	return stmt;
+}
+
+// Range is bounded by prefix on both sides, so sqlite stops at prefix end instead of us
+DBsqliteKV::Cursor::Cursor(const DBsqliteKV *db, const std::string &prefix, const std::string &middle, bool forward)
+    : db(db), stmt_get(db->take_cursor_stmt(forward)), prefix(prefix), forward(forward) {
+	// Cursor can be moved, so we ask sqlite to copy bounds
+	if (forward) {
+		const std::string start  = prefix + middle;
+		const std::string finish = range_finish(prefix);
+		stmt_get.bind_blob(1, start.data(), start.size(), true);
+		stmt_get.bind_blob(2, finish.data(), finish.size(), true);
+	} else {
+		const std::string finish = range_finish(prefix + middle);
+		stmt_get.bind_blob(1, prefix.data(), prefix.size(), true);
+		stmt_get.bind_blob(2, finish.data(), finish.size(), true);
+	}
 	step_and_check();
 }
 
+DBsqliteKV::Cursor::~Cursor() {
+	if (!stmt_get.handle)
+		return;  // moved from
+	sqlite3_reset(stmt_get.handle);
+	db->free_cursor_stmts[forward].push_back(std::move(stmt_get));
+}
+
 void DBsqliteKV::Cursor::next() { step_and_check(); }
 
 void DBsqliteKV::Cursor::erase() {
@@ -148,7 +192,7 @@ void DBsqliteKV::Cursor::erase() {
 	sqlite3_reset(stmt_get.handle);
 	std::string my_key = prefix + suffix;
 	const_cast<DBsqliteKV *>(db)->del(my_key, true);
-	stmt_get.bind_blob(1, my_key.data(), my_key.size());
+	stmt_get.bind_blob(forward ? 1 : 2, my_key.data(), my_key.size(), true);  // continue from deleted key
 	step_and_check();
 }
 
@@ -180,7 +224,7 @@ std::string DBsqliteKV::Cursor::get_value_string() const { return std::string(da
 common::BinaryArray DBsqliteKV::Cursor::get_value_array() const { return common::BinaryArray(data, data + size); }
 
 DBsqliteKV::Cursor DBsqliteKV::begin(const std::string &prefix, const std::string &middle, bool forward) const {
-	return Cursor(this, db_dbi, prefix, middle, forward);
+	return Cursor(this, prefix, middle, forward);
 }
 
 DBsqliteKV::Cursor DBsqliteKV::rbegin(const std::string &prefix, const std::string &middle) const {
@@ -188,6 +232,9 @@ DBsqliteKV::Cursor DBsqliteKV::rbegin(const std::string &prefix, const std::stri
 }
 
 void DBsqliteKV::commit_db_txn() {
+	static auto &commit_seconds =
+	    common::metrics::registry().histogram("db_commit_seconds", "DB transaction commit duration");
+	common::metrics::ScopeTimer timer(commit_seconds);
 	db_dbi.commit_txn();
 	db_dbi.begin_txn();
 }
@@ -278,6 +325,8 @@ void DBsqliteKV::delete_db(const std::string &path) {
 	auto ep = platform::expand_path(path);
 	std::remove((ep + ".sqlite").c_str());
 	std::remove((ep + ".sqlite-journal").c_str());
+	std::remove((ep + ".sqlite-wal").c_str());
+	std::remove((ep + ".sqlite-shm").c_str());
 }
 void DBsqliteKV::backup_db(const std::string &path, const std::string &dst_path) {
 	throw platform::sqlite::Error("SQlite backed does not support hot backup - stop daemons, then copy database");
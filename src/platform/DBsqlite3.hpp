@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 #include "Files.hpp"  // For OpenMode
 #include "common/BinaryArray.hpp"
 #include "common/Nocopy.hpp"
@@ -27,7 +28,7 @@ struct Stmt : private common::Nocopy {
 	sqlite3_stmt *handle = nullptr;
 	void prepare(const Dbi &dbi, const char *statement);
 	bool step() const;  // false when fininshed, throws if error
-	void bind_blob(int position, const void *data, size_t size) const;
+	void bind_blob(int position, const void *data, size_t size, bool copy = false) const;
 	size_t column_bytes(int column) const;
 	const uint8_t *column_blob(int column) const;
 	Stmt() = default;
@@ -58,6 +59,13 @@ public:
 	const std::string &get_path() const { return full_path; }
 
 	void commit_db_txn();
+	void set_cache_sizes(size_t cache_mb, size_t mmap_mb);  // call right after constructor
+	// WAL with synchronous=NORMAL, commits do not fsync. Power failure can lose last commits, DB stays consistent.
+	// Also adds -wal and -shm files next to DB, which must be copied together with it
+	void set_write_ahead_log();
+	void set_background_sync(float) {}                      // commits are always durable
+	float get_durability_lag() const { return 0; }
+	std::string get_sync_error() const { return std::string{}; }
 	size_t test_get_approximate_size() const;
 	size_t get_approximate_items_count() const;
 
@@ -74,18 +82,20 @@ public:
 
 	class Cursor {
 		const DBsqliteKV *const db;
-		sqlite::Stmt stmt_get;
+		sqlite::Stmt stmt_get;  // borrowed from db cache
 		std::string suffix;
 		const char *data = nullptr;
 		size_t size      = 0;
 		bool is_end      = false;  // data, size == nullptr, 0 if value is empty
 		const std::string prefix;
+		const bool forward;
 		void step_and_check();
 		friend class DBsqliteKV;
-		Cursor(const DBsqliteKV *db, const sqlite::Dbi &db_dbi, const std::string &prefix, const std::string &middle,
-		    bool forward);
+		Cursor(const DBsqliteKV *db, const std::string &prefix, const std::string &middle, bool forward);
 
 	public:
+		Cursor(Cursor &&other) = default;
+		~Cursor();
 		const std::string &get_suffix() const noexcept { return suffix; }
 		std::string get_value_string() const;
 		common::BinaryArray get_value_array() const;
@@ -119,6 +129,10 @@ private:
 	sqlite::Stmt stmt_insert;
 	sqlite::Stmt stmt_update;
 	sqlite::Stmt stmt_del;
+
+	// Preparing statement is several times slower than running short range query, so cursors reuse them
+	mutable std::vector<sqlite::Stmt> free_cursor_stmts[2];  // [forward]
+	sqlite::Stmt take_cursor_stmt(bool forward) const;
 };
 
 }  // namespace platform
@@ -13,6 +13,8 @@
 #else
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif
 
@@ -171,3 +173,63 @@ std::string FileStream::utf16_to_utf8(const std::wstring &str) {
 }
 
 #endif
+
+MappedFile::MappedFile(const std::string &filename) {
+#ifdef _WIN32
+	auto wfilename = FileStream::utf8_to_utf16(expand_path(filename));
+	HANDLE handle  = CreateFileW(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		throw common::StreamError("Failed to open file for mapping '" + filename + "'");
+	LARGE_INTEGER fsize{};
+	if (!GetFileSizeEx(handle, &fsize)) {
+		CloseHandle(handle);
+		throw common::StreamError("Error getting size of file '" + filename + "'");
+	}
+	data_size = common::integer_cast<size_t>(fsize.QuadPart);
+	if (data_size == 0) {  // Windows cannot map empty files
+		CloseHandle(handle);
+		return;
+	}
+	HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(handle);  // mapping keeps file open
+	if (!mapping)
+		throw common::StreamError(
+		    "Error mapping file '" + filename + "', GetLastError()=" + common::to_string(GetLastError()));
+	data_ptr = reinterpret_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	CloseHandle(mapping);  // view keeps mapping alive
+	if (!data_ptr)
+		throw common::StreamError(
+		    "Error mapping file '" + filename + "', GetLastError()=" + common::to_string(GetLastError()));
+#else
+	int fd = open(expand_path(filename).c_str(), O_RDONLY);
+	if (fd == -1)
+		throw common::StreamError("Failed to open file for mapping '" + filename + "'");
+	struct stat st {};
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		throw common::StreamError("Error getting size of file '" + filename + "', errno=" + common::to_string(errno));
+	}
+	data_size = common::integer_cast<size_t>(st.st_size);
+	if (data_size == 0) {  // mmap fails on zero length
+		close(fd);
+		return;
+	}
+	void *ptr = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);  // mapping keeps file open
+	if (ptr == MAP_FAILED)
+		throw common::StreamError("Error mapping file '" + filename + "', errno=" + common::to_string(errno));
+	madvise(ptr, data_size, MADV_SEQUENTIAL);  // only a hint, we ignore result
+	data_ptr = reinterpret_cast<const uint8_t *>(ptr);
+#endif
+}
+
+MappedFile::~MappedFile() {
+	if (!data_ptr)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(data_ptr);
+#else
+	munmap(const_cast<uint8_t *>(data_ptr), data_size);
+#endif
+}
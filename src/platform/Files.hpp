@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include "common/Nocopy.hpp"
 #include "common/Streams.hpp"
@@ -45,4 +46,18 @@ private:
 	int fd = -1;
 #endif
 };
+
+// Read-only view of the whole file, for random access to big files without seek/read per item
+// Throws common::StreamError if file cannot be opened or mapped (for example, on 32-bit systems)
+class MappedFile : private common::Nocopy {
+public:
+	explicit MappedFile(const std::string &filename);
+	~MappedFile();
+	const uint8_t *data() const { return data_ptr; }
+	size_t size() const { return data_size; }
+
+private:
+	const uint8_t *data_ptr = nullptr;
+	size_t data_size        = 0;
+};
 }  // namespace platform
@@ -17,6 +17,7 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 
 #endif
 
@@ -238,6 +239,16 @@ bool copy_file(const std::string &from_path, const std::string &to_path) {
 	return true;
 }
 
+bool create_hard_link(const std::string &from_path, const std::string &to_path) {
+#if defined(_WIN32)
+	auto wfrom_path = FileStream::utf8_to_utf16(expand_path(from_path));
+	auto wto_path   = FileStream::utf8_to_utf16(expand_path(to_path));
+	return CreateHardLinkW(wto_path.c_str(), wfrom_path.c_str(), nullptr) != 0;
+#else
+	return ::link(expand_path(from_path).c_str(), expand_path(to_path).c_str()) == 0;
+#endif
+}
+
 bool remove_file(const std::string &path) {
 #if defined(_WIN32)
 	auto wpath = FileStream::utf8_to_utf16(expand_path(path));
@@ -38,6 +38,7 @@ bool create_folder_if_necessary(const std::string &path);   // Only last element
 bool create_folders_if_necessary(const std::string &path);  // Recursively all elements
 bool atomic_replace_file(const std::string &from_path, const std::string &to_path);
 bool copy_file(const std::string &from_path, const std::string &to_path);
+bool create_hard_link(const std::string &from_path, const std::string &to_path);  // fails if to_path exists
 bool remove_file(const std::string &path);
 std::vector<std::string> get_filenames_in_folder(const std::string &path);
 std::string get_filename_without_folder(const std::string &path);
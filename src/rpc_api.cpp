@@ -493,6 +493,10 @@ void ser_members(api::cnd::SyncMemPool::Request &v, ISeria &s) {
 		throw std::runtime_error(
 		    "SyncMemPool::Request known_hashes must be sorted in increasing order (from [0000..] to [ffff..])");
 	seria_kv("need_redundant_data", v.need_redundant_data, s);
+	if (s.is_input() || v.known_pool_version != 0) {
+		seria_kv_optional("known_pool_version", v.known_pool_version, s);
+		seria_kv_optional("known_pool_log_id", v.known_pool_log_id, s);
+	}
 }
 
 void ser_members(api::cnd::SyncMemPool::Response &v, ISeria &s) {
@@ -500,6 +504,19 @@ void ser_members(api::cnd::SyncMemPool::Response &v, ISeria &s) {
 	seria_kv("added_raw_transactions", v.added_raw_transactions, s);
 	seria_kv("added_transactions", v.added_transactions, s);
 	seria_kv("status", v.status, s);
+	seria_kv_optional("pool_log_id", v.pool_log_id, s);
+	if (s.is_input() || v.removed_all)
+		seria_kv_optional("removed_all", v.removed_all, s);
+}
+
+void ser_members(api::cnd::Subscribe::Notification &v, ISeria &s) {
+	seria_kv("top_block_hash", v.top_block_hash, s);
+	seria_kv("top_block_height", v.top_block_height, s);
+	seria_kv("transaction_pool_version", v.transaction_pool_version, s);
+	seria_kv("pool_log_id", v.pool_log_id, s);
+	seria_kv("added_transactions", v.added_transactions, s);
+	seria_kv("removed_transactions", v.removed_transactions, s);
+	seria_kv("removed_all", v.removed_all, s);
 }
 
 void ser_members(api::cnd::GetRandomOutputs::Request &v, ISeria &s) {
@@ -720,12 +720,33 @@ struct SyncMemPool {  // Used by walletd sync process
 	struct Request {
 		std::vector<Hash> known_hashes;   // Should be sent sorted
 		bool need_redundant_data = true;  // walletd and smart clients can save traffic
+		// If set from previous response, known_hashes are not needed, only changes since that version are sent
+		size_t known_pool_version  = 0;
+		uint64_t known_pool_log_id = 0;
 	};
 	struct Response {
 		std::vector<Hash> removed_hashes;                       // Hashes no more in pool
 		std::vector<TransactionPrefix> added_raw_transactions;  // New raw transactions in pool
 		std::vector<api::Transaction> added_transactions;       // contain only info known to bytecoind
 		GetStatus::Response status;  // We save roundtrip during sync by also sending status here
+		uint64_t pool_log_id = 0;    // together with status.transaction_pool_version, 0 if daemon does not support
+		bool removed_all     = false;  // changes since known_pool_version are lost, added contain whole pool
+	};
+};
+
+struct Subscribe {  // Replaces long polling of get_status for notification services
+	static std::string url() { return "/subscribe"; }
+	static std::string notification_method() { return "on_change"; }
+	// GET or POST to url starts chunked HTTP/1.1 response, which never finishes. Each chunk is single line
+	// containing JSON-RPC notification with Notification in params. First notification contains whole pool.
+	struct Notification {
+		Hash top_block_hash;
+		Height top_block_height         = 0;
+		size_t transaction_pool_version = 0;
+		uint64_t pool_log_id            = 0;  // Same meaning as in SyncMemPool
+		std::vector<Hash> added_transactions;
+		std::vector<Hash> removed_transactions;
+		bool removed_all = false;  // added_transactions contain whole pool
 	};
 };
 
@@ -995,6 +1016,7 @@ void ser_members(cn::api::cnd::GetRawTransaction::Request &v, ISeria &s);
 void ser_members(cn::api::cnd::GetRawTransaction::Response &v, ISeria &s);
 void ser_members(cn::api::cnd::SyncMemPool::Request &v, ISeria &s);
 void ser_members(cn::api::cnd::SyncMemPool::Response &v, ISeria &s);
+void ser_members(cn::api::cnd::Subscribe::Notification &v, ISeria &s);
 void ser_members(cn::api::cnd::GetRandomOutputs::Request &v, ISeria &s);
 void ser_members(cn::api::cnd::GetRandomOutputs::Response &v, ISeria &s);
 void ser_members(cn::api::cnd::SendTransaction::Request &v, ISeria &s);
@@ -15,6 +15,7 @@
 #include "common/Varint.hpp"
 #include "crypto/crypto.hpp"
 #include "logging/ConsoleLogger.hpp"
+#include "platform/PathTools.hpp"
 #include "seria/BinaryInputStream.hpp"
 #include "seria/BinaryOutputStream.hpp"
 #include "seria/KVBinaryInputStream.hpp"
@@ -39,10 +40,8 @@ public:
 	std::vector<KeyPair> checkpoint_keypairs;
 
 	TestMiner(BlockChainState &block_chain, const Currency &currency) : block_chain(block_chain), currency(currency) {
-		invariant(currency.parse_account_address_string("21mQ7KPdmLbjfpg3Coayi4hZzAEgjeL87QXGeDTHahKeJsvKHc6DoprAJmqU"
-		                                                "cLhWTUXtxCL6rQFSwEUe6NZdEoqZNpSq1iC",
-		              &address),
-		    "");
+		// Not parsed from string, because address prefix differs between currencies
+		address = AccountAddressLegacy{crypto::random_keypair().public_key, crypto::random_keypair().public_key};
 		std::vector<std::string> skeys{"dacb828348483011f63ebb538401b3f3d52e8ce1916278f9b189f820d1ec730e",
 		    "3ab19160e48f77b41a9b7f87322542b1e977577f30886db3dce3076806709d0d",
 		    "16d4d146d8ba2bbff13a4bb174b4c5d73d3ca22817a6585956a697337be26a09"};
@@ -118,6 +117,124 @@ public:
 	}
 };
 
+// Header-first sync must get the same difficulties as add_block, including headers right after genesis
+static void test_header_difficulty(const BlockChain &block_chain) {
+	std::vector<api::BlockHeader> headers;
+	for (Height h = 0; h <= block_chain.get_tip_height(); ++h) {
+		Hash bid;
+		api::BlockHeader info;
+		invariant(block_chain.get_chain(h, &bid) && block_chain.get_header(bid, &info), "");
+		headers.push_back(info);
+	}
+	for (size_t start = 0; start != headers.size(); ++start) {  // headers after start are not yet added
+		std::vector<Timestamp> timestamps;
+		std::vector<CumulativeDifficulty> difficulties;
+		for (size_t i = start + 1; i != headers.size(); ++i) {
+			CumulativeDifficulty cumulative_difficulty{};
+			const Difficulty difficulty = block_chain.get_next_header_difficulty(
+			    headers.at(start), headers.at(i).major_version, timestamps, difficulties, &cumulative_difficulty);
+			invariant(difficulty == headers.at(i).difficulty &&
+			              cumulative_difficulty == headers.at(i).cumulative_difficulty,
+			    "header difficulty mismatch start=" + common::to_string(start) + " height=" + common::to_string(i));
+			timestamps.push_back(headers.at(i).timestamp);
+			difficulties.push_back(headers.at(i).cumulative_difficulty);
+		}
+	}
+}
+
+// Version 8 stored blocks uncompressed, they must be read as is after in-place upgrade to current version
+static void test_upgrade_from_8(logging::ILogger &logger, const Config &config, const Currency &currency) {
+	const std::string db_path = config.get_data_folder() + "/blockchain";
+	BlockChain::DB::delete_db(db_path);
+	std::vector<std::pair<Hash, BinaryArray>> blocks;
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		TestMiner test_miner(block_chain, currency);
+		test_miner.test_grow_chain(block_chain.get_tip().hash, 10);
+		for (Height h = 0; h <= block_chain.get_tip_height(); ++h) {
+			Hash bid;
+			BinaryArray block_data;
+			invariant(block_chain.get_chain(h, &bid) && block_chain.get_block(bid, &block_data, nullptr), "");
+			blocks.push_back(std::make_pair(bid, block_data));
+		}
+		block_chain.db_commit();
+	}
+	{
+		BlockChain::DB db(platform::O_OPEN_EXISTING, db_path);
+		db.put("$version", std::string("8"), false);
+		for (const auto &block : blocks)  // key layout from BlockChain::store_block
+			db.put("b" + BlockChain::DB::to_binary_key(block.first.data, sizeof(block.first.data)) + "b",
+			    block.second, false);
+		db.commit_db_txn();
+	}
+	{
+		BlockChainState block_chain(logger, config, currency, false);
+		invariant(block_chain.get_tip_height() + 1 == blocks.size(), "Upgrade lost blocks");
+		for (const auto &block : blocks) {
+			BinaryArray block_data;
+			RawBlock raw_block;
+			invariant(block_chain.get_block(block.first, &block_data, &raw_block) && block_data == block.second,
+			    "Upgrade changed block");
+			BlockTemplate block_template;
+			seria::from_binary(block_template, raw_block.block);
+			BinaryArray binary_tx;
+			Height height = 0;
+			Hash bid;
+			size_t index = 0;
+			invariant(block_chain.get_transaction(get_transaction_hash(block_template.base_transaction), &binary_tx,
+			              &height, &bid, &index) &&
+			              bid == block.first,
+			    "Upgrade lost coinbase transaction");
+		}
+		block_chain.db_commit();
+	}
+	BlockChain::DB db(platform::O_READ_EXISTING, db_path);
+	std::string version;
+	invariant(db.get("$version", version) && version != "8", "Version 8 not upgraded");
+}
+
+// Tip window is rebuilt with tip only, longer window after restart means it was loaded from startup cache
+class TestBlockChainState : public BlockChainState {
+public:
+	using BlockChainState::BlockChainState;
+	size_t get_tip_window_size() const { return get_tip_window().size(); }
+};
+
+// Startup cache replaces rebuild of tip window, medians and stack indexes, so loaded state must equal rebuilt one
+static void test_startup_cache(logging::ILogger &logger, Config config, const Currency &currency) {
+	const std::string db_path    = config.get_data_folder() + "/blockchain";
+	const std::string cache_path = config.get_data_folder() + "/blockchain_startup_cache";
+	config.paranoid_checks       = true;  // load_startup_cache also compares with rebuilt state
+	BlockChain::DB::delete_db(db_path);
+	platform::remove_file(cache_path);
+	Hash tip_bid;
+	{
+		TestBlockChainState block_chain(logger, config, currency, false);
+		TestMiner test_miner(block_chain, currency);
+		tip_bid = test_miner.test_grow_chain(block_chain.get_tip().hash, 30).hash;
+		invariant(block_chain.is_tip_state_consistent(), "State inconsistent after adding blocks");
+		block_chain.db_commit();
+	}
+	{
+		TestBlockChainState block_chain(logger, config, currency, false);
+		invariant(block_chain.get_tip_bid() == tip_bid && block_chain.get_tip_window_size() > 1,
+		    "Startup cache was not loaded");
+		invariant(block_chain.is_tip_state_consistent(), "Loaded startup cache differs from rebuilt state");
+		TestMiner test_miner(block_chain, currency);
+		tip_bid = test_miner.test_grow_chain(tip_bid, 5).hash;
+		invariant(block_chain.is_tip_state_consistent(), "State loaded from startup cache diverged after new blocks");
+		block_chain.db_commit();
+	}
+	invariant(platform::remove_file(cache_path), "Startup cache not saved");
+	{
+		TestBlockChainState block_chain(logger, config, currency, false);
+		invariant(block_chain.get_tip_bid() == tip_bid && block_chain.get_tip_window_size() == 1,
+		    "State was not rebuilt without startup cache");
+		invariant(block_chain.is_tip_state_consistent(), "Rebuilt state inconsistent");
+	}
+	BlockChain::DB::delete_db(db_path);
+}
+
 void test_blockchain(common::CommandLine &cmd) {
 	logging::ConsoleLogger logger;
 	Config config(cmd);
@@ -127,6 +244,9 @@ void test_blockchain(common::CommandLine &cmd) {
 
 	std::cout << "Point 1" << std::endl;
 	Currency currency(config);
+	test_upgrade_from_8(logger, config, currency);
+	test_startup_cache(logger, config, currency);
+	BlockChain::DB::delete_db(config.data_folder + "/blockchain");
 
 	std::cout << "Point 2" << std::endl;
 	BlockChainState block_chain(logger, config, currency, false);
@@ -136,6 +256,7 @@ void test_blockchain(common::CommandLine &cmd) {
 
 	std::cout << "Point 4" << std::endl;
 	auto middle_desc = test_miner.test_grow_chain(block_chain.get_tip().hash, 25);
+	test_header_difficulty(block_chain);
 
 	std::cout << "Point 5" << std::endl;
 	auto small_desc = test_miner.test_grow_chain(middle_desc.hash, 25);
@@ -176,6 +297,7 @@ void test_blockchain(common::CommandLine &cmd) {
 	test_miner.add_checkpoint(1, std::numeric_limits<uint64_t>::max(), Hash{}, 0);
 
 	invariant(block_chain.get_tip_bid() == big_plus_1_desc.hash, "");
+	test_header_difficulty(block_chain);
 }
 
 // Sometimes in the future we will test consistency with simple model
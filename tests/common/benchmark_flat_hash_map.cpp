@@ -0,0 +1,109 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmark_flat_hash_map.hpp"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "../Random.hpp"
+#include "common/FlatHashMap.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/hash.hpp"
+
+using crypto::Hash;
+
+static void measure(std::ostream &out, const char *name, size_t count, const std::function<void()> &fun) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	fun();
+	const auto finish = std::chrono::high_resolution_clock::now();
+	const auto microsec =
+	    std::max<long long>(1, std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+	out << "    " << name << ": " << count << " ops in " << microsec << " us, " << (count * 1000000 / microsec)
+	    << " ops/s" << std::endl;
+}
+
+static std::vector<Hash> make_keys(size_t count, size_t salt) {
+	std::vector<Hash> result(count);
+	for (size_t i = 0; i != count; ++i) {
+		const size_t body[2] = {i, salt};
+		result[i]            = crypto::cn_fast_hash(body, sizeof(body));
+	}
+	return result;
+}
+
+// Random operations on small key set, so erase often shifts elements of long probe chains
+static void test_flat_hash_map(size_t count) {
+	common::Random random(count);
+	const auto keys = make_keys(std::max<size_t>(1, count / 10), 0);
+	common::FlatHashMap<Hash, size_t> flat;
+	std::unordered_map<Hash, size_t> reference;
+	for (size_t i = 0; i != count; ++i) {
+		const Hash &key = keys[random() % keys.size()];
+		switch (random() % 4) {
+		case 0:
+		case 1:
+			invariant(flat.insert(std::make_pair(key, i)).second == reference.insert(std::make_pair(key, i)).second,
+			    "FlatHashMap insert differs");
+			break;
+		case 2:
+			invariant(flat.erase(key) == reference.erase(key), "FlatHashMap erase differs");
+			break;
+		default: {
+			auto fit = flat.find(key);
+			auto rit = reference.find(key);
+			invariant((fit == flat.end()) == (rit == reference.end()), "FlatHashMap find differs");
+			invariant(fit == flat.end() || fit->second == rit->second, "FlatHashMap value differs");
+			break;
+		}
+		}
+		invariant(flat.size() == reference.size(), "FlatHashMap size differs");
+	}
+	size_t iterated = 0;
+	for (const auto &kv : flat) {
+		invariant(reference.at(kv.first) == kv.second, "FlatHashMap iteration differs");
+		iterated += 1;
+	}
+	invariant(iterated == reference.size(), "FlatHashMap iteration count differs");
+	flat.clear();
+	invariant(flat.empty() && flat.find(keys.front()) == flat.end(), "FlatHashMap clear failed");
+}
+
+template<typename M>
+static void benchmark_map(const char *name, const std::vector<Hash> &keys, const std::vector<Hash> &absent,
+    std::ostream &out) {
+	M map;
+	out << name << std::endl;
+	measure(out, "insert", keys.size(), [&]() {
+		for (size_t i = 0; i != keys.size(); ++i)
+			map.insert(std::make_pair(keys[i], i));
+	});
+	size_t found = 0;
+	measure(out, "find present", keys.size(), [&]() {
+		for (const auto &key : keys)
+			found += map.find(key) != map.end();
+	});
+	measure(out, "find absent", absent.size(), [&]() {
+		for (const auto &key : absent)
+			found += map.find(key) != map.end();
+	});
+	invariant(found == keys.size(), "");
+	measure(out, "erase", keys.size(), [&]() {
+		for (const auto &key : keys)
+			map.erase(key);
+	});
+	invariant(map.empty(), "");
+}
+
+void benchmark_flat_hash_map(size_t count, std::ostream &out) {
+	test_flat_hash_map(count);
+	const auto keys   = make_keys(count, 1);  // prepared in advance, so we measure maps only
+	const auto absent = make_keys(count, 2);
+	out << "Hash map benchmark, " << count << " Hash keys" << std::endl;
+	benchmark_map<std::map<Hash, size_t>>("std::map", keys, absent, out);
+	benchmark_map<std::unordered_map<Hash, size_t>>("std::unordered_map", keys, absent, out);
+	benchmark_map<common::FlatHashMap<Hash, size_t>>("common::FlatHashMap", keys, absent, out);
+}
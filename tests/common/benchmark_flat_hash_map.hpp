@@ -0,0 +1,11 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <ostream>
+
+// Checks FlatHashMap against std::unordered_map, then compares insert/find/erase of count Hash keys
+// with std::map and std::unordered_map
+void benchmark_flat_hash_map(size_t count, std::ostream &out);
@@ -0,0 +1,136 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_compression.hpp"
+
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "../Random.hpp"
+#include "common/Compression.hpp"
+#include "common/Invariant.hpp"
+#include "common/StringTools.hpp"
+
+using common::BinaryArray;
+
+// Keys and signatures are random, amounts, varints and tags repeat, like in serialized block
+static BinaryArray make_block_like(common::Random &random, size_t size) {
+	BinaryArray result;
+	while (result.size() < size) {
+		const uint8_t fields[] = {2, 0, 1, 2, 0x80, 0x94, 0xeb, 0xdc, 0x03, 2, 2};
+		result.insert(result.end(), fields, fields + sizeof(fields));
+		for (size_t i = random() % 64 + 32; i-- > 0;)
+			result.push_back(static_cast<uint8_t>(random()));
+	}
+	result.resize(size);
+	return result;
+}
+
+static BinaryArray make_random(common::Random &random, size_t size) {
+	BinaryArray result(size);
+	const size_t alphabet = random() % 3 == 0 ? 256 : random() % 4 + 1;  // sometimes long runs and matches
+	for (auto &b : result)
+		b = static_cast<uint8_t>(random() % alphabet);
+	return result;
+}
+
+static BinaryArray compress(const BinaryArray &data) {
+	BinaryArray result;
+	common::lz_compress(data.data(), data.size(), &result);
+	return result;
+}
+
+static void check_roundtrip(const BinaryArray &data) {
+	const BinaryArray compressed = compress(data);
+	BinaryArray result{1, 2, 3};  // both functions append
+	common::lz_decompress(compressed.data(), compressed.size(), data.size(), &result);
+	invariant(result.size() == data.size() + 3 && std::equal(data.begin(), data.end(), result.begin() + 3),
+	    "lz roundtrip failed size=" + common::to_string(data.size()));
+	if (data.empty())
+		return;
+	for (size_t wrong_size : {data.size() - 1, data.size() + 1}) {
+		bool thrown = false;
+		try {
+			BinaryArray wrong;
+			common::lz_decompress(compressed.data(), compressed.size(), wrong_size, &wrong);
+		} catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		invariant(thrown, "lz_decompress accepted wrong original size");
+	}
+}
+
+// Decompressing from exact-size heap copy, so out of bounds read is caught by sanitizers
+static bool decompress_copy(const BinaryArray &compressed, size_t size, size_t original_size) {
+	std::vector<uint8_t> copy(compressed.begin(), compressed.begin() + size);
+	BinaryArray result;
+	try {
+		common::lz_decompress(copy.data(), copy.size(), original_size, &result);
+	} catch (const std::runtime_error &) {
+		return false;
+	}
+	invariant(result.size() == original_size, "lz_decompress returned wrong size");
+	return true;
+}
+
+void test_compression(size_t iterations) {
+	common::Random random(iterations);
+	check_roundtrip(BinaryArray{});
+	for (size_t size = 1; size != 64; ++size)
+		check_roundtrip(make_random(random, size));
+	for (size_t i = 0; i != iterations; ++i) {
+		const size_t size = random() % 3 == 0 ? random() % 300000 : random() % 2000;
+		check_roundtrip(random() % 2 == 0 ? make_random(random, size) : make_block_like(random, size));
+	}
+	// Every truncation must throw, corrupted data must throw or give exactly original_size bytes
+	for (size_t i = 0; i != iterations / 10; ++i) {
+		const BinaryArray data       = make_block_like(random, random() % 3000 + 1);
+		const BinaryArray compressed = compress(data);
+		for (size_t size = 0; size != compressed.size(); ++size)
+			invariant(!decompress_copy(compressed, size, data.size()),
+			    "lz_decompress accepted truncated data size=" + common::to_string(size));
+		for (size_t j = 0; j != 100; ++j) {
+			BinaryArray corrupted = compressed;
+			for (size_t k = random() % 4 + 1; k-- > 0;)
+				corrupted.at(random() % corrupted.size()) = static_cast<uint8_t>(random());
+			decompress_copy(corrupted, corrupted.size(), data.size());
+		}
+	}
+	const BinaryArray garbage = make_random(random, 10000);
+	for (size_t size = 0; size != 1000; ++size)
+		decompress_copy(garbage, size, 5000);
+	// Corrupted size varint must throw before allocating
+	const BinaryArray compressed = compress(make_block_like(random, 3000));
+	for (size_t huge : {compressed.size() * 1000, std::numeric_limits<size_t>::max() / 2,
+	         std::numeric_limits<size_t>::max()}) {
+		bool thrown = false;
+		try {
+			BinaryArray result;
+			common::lz_decompress(compressed.data(), compressed.size(), huge, &result);
+		} catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		invariant(thrown, "lz_decompress accepted huge original size " + common::to_string(huge));
+	}
+}
+
+void benchmark_compression(size_t count, std::ostream &out) {
+	common::Random random(count);
+	for (size_t block_size : {2000, 30000, 300000}) {
+		const BinaryArray data       = make_block_like(random, block_size);
+		const BinaryArray compressed = compress(data);
+		const auto start             = std::chrono::high_resolution_clock::now();
+		for (size_t i = 0; i != count; ++i) {
+			BinaryArray result;
+			common::lz_decompress(compressed.data(), compressed.size(), data.size(), &result);
+		}
+		const auto microsec = std::max<long long>(1,
+		    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start)
+		        .count());
+		out << "    block " << block_size << " bytes compressed to " << compressed.size() << ": "
+		    << double(microsec) / count << " us per decompress, " << (uint64_t(block_size) * count / microsec)
+		    << " MB/s" << std::endl;
+	}
+}
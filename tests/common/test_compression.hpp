@@ -0,0 +1,12 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <ostream>
+
+// Roundtrips of random and block-like data, corrupted and truncated input must throw or stay within original size
+void test_compression(size_t iterations);
+// Decompression speed for block sizes, this is the extra cost of BlockChain::get_transaction for compressed blocks
+void benchmark_compression(size_t count, std::ostream &out);
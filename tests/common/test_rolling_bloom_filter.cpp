@@ -0,0 +1,74 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_rolling_bloom_filter.hpp"
+
+#include <array>
+#include <vector>
+#include "../Random.hpp"
+#include "common/Invariant.hpp"
+#include "common/RollingBloomFilter.hpp"
+#include "common/StringTools.hpp"
+
+typedef std::array<uint8_t, 32> Key;  // like crypto hashes used by Node
+
+static Key random_key(common::Random &random) {
+	Key key;
+	for (auto &b : key)
+		b = static_cast<uint8_t>(random());
+	return key;
+}
+
+// Filter guarantees keys of current generation and whole previous one, that is last generation_size + current
+static void check_recent(const common::RollingBloomFilter &filter, const std::vector<Key> &keys, size_t recent) {
+	for (size_t i = keys.size() - recent; i != keys.size(); ++i)
+		invariant(filter.contains(keys[i].data(), keys[i].size()),
+		    "False negative for key " + common::to_string(i) + " of " + common::to_string(keys.size()));
+}
+
+static size_t count_false_positives(
+    common::Random &random, const common::RollingBloomFilter &filter, size_t queries) {
+	size_t result = 0;
+	for (size_t i = 0; i != queries; ++i) {
+		const Key key = random_key(random);  // 256 random bits never collide with inserted ones
+		if (filter.contains(key.data(), key.size()))
+			result += 1;
+	}
+	return result;
+}
+
+void test_rolling_bloom_filter(size_t generation_size) {
+	common::Random random(generation_size);
+	common::RollingBloomFilter filter(generation_size, random());
+	std::vector<Key> keys;
+	const size_t check_every = generation_size / 4 + 1;
+	for (size_t generation = 0; generation != 10; ++generation) {
+		for (size_t i = 0; i != generation_size; ++i) {
+			keys.push_back(random_key(random));
+			filter.insert(keys.back().data(), keys.back().size());
+			const size_t current = i + 1;
+			const size_t recent  = generation == 0 ? current : generation_size + current;
+			if (i == 0 || current % check_every == 0)  // right after rollover and few times per generation
+				check_recent(filter, keys, recent);
+			else
+				check_recent(filter, keys, 1);
+		}
+		check_recent(filter, keys, generation == 0 ? generation_size : 2 * generation_size);
+		// Both generations are full now, this is the worst case for false positives
+		const size_t queries         = 100000;
+		const size_t false_positives = count_false_positives(random, filter, queries);
+		invariant(false_positives * 200 < queries,  // expected about 0.1%, allow up to 0.5%
+		    "False positive rate too high " + common::to_string(false_positives) + " of " +
+		        common::to_string(queries));
+	}
+	// Inserting the same key again must not break anything
+	filter.insert(keys.back().data(), keys.back().size());
+	check_recent(filter, keys, generation_size);
+
+	filter.clear();
+	for (const auto &key : keys)
+		invariant(!filter.contains(key.data(), key.size()), "Key found after clear");
+	filter.insert(keys.front().data(), keys.front().size());
+	invariant(filter.contains(keys.front().data(), keys.front().size()), "Key not found after clear and insert");
+}
@@ -0,0 +1,10 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <cstddef>
+
+// Keys of current and previous generation are always found across many rollovers, false positive rate stays low
+void test_rolling_bloom_filter(size_t generation_size);
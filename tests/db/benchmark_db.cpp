@@ -0,0 +1,113 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmark_db.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "common/StringTools.hpp"
+#include "crypto/hash.hpp"
+#include "platform/DB.hpp"
+#include "platform/DBmemory.hpp"
+
+static const char *const bench_db_path = "bench_db";
+
+static std::vector<std::string> make_keys(size_t count) {  // prepared in advance, so we measure DB only
+	std::vector<std::string> keys;
+	keys.reserve(count);
+	for (size_t i = 0; i != count; ++i) {
+		crypto::Hash h = crypto::cn_fast_hash(&i, sizeof(i));
+		keys.push_back(platform::DB::to_binary_key(h.data, sizeof(h.data)));
+	}
+	return keys;
+}
+
+static void measure(std::ostream &out, const char *name, size_t count, const std::function<void()> &fun) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	fun();
+	const auto finish = std::chrono::high_resolution_clock::now();
+	const auto microsec =
+	    std::max<long long>(1, std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+	out << "    " << name << ": " << count << " ops in " << microsec << " us, " << (count * 1000000 / microsec)
+	    << " ops/s" << std::endl;
+}
+
+template<class DB>
+static void benchmark(DB &db, const char *name, const std::vector<std::string> &keys, std::ostream &out) {
+	const size_t count = keys.size();
+	db.set_cache_sizes(64, 256);
+	const std::string value(48, 'v');
+	out << name << " benchmark, " << count << " items" << std::endl;
+	measure(out, "put (nooverwrite)", count, [&]() {
+		for (size_t i = 0; i != count; ++i) {
+			db.put("t" + keys[i], value, true);
+			if (i % 10000 == 9999)
+				db.commit_db_txn();
+		}
+		db.commit_db_txn();
+	});
+	measure(out, "put (overwrite)", count, [&]() {
+		for (size_t i = 0; i != count; ++i)
+			db.put("o" + keys[i % 1000], value, false);
+		db.commit_db_txn();
+	});
+	measure(out, "get interleaved with put", count, [&]() {
+		std::string result;
+		for (size_t i = 0; i != count; ++i) {
+			db.put("i" + keys[i], value, true);
+			invariant(db.get("t" + keys[i], result) && result == value, "");
+			invariant(db.get("i" + keys[i], result) && result == value, "");
+		}
+		db.commit_db_txn();
+	});
+	measure(out, "get", count, [&]() {
+		std::string result;
+		for (size_t i = 0; i != count; ++i)
+			invariant(db.get("t" + keys[i], result), "");
+	});
+	measure(out, "short cursor", count, [&]() {
+		size_t found = 0;
+		for (size_t i = 0; i != count; ++i) {
+			auto cur = db.begin("t", keys[i].substr(0, 2));
+			if (!cur.end())
+				found += 1;
+		}
+		invariant(found != 0, "");
+	});
+	measure(out, "short reverse cursor", count, [&]() {
+		for (size_t i = 0; i != count; ++i)
+			db.rbegin("t", keys[i].substr(0, 2));
+	});
+	measure(out, "full scan", count, [&]() {
+		size_t found = 0;
+		for (auto cur = db.begin("t"); !cur.end(); cur.next())
+			found += 1;
+		invariant(found == count, "");
+	});
+}
+
+void benchmark_db(size_t count, std::ostream &out) {
+	const auto keys = make_keys(count);
+	platform::DB::delete_db(bench_db_path);
+	{
+		platform::DB db(platform::O_OPEN_ALWAYS, bench_db_path);
+		benchmark(db, "platform::DB", keys, out);
+	}
+	platform::DB::delete_db(bench_db_path);
+#if platform_USE_SQLITE
+	{
+		platform::DB db(platform::O_OPEN_ALWAYS, bench_db_path);
+		db.set_write_ahead_log();  // as with --sqlite-wal
+		benchmark(db, "platform::DB with write-ahead log", keys, out);
+	}
+	platform::DB::delete_db(bench_db_path);
+#endif
+	{
+		platform::DBmemory db(platform::O_CREATE_NEW, bench_db_path, []() {});
+		benchmark(db, "platform::DBmemory", keys, out);
+	}
+}
@@ -0,0 +1,11 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <ostream>
+
+// Runs blockchain-like workload against platform::DB backend selected at compile time, then against DBmemory.
+// Build with and without USE_SQLITE to compare backends
+void benchmark_db(size_t count, std::ostream &out);
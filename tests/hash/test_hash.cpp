@@ -41,9 +41,21 @@ static void slow_hash(const void *data, size_t length, cryptoHash *hash) {
 	invariant(chash == hash2, "");
 }
 
+// Batch of all prefixes of data, so lanes finish at different steps and are refilled
+static void fast_hash_batch(const void *data, size_t length, cryptoHash *hash) {
+	std::vector<std::vector<uint8_t>> datas;
+	for (size_t i = 0; i <= length; ++i)
+		datas.emplace_back(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + i);
+	const std::vector<crypto::Hash> results = crypto::cn_fast_hash_batch(datas);
+	for (size_t i = 0; i <= length; ++i)
+		invariant(results.at(i) == crypto::cn_fast_hash(datas.at(i)), "");
+	*hash = results.back();
+}
+
 typedef std::function<void(const void *, size_t, cryptoHash *)> hash_f;
 
-std::map<std::string, hash_f> hashes{{"fast", &crypto_cn_fast_hash}, {"slow", &slow_hash}, {"tree", &hash_tree},
+std::map<std::string, hash_f> hashes{{"fast", &crypto_cn_fast_hash}, {"fast-batch", &fast_hash_batch},
+    {"slow", &slow_hash}, {"tree", &hash_tree},
     {"extra-blake", &crypto_hash_extra_blake}, {"extra-groestl", &crypto_hash_extra_groestl},
     {"extra-jh", &crypto_hash_extra_jh}, {"extra-skein", &crypto_hash_extra_skein}};
 
@@ -139,6 +151,7 @@ void test_hashes(const std::string &test_vectors_folder) {
 	test_hash("extra-jh", test_vectors_folder + "/tests-extra-jh.txt");
 	test_hash("extra-skein", test_vectors_folder + "/tests-extra-skein.txt");
 	test_hash("fast", test_vectors_folder + "/tests-fast.txt");
+	test_hash("fast-batch", test_vectors_folder + "/tests-fast.txt");
 	test_hash("slow", test_vectors_folder + "/tests-slow.txt");
 	test_hash("tree", test_vectors_folder + "/tests-tree.txt");
 
@@ -172,6 +185,16 @@ void test_hashes(const std::string &test_vectors_folder) {
 		          << std::endl;
 	else
 		std::cout << "Benchmark cn_fast_hash result=" << test_hash << " hashes/sec=inf" << std::endl;
+	std::vector<std::vector<uint8_t>> batch(COUNT / 100, test_hash.as_binary_array());
+	idea_start = std::chrono::high_resolution_clock::now();
+	for (int count = 0; count != 100; ++count) {
+		batch.back() = crypto::cn_fast_hash_batch(batch).back().as_binary_array();
+	}
+	idea_ms =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - idea_start);
+	std::cout << "Benchmark cn_fast_hash_batch result=" << common::to_hex(batch.back())
+	          << " hashes/sec=" << (idea_ms.count() != 0 ? std::to_string(COUNT * 1000 / idea_ms.count()) : "inf")
+	          << std::endl;
 	test_hash  = crypto::Hash{};
 	COUNT      = 100;
 	idea_start = std::chrono::high_resolution_clock::now();
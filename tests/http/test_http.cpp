@@ -0,0 +1,176 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_http.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include "common/Invariant.hpp"
+#include "http/JsonRpc.hpp"
+#include "http/RequestParser.hpp"
+#include "http/ResponseParser.hpp"
+
+static const char typical_request[] =
+    "POST /json_rpc HTTP/1.1\r\n"
+    "Host: 127.0.0.1:58081\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:60.0) Gecko/20100101 Firefox/60.0\r\n"
+    "Accept: application/json, text/plain, */*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Referer: http://127.0.0.1:58081/\r\n"
+    "Content-Type: application/json;charset=utf-8\r\n"
+    "Authorization: Basic dXNlcjpwYXNz  \r\n"
+    "Origin: HTTP://127.0.0.1:58081\r\n"
+    "Content-Length: 69\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char typical_response[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+    "Expires: 0\r\n"
+    "Content-Length: 1234\r\n"
+    "\r\n";
+
+static http::RequestHeader parse_request(const std::string &str, size_t chunk, bool *good) {
+	http::RequestParser parser;
+	http::RequestHeader req;
+	const char *pos = str.data();
+	const char *end = str.data() + str.size();
+	while (pos != end && !parser.is_good() && !parser.is_bad()) {
+		const char *chunk_end = pos + std::min<size_t>(chunk, end - pos);
+		const char *next      = parser.parse(req, pos, chunk_end);
+		invariant(parser.is_good() || parser.is_bad() || next == chunk_end, "Parser must consume whole chunk");
+		pos = next;
+	}
+	*good = parser.is_good();
+	return req;
+}
+
+static void check_request(const std::string &str, size_t chunk) {
+	bool good                     = false;
+	const http::RequestHeader req = parse_request(str, chunk, &good);
+	invariant(good, "");
+	invariant(req.method == "POST" && req.uri == "/json_rpc", "");
+	invariant(req.http_version_major == 1 && req.http_version_minor == 1 && req.keep_alive, "");
+	invariant(req.host == "127.0.0.1:58081" && req.origin == "http://127.0.0.1:58081", "");
+	invariant(req.basic_authorization == "dXNlcjpwYXNz", "");
+	invariant(req.content_length == 69, "");
+	invariant(req.headers.empty(), "Unused headers must not be stored");
+}
+
+static bool is_request_good(const std::string &str) {
+	bool good = false;
+	parse_request(str, str.size(), &good);
+	return good;
+}
+
+static void test_json_rpc_batch() {
+	using namespace cn::json_rpc;
+	invariant(is_batch(" \r\n[]") && !is_batch("{\"id\":1}") && !is_batch(""), "");
+	const BatchHandler handler = [](Request &&req, std::string &body) {
+		body += "partial";  // must be rolled back on throw
+		if (req.get_method() != "echo")
+			throw Error(METHOD_NOT_FOUND);
+		body.resize(body.size() - 7);
+		append_response_body(body, req.get_method(), req.get_id().get(), req.get_numbers_as_strings());
+	};
+	const std::string body = process_batch(
+	    "[{\"jsonrpc\":\"2.0\",\"method\":\"echo\",\"id\":1},"
+	    "{\"jsonrpc\":\"2.0\",\"method\":\"fail\",\"id\":\"b\"},5]",
+	    handler);
+	const auto responses = common::JsonValue::from_string(body);
+	invariant(responses.is_array() && responses.size() == 3, "");
+	invariant(responses[0]("result").get_string() == "echo" && responses[0]("id").get_integer() == 1, "");
+	invariant(responses[1]("error")("code").get_integer() == METHOD_NOT_FOUND, "");
+	invariant(responses[1]("id").get_string() == "b", "");
+	invariant(responses[2]("error")("code").get_integer() == INVALID_REQUEST && responses[2]("id").is_nil(), "");
+	for (const char *bad : {"[]", "[1", "{}"}) {
+		bool thrown = false;
+		try {
+			process_batch(bad, handler);
+		} catch (const Error &) {
+			thrown = true;
+		}
+		invariant(thrown, "Malformed batch must be answered with single error");
+	}
+}
+
+static void test_line_limit() {
+	const size_t max_value = http::LineReader::MAX_LINE_SIZE - std::strlen("X-Long: ");
+	for (size_t chunk : {size_t(1), size_t(1000), size_t(100000)}) {
+		bool good = false;
+		parse_request("GET / HTTP/1.1\r\nX-Long: " + std::string(max_value, 'a') + "\r\n\r\n", chunk, &good);
+		invariant(good, "Line of max size must be accepted");
+		parse_request("GET / HTTP/1.1\r\nX-Long: " + std::string(max_value + 1, 'a') + "\r\n\r\n", chunk, &good);
+		invariant(!good, "Too long line must be bad");
+	}
+	// Peer never sending CRLF is rejected after max line size, not buffered forever
+	http::RequestParser parser;
+	http::RequestHeader req;
+	const std::string chunk(1000, 'a');
+	size_t fed = 0;
+	while (!parser.is_bad()) {
+		invariant(!parser.is_good() && fed <= http::LineReader::MAX_LINE_SIZE, "Endless line must become bad");
+		parser.parse(req, chunk.data(), chunk.data() + chunk.size());
+		fed += chunk.size();
+	}
+}
+
+void test_http() {
+	test_json_rpc_batch();
+	for (size_t chunk = 1; chunk <= sizeof(typical_request); ++chunk)
+		check_request(typical_request, chunk);
+
+	invariant(is_request_good("GET / HTTP/1.0\r\n\r\n"), "");
+	invariant(is_request_good("GET / HTTP/1.1\r\nX-Long: a\r\n  continuation\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\r\n  continuation\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\r\nHost: a\rb\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\r\nHo(st: a\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\r\nContent-Length: -1\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.1\r\nConnection: maybe\r\n\r\n"), "");
+	invariant(!is_request_good("GET / HTTP/1.\r\n\r\n"), "");
+	invariant(!is_request_good("GET /a\tb HTTP/1.1\r\n\r\n"), "");
+	invariant(!is_request_good("G(T / HTTP/1.1\r\n\r\n"), "");
+	{
+		bool good = false;
+		auto req  = parse_request("GET / HTTP/1.1\r\nconnection: Close\r\n\r\n", 3, &good);
+		invariant(good && !req.keep_alive, "");
+	}
+	test_line_limit();
+	for (size_t chunk = 1; chunk <= sizeof(typical_response); ++chunk) {
+		http::ResponseParser parser;
+		http::ResponseHeader resp;
+		const char *pos = typical_response;
+		const char *end = typical_response + sizeof(typical_response) - 1;
+		while (pos != end && !parser.is_good() && !parser.is_bad())
+			pos = parser.parse(resp, pos, pos + std::min<size_t>(chunk, end - pos));
+		invariant(parser.is_good() && pos == end, "");
+		invariant(resp.status == 200 && resp.status_text == "OK" && resp.content_length == 1234, "");
+		invariant(resp.keep_alive && resp.headers.empty(), "");
+	}
+}
+
+void benchmark_http_parser(size_t count, std::ostream &out) {
+	const size_t size = sizeof(typical_request) - 1;
+	size_t checksum   = 0;
+	http::RequestParser parser;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i != count; ++i) {
+		http::RequestHeader req;
+		parser.reset();
+		parser.parse(req, typical_request, typical_request + size);
+		checksum += req.content_length;
+	}
+	auto finish = std::chrono::high_resolution_clock::now();
+	invariant(checksum == count * 69, "");
+	auto microsec = std::max<long long>(
+	    1, std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+	out << "http::RequestParser: " << count << " requests of " << size << " bytes in " << microsec << " us, "
+	    << (count * 1000000 / microsec) << " req/s, " << (count * size / microsec) << " MB/s" << std::endl;
+}
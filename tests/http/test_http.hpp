@@ -0,0 +1,10 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <ostream>
+
+void test_http();
+void benchmark_http_parser(size_t count, std::ostream &out);
@@ -0,0 +1,244 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_http_stream.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "common/JsonValue.hpp"
+#include "common/StringTools.hpp"
+#include "http/JsonRpc.hpp"
+#include "http/ResponseParser.hpp"
+#include "http/Server.hpp"
+#include "platform/Network.hpp"
+#include "rpc_api.hpp"
+
+using namespace cn;
+
+namespace {
+
+// Reads subscription as raw bytes and checks framing, like a notification service would
+class StreamReader {
+public:
+	explicit StreamReader(uint16_t port, bool reading = true, size_t junk_size = 0)
+	    : reading(reading)
+	    , junk_left(junk_size)
+	    , sock([this](bool, bool) { advance(); }, [this]() { disconnected = true; }) {
+		invariant(sock.connect("127.0.0.1", port), "");
+		const std::string request = "GET " + api::cnd::Subscribe::url() + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+		invariant(sock.write_some(request.data(), request.size()) == request.size(), "");
+	}
+	void close() { sock.close(); }
+
+	std::vector<std::string> lines;  // payloads of chunks
+	bool disconnected = false;
+
+private:
+	const bool reading;
+	size_t junk_left;  // sent after first line, then we shutdown, server must not stop reading
+	platform::TCPSocket sock;
+	std::string data;
+	bool header_received = false;
+
+	void advance() {
+		if (!reading)
+			return;
+		char buf[4096];
+		while (const size_t rc = sock.read_some(buf, sizeof(buf)))
+			data.append(buf, rc);
+		parse();
+		const std::string junk(4096, 'x');
+		while (junk_left != 0 && !lines.empty()) {
+			const size_t wc = sock.write_some(junk.data(), std::min(junk.size(), junk_left));
+			if (wc == 0)
+				break;
+			junk_left -= wc;
+			if (junk_left == 0)
+				sock.shutdown_both();
+		}
+	}
+	void parse() {
+		if (!header_received) {
+			const size_t header_end = data.find("\r\n\r\n");
+			if (header_end == std::string::npos)
+				return;
+			const std::string header = data.substr(0, header_end + 4);
+			http::ResponseParser parser;
+			http::ResponseHeader response;
+			parser.parse(response, header.data(), header.data() + header.size());
+			invariant(parser.is_good() && response.status == 200 && response.keep_alive, "");
+			invariant(!response.has_content_length(), "Stream must not have Content-Length");
+			invariant(header.find("\r\nTransfer-Encoding: chunked\r\n") != std::string::npos, "");
+			data.erase(0, header_end + 4);
+			header_received = true;
+		}
+		while (true) {  // hex size, CRLF, data, CRLF
+			const size_t size_end = data.find("\r\n");
+			if (size_end == std::string::npos)
+				return;
+			const size_t size = std::stoull(data.substr(0, size_end), nullptr, 16);
+			invariant(size != 0, "Last chunk must never be sent");
+			if (data.size() < size_end + 2 + size + 2)
+				return;
+			invariant(data.compare(size_end + 2 + size, 2, "\r\n") == 0, "Chunk must end with CRLF");
+			const std::string line = data.substr(size_end + 2, size);
+			invariant(line.find('\n') == line.size() - 1, "Chunk must contain single line");
+			lines.push_back(line);
+			data.erase(0, size_end + 2 + size + 2);
+		}
+	}
+};
+
+// Plays the role of Node, tip and pool changes are sent as on_change notifications
+class StreamServer {
+public:
+	explicit StreamServer(uint16_t port)
+	    : server(std::make_unique<http::Server>("127.0.0.1", port,
+	          std::bind(&StreamServer::on_request, this, std::placeholders::_1, std::placeholders::_2,
+	              std::placeholders::_3),
+	          std::bind(&StreamServer::on_disconnect, this, std::placeholders::_1))) {
+		state.added_transactions = {hash(101), hash(102)};
+	}
+	void add_block() {
+		state.top_block_height += 1;
+		state.top_block_hash = hash(state.top_block_height);
+		state.transaction_pool_version += 1;
+		state.added_transactions.clear();
+		state.removed_transactions = {hash(101)};  // included in block
+		subscribers.broadcast(notification_body(false));
+	}
+	void add_transaction(uint8_t id) {
+		state.transaction_pool_version += 1;
+		state.added_transactions = {hash(id)};
+		state.removed_transactions.clear();
+		subscribers.broadcast(notification_body(false));
+	}
+	void broadcast(const std::string &line) { subscribers.broadcast(line); }
+
+	http::StreamGroup subscribers;
+	size_t disconnected_count = 0;
+
+private:
+	std::unique_ptr<http::Server> server;
+	api::cnd::Subscribe::Notification state;
+
+	static Hash hash(size_t id) {
+		Hash result;
+		result.data[0] = static_cast<uint8_t>(id);
+		return result;
+	}
+	std::string notification_body(bool whole_pool) {
+		api::cnd::Subscribe::Notification notification = state;
+		if (whole_pool) {
+			notification.added_transactions   = {hash(102)};
+			notification.removed_transactions = {};
+			notification.removed_all          = true;
+		}
+		return json_rpc::create_notification_body(api::cnd::Subscribe::notification_method(), notification);
+	}
+	bool on_request(http::Client *who, http::RequestBody &&request, http::ResponseBody &response) {
+		if (request.r.uri != api::cnd::Subscribe::url()) {
+			response.r.status = 404;
+			return true;
+		}
+		response.r.status = 200;
+		response.r.add_headers_nocache();
+		response.r.headers.push_back({"Content-Type", "application/json; charset=utf-8"});
+		subscribers.start(who, std::move(response.r), notification_body(true));
+		return false;
+	}
+	void on_disconnect(http::Client *who) {
+		disconnected_count += 1;
+		subscribers.erase(who);
+	}
+};
+
+void run_until(boost::asio::io_service &io, const std::function<bool()> &done) {
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+	while (!done()) {
+		invariant(std::chrono::steady_clock::now() < deadline, "Timeout waiting for stream");
+		if (io.poll() == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+api::cnd::Subscribe::Notification parse_notification(const std::string &line) {
+	const auto js = common::JsonValue::from_string(line);
+	invariant(js("jsonrpc").get_string() == "2.0" && !js.contains("id"), "Notification must not have id");
+	invariant(js("method").get_string() == api::cnd::Subscribe::notification_method(), "");
+	api::cnd::Subscribe::Notification result;
+	seria::from_json_value(result, js("params"));
+	return result;
+}
+
+std::unique_ptr<StreamServer> start_server(uint16_t *port) {
+	for (*port = 18950; *port != 18990; ++*port)
+		try {
+			return std::make_unique<StreamServer>(*port);
+		} catch (const platform::TCPAcceptor::AddressInUse &) {
+		}
+	throw std::runtime_error("No free port for test_http_stream");
+}
+
+}  // anonymous namespace
+
+void test_http_stream() {
+	boost::asio::io_service io;
+	platform::EventLoop run_loop(io);
+	uint16_t port       = 0;
+	const auto server   = start_server(&port);
+	const size_t big    = 64 * 1024;
+	const auto big_line = std::string(big, 'b');
+
+	StreamReader a(port);
+	StreamReader b(port);
+	run_until(io, [&] { return a.lines.size() == 1 && b.lines.size() == 1; });
+	invariant(server->subscribers.size() == 2, "");
+	const auto first = parse_notification(a.lines.at(0));
+	invariant(first.removed_all && first.added_transactions.size() == 1, "First notification must have whole pool");
+
+	server->add_block();
+	server->add_transaction(103);
+	run_until(io, [&] { return a.lines.size() == 3 && b.lines.size() == 3; });
+	invariant(a.lines == b.lines, "All subscribers must get the same notifications");
+	const auto tip = parse_notification(a.lines.at(1));
+	invariant(tip.top_block_height == 1 && tip.top_block_hash.data[0] == 1 && !tip.removed_all, "");
+	invariant(tip.removed_transactions.size() == 1 && tip.added_transactions.empty(), "");
+	const auto pool = parse_notification(a.lines.at(2));
+	invariant(pool.top_block_height == 1 && pool.transaction_pool_version == tip.transaction_pool_version + 1, "");
+	invariant(pool.added_transactions.size() == 1 && pool.added_transactions.at(0).data[0] == 103, "");
+
+	// Disconnected subscriber is forgotten, others continue to receive
+	b.close();
+	run_until(io, [&] { return server->disconnected_count == 1; });
+	invariant(server->subscribers.size() == 1, "");
+	server->add_transaction(104);
+	run_until(io, [&] { return a.lines.size() == 4; });
+
+	// Subscriber sending more than socket buffers after request, then closing, must be noticed without broadcasts
+	StreamReader c(port, true, 256 * 1024);
+	run_until(io, [&] { return c.lines.size() == 1; });
+	run_until(io, [&] { return server->disconnected_count == 2; });
+	invariant(server->subscribers.size() == 1, "");
+
+	// Subscriber which does not read is dropped when its queue grows too big, others are not affected
+	StreamReader d(port, false);
+	run_until(io, [&] { return server->subscribers.size() == 2; });
+	for (size_t i = 0; server->subscribers.size() == 2; ++i) {
+		invariant(i != 10000, "Slow subscriber must be dropped");
+		a.lines.clear();
+		server->broadcast(big_line);
+		run_until(io, [&] { return a.lines.size() == 1; });
+		invariant(a.lines.at(0).size() == big + 1, "");
+	}
+	invariant(server->disconnected_count == 3 && !a.disconnected, "");
+	server->add_transaction(105);
+	run_until(io, [&] { return a.lines.size() == 2; });
+	invariant(parse_notification(a.lines.at(1)).added_transactions.at(0).data[0] == 105, "");
+}
@@ -0,0 +1,9 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+// Subscription stream over real sockets - chunked framing, delivery of tip and pool changes to every
+// subscriber, cleanup after subscriber disconnects, slow subscriber is dropped
+void test_http_stream();
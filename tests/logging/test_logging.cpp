@@ -0,0 +1,106 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_logging.hpp"
+
+#include <thread>
+#include <vector>
+#include "common/Invariant.hpp"
+#include "common/StringTools.hpp"
+#include "logging/FileLogger.hpp"
+#include "logging/RecordQueue.hpp"
+#include "platform/PathTools.hpp"
+
+static std::string make_record(size_t producer, size_t index) {
+	return common::to_string(producer) + " " + common::to_string(index) + "\n";
+}
+
+// Checks record against expected next index of its producer, indexes can be skipped only if allow_gaps
+static void check_record(const std::string &record, std::vector<size_t> &next_index, bool allow_gaps) {
+	const size_t space = record.find(' ');
+	invariant(space != std::string::npos && !record.empty() && record.back() == '\n', "Corrupted record " + record);
+	const size_t producer = std::stoull(record.substr(0, space));
+	const size_t index    = std::stoull(record.substr(space + 1));
+	invariant(producer < next_index.size(), "Corrupted record " + record);
+	invariant(index == next_index[producer] || (allow_gaps && index > next_index[producer]),
+	    "Record lost or reordered " + record + " expected index " + common::to_string(next_index[producer]));
+	next_index[producer] = index + 1;
+}
+
+static void test_record_queue(size_t producers, size_t count, size_t capacity) {
+	logging::RecordQueue queue(capacity);
+	std::vector<std::thread> threads;
+	for (size_t p = 0; p != producers; ++p)
+		threads.emplace_back([&queue, p, count]() {
+			for (size_t i = 0; i != count; ++i) {
+				std::string record = make_record(p, i);
+				while (!queue.try_push(std::move(record)))  // record is moved only on success
+					std::this_thread::yield();
+			}
+		});
+	std::vector<size_t> next_index(producers);
+	std::string record;
+	for (size_t received = 0; received != producers * count;)
+		if (queue.try_pop(record)) {
+			check_record(record, next_index, false);
+			received += 1;
+		} else
+			std::this_thread::yield();
+	for (auto &&th : threads)
+		th.join();
+	invariant(queue.empty() && !queue.try_pop(record), "Queue must be empty after all records popped");
+	for (size_t p = 0; p != producers; ++p)
+		invariant(next_index[p] == count, "");
+}
+
+static void test_shutdown_drain(const std::string &path, logging::AsyncMode async_mode, size_t producers,
+    size_t count, size_t queue_size) {
+	platform::remove_file(path + ".log");
+	size_t dropped = 0;
+	{
+		logging::FileLogger logger(path, 1024 * 1024 * 1024, logging::TRACE, async_mode, queue_size);
+		logger.set_pattern(std::string{});
+		std::vector<std::thread> threads;
+		for (size_t p = 0; p != producers; ++p)
+			threads.emplace_back([&logger, p, count]() {
+				for (size_t i = 0; i != count; ++i)
+					logger.write("test", logging::INFO, 0, make_record(p, i));
+			});
+		for (auto &&th : threads)
+			th.join();
+		dropped = logger.get_dropped_count();
+	}  // Destructor must write everything still in queue
+	std::string content;
+	invariant(platform::load_file(path + ".log", content), "");
+	platform::remove_file(path + ".log");
+	const std::string overflow_prefix = "Log queue overflow, dropped ";
+	std::vector<size_t> next_index(producers);
+	size_t written = 0, reported_dropped = 0;
+	for (size_t pos = 0; pos != content.size();) {
+		const size_t end = content.find('\n', pos);
+		invariant(end != std::string::npos, "Last record not finished");
+		const std::string record = content.substr(pos, end + 1 - pos);
+		pos                      = end + 1;
+		if (record.compare(0, overflow_prefix.size(), overflow_prefix) == 0) {
+			reported_dropped += std::stoull(record.substr(overflow_prefix.size()));
+			continue;
+		}
+		check_record(record, next_index, async_mode == logging::ASYNC_DROP);
+		written += 1;
+	}
+	invariant(reported_dropped == dropped && written + dropped == producers * count,
+	    "Records lost on shutdown, written=" + common::to_string(written) + " dropped=" + common::to_string(dropped));
+	invariant(async_mode == logging::ASYNC_DROP || dropped == 0, "");
+}
+
+void test_logging(const std::string &scratchpad_folder, size_t iterations) {
+	const size_t producers = std::max<size_t>(4, std::thread::hardware_concurrency());
+	test_record_queue(producers, 100000, 16);  // small queue wraps around many times and is often full
+	test_record_queue(1, 100000, 1);
+	const std::string path = scratchpad_folder + "/test_logging";
+	for (size_t i = 0; i != iterations; ++i) {
+		test_shutdown_drain(path, logging::ASYNC_BLOCK, producers, 2000, 64);
+		test_shutdown_drain(path, logging::ASYNC_DROP, producers, 2000, 64);
+	}
+}
@@ -0,0 +1,11 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <string>
+
+// Many producers push into small RecordQueue, consumer checks that no record is lost and order of each producer
+// is kept. Async FileLogger destroyed right after producers finish must have written every record
+void test_logging(const std::string &scratchpad_folder, size_t iterations);
@@ -0,0 +1,110 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "benchmark_mempool.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "../Random.hpp"
+#include "Core/MemPool.hpp"
+#include "common/Invariant.hpp"
+#include "crypto/hash.hpp"
+
+using namespace cn;
+
+static const size_t BLOCK_SIZE = 1024 * 1024;
+
+static void measure(std::ostream &out, const char *name, size_t count, const std::function<void()> &fun) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	fun();
+	const auto finish = std::chrono::high_resolution_clock::now();
+	const auto microsec =
+	    std::max<long long>(1, std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count());
+	out << "    " << name << ": " << count << " ops in " << microsec << " us, " << (count * 1000000 / microsec)
+	    << " ops/s" << std::endl;
+}
+
+struct BenchTransaction {
+	Hash tid;
+	Transaction tx;
+	BinaryArray binary_tx;
+	Amount fee = 0;
+};
+
+static std::vector<BenchTransaction> make_transactions(size_t count, size_t *total_size) {
+	common::Random random(count);  // prepared in advance, so we measure pool only
+	std::vector<BenchTransaction> result(count);
+	for (size_t i = 0; i != count; ++i) {
+		auto &btx = result[i];
+		btx.tid   = crypto::cn_fast_hash(&i, sizeof(i));
+		InputKey input;
+		const Hash ki = crypto::cn_fast_hash(btx.tid.data, sizeof(btx.tid.data));
+		memcpy(input.key_image.data, ki.data, sizeof(ki.data));  // need not be valid point
+		btx.tx.inputs.push_back(input);
+		btx.binary_tx.resize(300 + random() % 3000);
+		btx.fee = btx.binary_tx.size() * (10 + random() % 1000);
+		*total_size += btx.binary_tx.size();
+	}
+	return result;
+}
+
+static MemPool::PoolTransaction to_pool(const BenchTransaction &btx) {
+	return MemPool::PoolTransaction{btx.tx, btx.binary_tx, btx.fee, 0, Hash{}};
+}
+
+void benchmark_mempool(size_t count, std::ostream &out) {
+	size_t total_size = 0;
+	const auto txs    = make_transactions(count, &total_size);
+	MemPool pool(total_size / 2);
+	out << "MemPool benchmark, " << count << " transactions, max pool size " << total_size / 2 << std::endl;
+	size_t evicted = 0;
+	measure(out, "insert with eviction", count, [&]() {
+		for (const auto &btx : txs) {
+			pool.insert(btx.tid, to_pool(btx));
+			Hash rhash;
+			while (pool.get_eviction_candidate(&rhash)) {
+				pool.erase(rhash);
+				evicted += 1;
+			}
+		}
+	});
+	invariant(evicted != 0 && pool.get_total_size() <= total_size / 2 + 3300, "");
+	measure(out, "select for block, cached", count, [&]() {
+		for (size_t i = 0; i != count; ++i)
+			invariant(!pool.select_for_block(BLOCK_SIZE).empty(), "");
+	});
+	const size_t uncached_count = std::max<size_t>(1, count / 100);
+	measure(out, "select for block, uncached", uncached_count, [&]() {
+		for (size_t i = 0; i != uncached_count; ++i)  // different size invalidates cache
+			invariant(!pool.select_for_block(BLOCK_SIZE - i % 2).empty(), "");
+	});
+	// Block takes the best transactions, then the same number of transactions arrive, then miners ask for template
+	const size_t rounds = std::max<size_t>(1, count / 100);
+	size_t cursor       = 0;
+	measure(out, "block, refill, select", rounds, [&]() {
+		for (size_t i = 0; i != rounds; ++i) {
+			const std::vector<Hash> selected = pool.select_for_block(BLOCK_SIZE);
+			for (const auto &tid : selected)
+				pool.erase(tid);
+			for (size_t added = 0; added != selected.size(); cursor = (cursor + 1) % count) {
+				const auto &btx = txs[cursor];
+				if (pool.find(btx.tid))
+					continue;
+				pool.insert(btx.tid, to_pool(btx));
+				added += 1;
+				Hash rhash;
+				while (pool.get_eviction_candidate(&rhash))
+					pool.erase(rhash);
+			}
+		}
+	});
+	const size_t remaining = pool.get_transactions().size();
+	measure(out, "erase", remaining, [&]() {
+		for (const auto &btx : txs)
+			pool.erase(btx.tid);
+	});
+	invariant(pool.get_transactions().empty() && pool.get_total_size() == 0, "");
+}
@@ -0,0 +1,10 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+#include <ostream>
+
+// Pool churn with count synthetic transactions, pool max size is half of their total size, so eviction is constant
+void benchmark_mempool(size_t count, std::ostream &out);
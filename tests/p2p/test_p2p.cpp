@@ -0,0 +1,50 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#include "test_p2p.hpp"
+
+#include "common/Invariant.hpp"
+#include "p2p/LevinProtocol.hpp"
+#include "p2p/P2pProtocolDefinitions.hpp"
+
+using namespace cn;
+
+static Hash make_hash(uint8_t b) {
+	Hash result;
+	result.data[0] = b;
+	return result;
+}
+
+static std::string error_after_transfer(const p2p::GetObjects::Response &msg) {
+	p2p::GetObjects::Response received;
+	invariant(LevinProtocol::decode(LevinProtocol::encode(msg), received), "GetObjects::Response failed to decode");
+	invariant(received.over_budget_ids == msg.over_budget_ids && received.missed_ids == msg.missed_ids,
+	    "GetObjects::Response ids changed during transfer");
+	return received.get_error();
+}
+
+static void test_get_objects_response() {
+	p2p::GetObjects::Response msg;
+	invariant(error_after_transfer(msg).empty(), "Empty response must be accepted");
+
+	// Responder always sends first object, so response with only over budget ids is malicious
+	msg.over_budget_ids.push_back(make_hash(1));
+	msg.over_budget_ids.push_back(make_hash(2));
+	invariant(!error_after_transfer(msg).empty(), "Over budget ids without any object must be rejected");
+
+	msg.missed_ids.push_back(make_hash(3));
+	invariant(error_after_transfer(msg).empty(), "Missed id with over budget ids must be accepted");
+
+	msg.missed_ids.clear();
+	msg.txs.push_back(BinaryArray(100, 0x42));
+	invariant(error_after_transfer(msg).empty(), "Transaction with over budget ids must be accepted");
+
+	msg.txs.clear();
+	msg.over_budget_ids.clear();
+	for (size_t i = 0; i != p2p::GetObjects::Request::MAX_BATCH_COUNT + 1; ++i)
+		msg.missed_ids.push_back(make_hash(static_cast<uint8_t>(i)));
+	invariant(!error_after_transfer(msg).empty(), "More than MAX_BATCH_COUNT objects must be rejected");
+}
+
+void test_p2p() { test_get_objects_response(); }
@@ -0,0 +1,8 @@
+// Copyright (c) 2012-2018, The CryptoNote developers, The Bytecoin developers.
+// Licensed under the GNU Lesser General Public License. See LICENSE for
+// details.
+
+#pragma once
+
+// Malformed GetObjects responses are rejected after passing through levin encoding
+void test_p2p();